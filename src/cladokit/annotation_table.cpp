@@ -0,0 +1,266 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/annotation_table.hpp"
+
+#include <any>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using cladokit::AnnotationTable;
+using std::string;
+using std::vector;
+
+void AnnotationTable::Resize(size_t rowCount) {
+    rowCount_ = rowCount;
+    for (auto &column : columns_) {
+        ResizeColumn(column, rowCount);
+    }
+}
+
+void AnnotationTable::Remap(const vector<size_t> &previousRows) {
+    for (auto &column : columns_) {
+        Column remapped;
+        remapped.type = column.type;
+        ResizeColumn(remapped, previousRows.size());
+        for (size_t row = 0; row < previousRows.size(); row++) {
+            size_t previous = previousRows[row];
+            if (previous == kNoRow || previous >= rowCount_ ||
+                !column.present[previous]) {
+                continue;
+            }
+            remapped.present[row] = true;
+            remapped.count++;
+            switch (column.type) {
+                case ColumnType::kDouble:
+                    remapped.doubles[row] = column.doubles[previous];
+                    break;
+                case ColumnType::kInt:
+                case ColumnType::kInt64:
+                    remapped.integers[row] = column.integers[previous];
+                    break;
+                case ColumnType::kString:
+                    remapped.strings[row] = std::move(column.strings[previous]);
+                    break;
+                case ColumnType::kDoubleVector:
+                    remapped.doubleVectors[row] =
+                        std::move(column.doubleVectors[previous]);
+                    break;
+                case ColumnType::kAny:
+                    remapped.values[row] = std::move(column.values[previous]);
+                    break;
+            }
+        }
+        column = std::move(remapped);
+    }
+    rowCount_ = previousRows.size();
+}
+
+void AnnotationTable::MoveRow(size_t from, size_t to) {
+    for (KeyId key = 0; key < columns_.size(); key++) {
+        Column &column = columns_[key];
+        if (column.present[from]) {
+            Set(key, to, GetValue(column, from));
+            Remove(key, from);
+        } else if (column.present[to]) {
+            Remove(key, to);
+        }
+    }
+}
+
+void AnnotationTable::ClearRow(size_t row) {
+    for (KeyId key = 0; key < columns_.size(); key++) {
+        Remove(key, row);
+    }
+}
+
+AnnotationTable::KeyId AnnotationTable::Intern(const string &key) {
+    auto it = keyIds_.find(key);
+    if (it != keyIds_.end()) {
+        return it->second;
+    }
+    KeyId id = keys_.size();
+    keys_.push_back(key);
+    keyIds_[key] = id;
+    columns_.emplace_back();
+    ResizeColumn(columns_.back(), rowCount_);
+    return id;
+}
+
+AnnotationTable::KeyId AnnotationTable::Find(const string &key) const {
+    auto it = keyIds_.find(key);
+    return it == keyIds_.end() ? kNoKey : it->second;
+}
+
+vector<string> AnnotationTable::Keys(size_t row) const {
+    vector<string> keys;
+    for (KeyId key = 0; key < columns_.size(); key++) {
+        if (columns_[key].present[row]) {
+            keys.push_back(keys_[key]);
+        }
+    }
+    return keys;
+}
+
+void AnnotationTable::Set(KeyId key, size_t row, const std::any &value) {
+    Column &column = columns_.at(key);
+    ColumnType type = TypeOf(value);
+    if (column.type != type) {
+        if (column.count == 0) {
+            column = Column();
+            column.type = type;
+            ResizeColumn(column, rowCount_);
+        } else {
+            ConvertToAny(column);
+        }
+    }
+    if (!column.present[row]) {
+        column.present[row] = true;
+        column.count++;
+    }
+    switch (column.type) {
+        case ColumnType::kDouble:
+            column.doubles[row] = std::any_cast<double>(value);
+            break;
+        case ColumnType::kInt:
+            column.integers[row] = std::any_cast<int>(value);
+            break;
+        case ColumnType::kInt64:
+            column.integers[row] = std::any_cast<int64_t>(value);
+            break;
+        case ColumnType::kString:
+            column.strings[row] = std::any_cast<const string &>(value);
+            break;
+        case ColumnType::kDoubleVector:
+            column.doubleVectors[row] = std::any_cast<const vector<double> &>(value);
+            break;
+        case ColumnType::kAny:
+            column.values[row] = value;
+            break;
+    }
+}
+
+void AnnotationTable::Remove(KeyId key, size_t row) {
+    Column &column = columns_.at(key);
+    if (!column.present[row]) return;
+    column.present[row] = false;
+    column.count--;
+    switch (column.type) {
+        case ColumnType::kString:
+            string().swap(column.strings[row]);
+            break;
+        case ColumnType::kDoubleVector:
+            vector<double>().swap(column.doubleVectors[row]);
+            break;
+        case ColumnType::kAny:
+            column.values[row].reset();
+            break;
+        default:
+            break;
+    }
+}
+
+void AnnotationTable::Remove(const string &key, size_t row) {
+    KeyId id = Find(key);
+    if (id != kNoKey) {
+        Remove(id, row);
+    }
+}
+
+std::any AnnotationTable::Get(KeyId key, size_t row) const {
+    const Column &column = columns_.at(key);
+    if (!column.present[row]) {
+        throw std::out_of_range("Key not found: " + keys_[key]);
+    }
+    return GetValue(column, row);
+}
+
+const vector<int64_t> &AnnotationTable::IntegerColumn(KeyId key) const {
+    const Column &column = columns_.at(key);
+    if (column.type != ColumnType::kInt && column.type != ColumnType::kInt64) {
+        throw std::runtime_error("Type mismatch for key: " + keys_[key]);
+    }
+    return column.integers;
+}
+
+AnnotationTable::ColumnType AnnotationTable::TypeOf(const std::any &value) {
+    const auto &type = value.type();
+    if (type == typeid(double)) return ColumnType::kDouble;
+    if (type == typeid(int)) return ColumnType::kInt;
+    if (type == typeid(int64_t)) return ColumnType::kInt64;
+    if (type == typeid(string)) return ColumnType::kString;
+    if (type == typeid(vector<double>)) return ColumnType::kDoubleVector;
+    return ColumnType::kAny;
+}
+
+std::any AnnotationTable::GetValue(const Column &column, size_t row) {
+    switch (column.type) {
+        case ColumnType::kDouble:
+            return column.doubles[row];
+        case ColumnType::kInt:
+            return static_cast<int>(column.integers[row]);
+        case ColumnType::kInt64:
+            return column.integers[row];
+        case ColumnType::kString:
+            return column.strings[row];
+        case ColumnType::kDoubleVector:
+            return column.doubleVectors[row];
+        default:
+            return column.values[row];
+    }
+}
+
+void AnnotationTable::ResizeColumn(Column &column, size_t rowCount) {
+    column.present.resize(rowCount, false);
+    switch (column.type) {
+        case ColumnType::kDouble:
+            column.doubles.resize(rowCount);
+            break;
+        case ColumnType::kInt:
+        case ColumnType::kInt64:
+            column.integers.resize(rowCount);
+            break;
+        case ColumnType::kString:
+            column.strings.resize(rowCount);
+            break;
+        case ColumnType::kDoubleVector:
+            column.doubleVectors.resize(rowCount);
+            break;
+        case ColumnType::kAny:
+            column.values.resize(rowCount);
+            break;
+    }
+}
+
+void AnnotationTable::ConvertToAny(Column &column) {
+    Column converted;
+    converted.count = column.count;
+    converted.present = std::move(column.present);
+    converted.values.resize(converted.present.size());
+    for (size_t row = 0; row < converted.present.size(); row++) {
+        if (converted.present[row]) {
+            converted.values[row] = GetValue(column, row);
+        }
+    }
+    column = std::move(converted);
+}
+
+AnnotationTable::KeyId AnnotationTable::CheckedFind(const string &key, size_t row) const {
+    KeyId id = Find(key);
+    if (id == kNoKey || !columns_[id].present[row]) {
+        throw std::out_of_range("Key not found: " + key);
+    }
+    return id;
+}
+
+const AnnotationTable::Column &AnnotationTable::CheckedColumn(KeyId key,
+                                                              ColumnType type) const {
+    const Column &column = columns_.at(key);
+    if (column.type != type) {
+        throw std::runtime_error("Type mismatch for key: " + keys_[key]);
+    }
+    return column;
+}
@@ -0,0 +1,149 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <any>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace cladokit {
+
+// Annotations of every node of a tree stored in typed columns indexed by node id.
+// Keys are interned so that columns can be accessed by integer id. The type of a
+// column is given by the first value stored in it. A column storing values of
+// different types falls back to std::any.
+class AnnotationTable {
+   public:
+    using KeyId = size_t;
+
+    enum class ColumnType { kDouble, kInt, kInt64, kString, kDoubleVector, kAny };
+
+    static constexpr KeyId kNoKey = std::numeric_limits<KeyId>::max();
+
+    static constexpr size_t kNoRow = std::numeric_limits<size_t>::max();
+
+    explicit AnnotationTable(size_t rowCount = 0) : rowCount_(rowCount) {}
+
+    size_t RowCount() const { return rowCount_; }
+
+    void Resize(size_t rowCount);
+
+    // Rebuild the table so that row i contains the values of row previousRows[i] or
+    // no value if previousRows[i] is kNoRow.
+    void Remap(const std::vector<size_t> &previousRows);
+
+    void MoveRow(size_t from, size_t to);
+
+    // Remove every value of row.
+    void ClearRow(size_t row);
+
+    KeyId Intern(const std::string &key);
+
+    KeyId Find(const std::string &key) const;
+
+    const std::string &Key(KeyId key) const { return keys_.at(key); }
+
+    size_t KeyCount() const { return keys_.size(); }
+
+    ColumnType Type(KeyId key) const { return columns_.at(key).type; }
+
+    bool Contains(KeyId key, size_t row) const { return columns_.at(key).present[row]; }
+
+    bool Contains(const std::string &key, size_t row) const {
+        KeyId id = Find(key);
+        return id != kNoKey && Contains(id, row);
+    }
+
+    // Keys with a value in row.
+    std::vector<std::string> Keys(size_t row) const;
+
+    void Set(KeyId key, size_t row, const std::any &value);
+
+    void Set(const std::string &key, size_t row, const std::any &value) {
+        Set(Intern(key), row, value);
+    }
+
+    void Remove(KeyId key, size_t row);
+
+    void Remove(const std::string &key, size_t row);
+
+    std::any Get(KeyId key, size_t row) const;
+
+    std::any Get(const std::string &key, size_t row) const {
+        return Get(CheckedFind(key, row), row);
+    }
+
+    template <typename T>
+    T Get(const std::string &key, size_t row) const {
+        const Column &column = columns_[CheckedFind(key, row)];
+        if constexpr (std::is_same_v<T, double>) {
+            if (column.type == ColumnType::kDouble) return column.doubles[row];
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            if (column.type == ColumnType::kString) return column.strings[row];
+        } else if constexpr (std::is_same_v<T, std::vector<double>>) {
+            if (column.type == ColumnType::kDoubleVector) {
+                return column.doubleVectors[row];
+            }
+        }
+        try {
+            return std::any_cast<T>(GetValue(column, row));
+        } catch (const std::bad_any_cast &) {
+            throw std::runtime_error("Type mismatch for key: " + key);
+        }
+    }
+
+    // Contiguous columns indexed by node id. Rows without a value must be masked
+    // with Present().
+    const std::vector<bool> &Present(KeyId key) const { return columns_.at(key).present; }
+
+    const std::vector<double> &DoubleColumn(KeyId key) const {
+        return CheckedColumn(key, ColumnType::kDouble).doubles;
+    }
+
+    const std::vector<int64_t> &IntegerColumn(KeyId key) const;
+
+    const std::vector<std::string> &StringColumn(KeyId key) const {
+        return CheckedColumn(key, ColumnType::kString).strings;
+    }
+
+    const std::vector<std::vector<double>> &DoubleVectorColumn(KeyId key) const {
+        return CheckedColumn(key, ColumnType::kDoubleVector).doubleVectors;
+    }
+
+   private:
+    struct Column {
+        ColumnType type = ColumnType::kAny;
+        size_t count = 0;  // number of rows with a value
+        std::vector<bool> present;
+        std::vector<double> doubles;
+        std::vector<int64_t> integers;
+        std::vector<std::string> strings;
+        std::vector<std::vector<double>> doubleVectors;
+        std::vector<std::any> values;
+    };
+
+    size_t rowCount_;
+    std::vector<std::string> keys_;
+    std::unordered_map<std::string, KeyId> keyIds_;
+    std::vector<Column> columns_;
+
+    static ColumnType TypeOf(const std::any &value);
+
+    static std::any GetValue(const Column &column, size_t row);
+
+    static void ResizeColumn(Column &column, size_t rowCount);
+
+    static void ConvertToAny(Column &column);
+
+    KeyId CheckedFind(const std::string &key, size_t row) const;
+
+    const Column &CheckedColumn(KeyId key, ColumnType type) const;
+};
+}  // namespace cladokit
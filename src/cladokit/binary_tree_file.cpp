@@ -0,0 +1,583 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/binary_tree_file.hpp"
+
+#include <algorithm>
+#include <any>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cladokit/parallel.hpp"
+
+using cladokit::AnnotationTable;
+using cladokit::BinaryColumn;
+using cladokit::BinaryTreeFile;
+using cladokit::BinaryTreeFormat;
+using cladokit::BinaryTreeView;
+using cladokit::BinaryTreeWriter;
+using cladokit::NodeArena;
+using cladokit::Tree;
+using std::string;
+using std::vector;
+using ColumnType = cladokit::AnnotationTable::ColumnType;
+
+static_assert(sizeof(BinaryTreeFormat::Header) == 64, "unexpected header padding");
+
+namespace {
+template <typename T>
+void Append(T value, string &out) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+T Load(const char *data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+size_t Padded(size_t size) { return (size + 7) & ~size_t(7); }
+
+void Pad(string &out) { out.resize(Padded(out.size()), '\0'); }
+
+size_t WordCount(size_t bits) { return (bits + 63) / 64; }
+
+// Append the offsets of strings relative to the end of the offsets, then the strings.
+template <typename Offset, typename Strings>
+void AppendStrings(const Strings &strings, string &out) {
+    Offset offset = 0;
+    Append(offset, out);
+    for (const auto &s : strings) {
+        offset += static_cast<Offset>(s.size());
+        Append(offset, out);
+    }
+    for (const auto &s : strings) {
+        out.append(s.data(), s.size());
+    }
+    Pad(out);
+}
+
+bool IsSupported(ColumnType type) {
+    return type == ColumnType::kDouble || type == ColumnType::kInt ||
+           type == ColumnType::kInt64 || type == ColumnType::kString;
+}
+
+void CheckRecord(bool condition) {
+    if (!condition) {
+        throw std::runtime_error("Corrupted tree record in binary tree file");
+    }
+}
+}  // namespace
+
+BinaryTreeWriter::BinaryTreeWriter(const std::filesystem::path &path,
+                                   std::shared_ptr<const TaxonSet> taxa,
+                                   BinaryTreeOptions options)
+    : taxa_(std::move(taxa)), options_(std::move(options)) {
+    if (!taxa_) {
+        throw std::invalid_argument("BinaryTreeWriter requires a taxon set");
+    }
+    for (const auto &column : options_.columns) {
+        if (!IsSupported(column.type)) {
+            throw std::invalid_argument("Unsupported column type for key: " + column.key);
+        }
+    }
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        throw std::runtime_error("Cannot open file: " + path.string());
+    }
+
+    string sections;
+    std::memcpy(header_.magic, BinaryTreeFormat::kMagic, sizeof(header_.magic));
+    header_.version = BinaryTreeFormat::kVersion;
+    header_.byteOrder = BinaryTreeFormat::kByteOrderMark;
+    header_.flags = (options_.singlePrecision ? BinaryTreeFormat::kSinglePrecision : 0) |
+                    (options_.internalNames ? BinaryTreeFormat::kInternalNames : 0);
+    header_.columnCount = static_cast<uint32_t>(options_.columns.size());
+    header_.treeCount = 0;
+    header_.taxonCount = taxa_->Size();
+    header_.taxaOffset = sizeof(header_);
+    header_.offsetsOffset = 0;
+
+    AppendStrings<uint64_t>(*taxa_->Names(), sections);
+    header_.columnsOffset = header_.taxaOffset + sections.size();
+    for (const auto &column : options_.columns) {
+        Append(static_cast<uint8_t>(column.type), sections);
+        Append(static_cast<uint8_t>(column.branch), sections);
+        Append(uint16_t(0), sections);
+        Append(static_cast<uint32_t>(column.key.size()), sections);
+        sections += column.key;
+        Pad(sections);
+    }
+
+    string header;
+    Append(header_, header);
+    WriteBytes(header);
+    WriteBytes(sections);
+}
+
+BinaryTreeWriter::~BinaryTreeWriter() {
+    try {
+        Close();
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+}
+
+void BinaryTreeWriter::Write(const Tree &tree) {
+    CheckOpen();
+    bool sameTaxa = tree.Taxa() == taxa_ || *tree.TaxonNames() == *taxa_->Names();
+
+    // preorder and balanced parentheses of the topology
+    nodes_.clear();
+    stack_.clear();
+    size_t nodeCount = tree.NodeCount();
+    words_.assign(WordCount(2 * nodeCount), 0);
+    size_t bit = 0;
+    auto enter = [this, &bit](const Node *node) {
+        words_[bit / 64] |= uint64_t(1) << (bit % 64);
+        bit++;
+        nodes_.push_back(node);
+        stack_.emplace_back(node, 0);
+    };
+    enter(tree.Root().get());
+    while (!stack_.empty()) {
+        auto &[node, next] = stack_.back();
+        if (next < node->ChildCount()) {
+            enter(node->ChildAt(next++).get());
+        } else {
+            bit++;
+            stack_.pop_back();
+        }
+    }
+    if (nodes_.size() != nodeCount) {
+        throw std::invalid_argument("The node count of the tree is not up to date");
+    }
+
+    record_.clear();
+    size_t leafCount = tree.LeafNodeCount();
+    Append(static_cast<uint32_t>(nodeCount), record_);
+    Append(static_cast<uint32_t>(leafCount), record_);
+    Append(uint64_t(0), record_);
+    for (uint64_t word : words_) {
+        Append(word, record_);
+    }
+
+    for (const Node *node : nodes_) {
+        if (!node->IsLeaf()) continue;
+        size_t taxon = sameTaxa ? node->Id() : taxa_->IndexOf(node->Name());
+        if (taxon == TaxonSet::kNotFound) {
+            throw std::invalid_argument("Taxon " + node->Name() +
+                                        " is not in the taxa of the writer");
+        }
+        Append(static_cast<uint32_t>(taxon), record_);
+    }
+    Pad(record_);
+
+    for (const Node *node : nodes_) {
+        if (options_.singlePrecision) {
+            Append(static_cast<float>(node->Distance()), record_);
+        } else {
+            Append(node->Distance(), record_);
+        }
+    }
+    Pad(record_);
+
+    if (options_.internalNames) {
+        vector<std::string_view> names;
+        for (const Node *node : nodes_) {
+            if (!node->IsLeaf()) names.push_back(node->Name());
+        }
+        AppendStrings<uint32_t>(names, record_);
+    }
+
+    for (const auto &column : options_.columns) {
+        auto contains = [&column](const Node *node) {
+            return column.branch ? node->ContainsBranchAnnotation(column.key)
+                                 : node->ContainsAnnotation(column.key);
+        };
+        auto value = [&column](const Node *node) {
+            return column.branch ? node->BranchAnnotation(column.key)
+                                 : node->Annotation(column.key);
+        };
+        auto mismatch = [&column]() {
+            return std::invalid_argument("Annotation " + column.key +
+                                         " does not have the type of its column");
+        };
+
+        words_.assign(WordCount(nodeCount), 0);
+        for (size_t i = 0; i < nodeCount; i++) {
+            if (contains(nodes_[i])) words_[i / 64] |= uint64_t(1) << (i % 64);
+        }
+        for (uint64_t word : words_) {
+            Append(word, record_);
+        }
+
+        if (column.type == ColumnType::kString) strings_.resize(nodeCount);
+        for (size_t i = 0; i < nodeCount; i++) {
+            bool present = (words_[i / 64] >> (i % 64)) & 1;
+            std::any any = present ? value(nodes_[i]) : std::any();
+            if (column.type == ColumnType::kString) {
+                if (present && any.type() != typeid(string)) throw mismatch();
+                strings_[i] =
+                    present ? std::any_cast<string &&>(std::move(any)) : string();
+            } else if (column.type == ColumnType::kDouble) {
+                double number = std::numeric_limits<double>::quiet_NaN();
+                if (any.type() == typeid(double)) {
+                    number = std::any_cast<double>(any);
+                } else if (any.type() == typeid(int)) {
+                    number = std::any_cast<int>(any);
+                } else if (present) {
+                    throw mismatch();
+                }
+                Append(number, record_);
+            } else {
+                int64_t number = 0;
+                if (any.type() == typeid(int)) {
+                    number = std::any_cast<int>(any);
+                } else if (any.type() == typeid(int64_t) &&
+                           column.type == ColumnType::kInt64) {
+                    number = std::any_cast<int64_t>(any);
+                } else if (present) {
+                    throw mismatch();
+                }
+                Append(number, record_);
+            }
+        }
+        if (column.type == ColumnType::kString) {
+            AppendStrings<uint32_t>(strings_, record_);
+        }
+    }
+
+    offsets_.push_back(position_);
+    WriteBytes(record_);
+}
+
+void BinaryTreeWriter::Write(const vector<std::shared_ptr<Tree>> &trees) {
+    for (const auto &tree : trees) {
+        Write(*tree);
+    }
+}
+
+void BinaryTreeWriter::Close() {
+    if (closed_) return;
+    closed_ = true;
+    header_.treeCount = offsets_.size();
+    header_.offsetsOffset = position_;
+
+    string table;
+    for (uint64_t offset : offsets_) {
+        Append(offset, table);
+    }
+    Append(position_, table);
+    WriteBytes(table);
+
+    // the header is complete once the offsets are written
+    string header;
+    Append(header_, header);
+    out_.seekp(0);
+    out_.write(header.data(), static_cast<std::streamsize>(header.size()));
+    out_.close();
+    if (!out_) {
+        throw std::runtime_error("Cannot write binary tree file");
+    }
+}
+
+void BinaryTreeWriter::WriteBytes(const string &bytes) {
+    out_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out_) {
+        throw std::runtime_error("Cannot write binary tree file");
+    }
+    position_ += bytes.size();
+}
+
+void BinaryTreeWriter::CheckOpen() const {
+    if (closed_) {
+        throw std::logic_error("Cannot write trees after BinaryTreeWriter::Close");
+    }
+}
+
+BinaryTreeView::BinaryTreeView(const char *data, size_t size,
+                               const BinaryTreeFormat::Header &header,
+                               const vector<BinaryColumn> &columns)
+    : header_(&header), columns_(&columns) {
+    CheckRecord(size >= 16);
+    nodeCount_ = Load<uint32_t>(data);
+    leafCount_ = Load<uint32_t>(data + 4);
+    CheckRecord(nodeCount_ > 0 && leafCount_ > 0 && leafCount_ <= nodeCount_);
+
+    // sections are located from the counts, strings from their last offset
+    size_t position = 16;
+    auto section = [&](size_t bytes) {
+        CheckRecord(bytes <= size - position);
+        const char *start = data + position;
+        position += Padded(bytes);
+        CheckRecord(position <= size);
+        return start;
+    };
+    auto stringsSize = [&](size_t count) {
+        size_t offsetsSize = (count + 1) * sizeof(uint32_t);
+        CheckRecord(offsetsSize <= size - position);
+        return offsetsSize + Load<uint32_t>(data + position + count * sizeof(uint32_t));
+    };
+
+    topology_ = section(WordCount(2 * nodeCount_) * sizeof(uint64_t));
+    leaves_ = section(leafCount_ * sizeof(uint32_t));
+    size_t lengthSize = header_->flags & BinaryTreeFormat::kSinglePrecision
+                            ? sizeof(float)
+                            : sizeof(double);
+    lengths_ = section(nodeCount_ * lengthSize);
+    if (header_->flags & BinaryTreeFormat::kInternalNames) {
+        names_ = section(stringsSize(nodeCount_ - leafCount_));
+    }
+    columnData_.resize(columns.size());
+    for (size_t c = 0; c < columns.size(); c++) {
+        columnData_[c] = section(WordCount(nodeCount_) * sizeof(uint64_t));
+        if (columns[c].type == ColumnType::kString) {
+            section(stringsSize(nodeCount_));
+        } else {
+            section(nodeCount_ * sizeof(uint64_t));
+        }
+    }
+}
+
+uint64_t BinaryTreeView::Word(const char *words, size_t index) {
+    return Load<uint64_t>(words + index * sizeof(uint64_t));
+}
+
+size_t BinaryTreeView::Taxon(size_t leaf) const {
+    return Load<uint32_t>(leaves_ + leaf * sizeof(uint32_t));
+}
+
+double BinaryTreeView::Distance(size_t node) const {
+    if (header_->flags & BinaryTreeFormat::kSinglePrecision) {
+        return Load<float>(lengths_ + node * sizeof(float));
+    }
+    return Load<double>(lengths_ + node * sizeof(double));
+}
+
+namespace {
+// The size of the strings section is its last offset, which the view checked.
+std::string_view StringAt(const char *strings, size_t count, size_t index) {
+    uint32_t begin = Load<uint32_t>(strings + index * sizeof(uint32_t));
+    uint32_t end = Load<uint32_t>(strings + (index + 1) * sizeof(uint32_t));
+    uint32_t size = Load<uint32_t>(strings + count * sizeof(uint32_t));
+    CheckRecord(begin <= end && end <= size);
+    const char *data = strings + (count + 1) * sizeof(uint32_t);
+    return std::string_view(data + begin, end - begin);
+}
+}  // namespace
+
+std::string_view BinaryTreeView::InternalName(size_t internal) const {
+    if (!names_) return std::string_view();
+    return StringAt(names_, nodeCount_ - leafCount_, internal);
+}
+
+bool BinaryTreeView::HasValue(size_t column, size_t node) const {
+    return (Word(columnData_.at(column), node / 64) >> (node % 64)) & 1;
+}
+
+const char *BinaryTreeView::Values(size_t column) const {
+    return columnData_.at(column) + WordCount(nodeCount_) * sizeof(uint64_t);
+}
+
+double BinaryTreeView::DoubleValue(size_t column, size_t node) const {
+    return Load<double>(Values(column) + node * sizeof(double));
+}
+
+int64_t BinaryTreeView::IntValue(size_t column, size_t node) const {
+    return Load<int64_t>(Values(column) + node * sizeof(int64_t));
+}
+
+std::string_view BinaryTreeView::StringValue(size_t column, size_t node) const {
+    return StringAt(Values(column), nodeCount_, node);
+}
+
+std::shared_ptr<Tree> BinaryTreeView::ToTree(
+    const std::shared_ptr<const TaxonSet> &taxa,
+    const std::shared_ptr<NodeArena> &arena) const {
+    vector<Node::NodePtr> stack;
+    Node::NodePtr root;
+    size_t node = 0;
+    size_t leaf = 0;
+    size_t internal = 0;
+    for (size_t bit = 0; bit < 2 * nodeCount_; bit++) {
+        if (!IsOpen(bit)) {
+            CheckRecord(!stack.empty());
+            stack.pop_back();
+            continue;
+        }
+        CheckRecord(node < nodeCount_);
+        Node::NodePtr current;
+        // a leaf is left right after it is entered
+        if (bit + 1 == 2 * nodeCount_ || !IsOpen(bit + 1)) {
+            CheckRecord(leaf < leafCount_ && Taxon(leaf) < taxa->Size());
+            size_t taxon = Taxon(leaf++);
+            current = MakeNode(arena, taxa->Name(taxon));
+            current->SetId(taxon);
+        } else {
+            current = MakeNode(arena, string(InternalName(internal++)));
+        }
+        current->SetDistance(Distance(node));
+        for (size_t c = 0; c < columnData_.size(); c++) {
+            if (!HasValue(c, node)) continue;
+            const BinaryColumn &column = (*columns_)[c];
+            std::any value;
+            switch (column.type) {
+                case ColumnType::kDouble:
+                    value = DoubleValue(c, node);
+                    break;
+                case ColumnType::kInt:
+                    value = static_cast<int>(IntValue(c, node));
+                    break;
+                case ColumnType::kInt64:
+                    value = IntValue(c, node);
+                    break;
+                default:
+                    value = string(StringValue(c, node));
+            }
+            if (column.branch) {
+                current->SetBranchAnnotation(column.key, value);
+            } else {
+                current->SetAnnotation(column.key, value);
+            }
+        }
+        if (stack.empty()) {
+            CheckRecord(!root);
+            root = current;
+        } else {
+            stack.back()->AddChild(current);
+        }
+        stack.push_back(current);
+        node++;
+    }
+    CheckRecord(root && node == nodeCount_ && leaf == leafCount_);
+    return std::make_shared<Tree>(root, taxa);
+}
+
+BinaryTreeFile::BinaryTreeFile(const std::filesystem::path &path) : file_(path) {
+    const char *data = file_.Data();
+    size_t size = file_.Size();
+    if (size < sizeof(header_) ||
+        std::memcmp(data, BinaryTreeFormat::kMagic, sizeof(BinaryTreeFormat::kMagic)) !=
+            0) {
+        throw std::runtime_error("Not a binary tree file: " + path.string());
+    }
+    std::memcpy(&header_, data, sizeof(header_));
+    if (header_.byteOrder != BinaryTreeFormat::kByteOrderMark) {
+        throw std::runtime_error("Binary tree file written with another byte order: " +
+                                 path.string());
+    }
+    if (header_.version > BinaryTreeFormat::kVersion) {
+        throw std::runtime_error("Unsupported binary tree file version " +
+                                 std::to_string(header_.version) + ": " + path.string());
+    }
+    if (header_.offsetsOffset == 0) {
+        throw std::runtime_error("Binary tree file was not closed: " + path.string());
+    }
+
+    auto check = [&](bool condition) {
+        if (!condition) {
+            throw std::runtime_error("Corrupted binary tree file: " + path.string());
+        }
+    };
+    check(header_.offsetsOffset <= size &&
+          header_.treeCount < (size - header_.offsetsOffset) / sizeof(uint64_t));
+    offsets_ = data + header_.offsetsOffset;
+
+    check(header_.taxaOffset <= size &&
+          header_.taxonCount < (size - header_.taxaOffset) / sizeof(uint64_t));
+    const char *taxa = data + header_.taxaOffset;
+    const char *names = taxa + (header_.taxonCount + 1) * sizeof(uint64_t);
+    taxonNames_->resize(header_.taxonCount);
+    for (size_t i = 0; i < header_.taxonCount; i++) {
+        uint64_t begin = Load<uint64_t>(taxa + i * sizeof(uint64_t));
+        uint64_t end = Load<uint64_t>(taxa + (i + 1) * sizeof(uint64_t));
+        check(begin <= end && end <= static_cast<uint64_t>(data + size - names));
+        (*taxonNames_)[i].assign(names + begin, end - begin);
+    }
+
+    size_t position = header_.columnsOffset;
+    columns_.resize(header_.columnCount);
+    for (auto &column : columns_) {
+        check(position <= size && size - position >= 8);
+        column.type = static_cast<ColumnType>(Load<uint8_t>(data + position));
+        column.branch = Load<uint8_t>(data + position + 1) != 0;
+        uint32_t keySize = Load<uint32_t>(data + position + 4);
+        check(IsSupported(column.type) && keySize <= size - position - 8);
+        column.key.assign(data + position + 8, keySize);
+        position += Padded(8 + keySize);
+    }
+}
+
+BinaryTreeView BinaryTreeFile::View(size_t k) const {
+    if (k >= header_.treeCount) {
+        throw std::out_of_range("Tree " + std::to_string(k) + " is out of range");
+    }
+    uint64_t begin = Load<uint64_t>(offsets_ + k * sizeof(uint64_t));
+    uint64_t end = Load<uint64_t>(offsets_ + (k + 1) * sizeof(uint64_t));
+    CheckRecord(begin <= end && end <= file_.Size());
+    return BinaryTreeView(file_.Data() + begin, end - begin, header_, columns_);
+}
+
+vector<std::shared_ptr<Tree>> BinaryTreeFile::Parse() {
+    vector<std::shared_ptr<Tree>> trees(Count());
+    if (trees.empty()) return trees;
+    auto taxa = Taxa();
+
+    size_t threadCount = threadCount_ == 0 ? DefaultThreadCount() : threadCount_;
+    threadCount = std::max<size_t>(1, std::min(threadCount, trees.size()));
+
+    // a NodeArena is not thread safe so every other worker gets its own
+    vector<std::shared_ptr<NodeArena>> arenas(threadCount, arena_);
+    if (arena_) {
+        for (size_t worker = 1; worker < threadCount; worker++) {
+            arenas[worker] = std::make_shared<NodeArena>(arena_->SlabSize());
+        }
+    }
+
+    ParallelFor(trees.size(), threadCount, [&](size_t index, size_t worker) {
+        trees[index] = View(index).ToTree(taxa, arenas[worker]);
+    });
+    position_ = trees.size();
+    return trees;
+}
+
+std::shared_ptr<Tree> BinaryTreeFile::Next() {
+    if (!HasNext()) return nullptr;
+    return View(position_++).ToTree(Taxa(), arena_);
+}
+
+void BinaryTreeFile::SkipNext() {
+    if (HasNext()) position_++;
+}
+
+void BinaryTreeFile::Seek(size_t k) {
+    if (k >= header_.treeCount) {
+        throw std::out_of_range("Tree " + std::to_string(k) + " is out of range");
+    }
+    position_ = k;
+}
+
+size_t cladokit::ConvertToBinary(TreeFile &in, const std::filesystem::path &path,
+                                 const BinaryTreeOptions &options) {
+    auto tree = in.Next();
+    if (!tree) {
+        auto taxa = std::make_shared<TaxonSet>(vector<string>());
+        BinaryTreeWriter(path, taxa, options).Close();
+        return 0;
+    }
+    BinaryTreeWriter writer(path, tree->Taxa(), options);
+    // the following trees are read into the first one to reuse its nodes
+    do {
+        writer.Write(*tree);
+    } while (in.NextInto(*tree));
+    writer.Close();
+    return writer.TreeCount();
+}
@@ -0,0 +1,240 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "cladokit/annotation_table.hpp"
+#include "cladokit/mapped_file.hpp"
+#include "cladokit/node_arena.hpp"
+#include "cladokit/taxon_set.hpp"
+#include "cladokit/tree.hpp"
+#include "cladokit/treeio.hpp"
+
+namespace cladokit {
+
+// Binary collection of trees sharing a taxon set (.ckt files). All the values are
+// stored in the byte order of the machine that wrote the file, a file written with
+// the other byte order is rejected.
+//
+//   header      magic "CKTREES", version, byte order mark, flags, column count,
+//               tree count, taxon count and the offsets of the sections below
+//   taxa        taxonCount + 1 uint64 offsets followed by the names
+//   columns     type, node or branch, key of every annotation column
+//   trees       one record per tree, 8 byte aligned
+//   offsets     treeCount + 1 uint64 offsets of the records, the last one is the
+//               offset of this table
+//
+// A record lists the nodes in preorder:
+//   nodeCount and leafCount as uint32, 8 bytes reserved
+//   topology    balanced parentheses, 2 * nodeCount bits set when a node is entered
+//               and clear when it is left, in uint64 words
+//   leaves      uint32 taxon index of every leaf
+//   lengths     float64 or float32 branch length of every node, NaN if missing
+//   names       internalCount + 1 uint32 offsets followed by the names of the
+//               internal nodes, only if the file has internal names
+//   columns     for every column a presence bitmap in uint64 words followed by the
+//               values: float64, int64, or nodeCount + 1 uint32 offsets and the
+//               strings
+// Every section is padded to 8 bytes.
+struct BinaryTreeFormat {
+    static constexpr char kMagic[8] = {'C', 'K', 'T', 'R', 'E', 'E', 'S', '\0'};
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kByteOrderMark = 0x01020304;
+
+    // flags
+    static constexpr uint32_t kSinglePrecision = 1;
+    static constexpr uint32_t kInternalNames = 2;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t flags;
+        uint32_t columnCount;
+        uint64_t treeCount;
+        uint64_t taxonCount;
+        uint64_t taxaOffset;
+        uint64_t columnsOffset;
+        // 0 until the file is closed
+        uint64_t offsetsOffset;
+    };
+};
+
+// Annotation stored in a column of a binary tree file. Supported types are kDouble,
+// kInt, kInt64 and kString. An int annotation is accepted by a kDouble or a kInt64
+// column.
+struct BinaryColumn {
+    std::string key;
+    AnnotationTable::ColumnType type = AnnotationTable::ColumnType::kDouble;
+    bool branch = false;  // branch annotation instead of node annotation
+};
+
+struct BinaryTreeOptions {
+    // Store branch lengths as float32 instead of float64.
+    bool singlePrecision = false;
+    bool internalNames = true;
+    std::vector<BinaryColumn> columns;
+};
+
+// Writes a binary tree file. The offset table is written by Close or by the
+// destructor, a file that was not closed cannot be read.
+class BinaryTreeWriter {
+   public:
+    // Throws std::runtime_error if the file cannot be opened and
+    // std::invalid_argument if a column has an unsupported type.
+    BinaryTreeWriter(const std::filesystem::path &path,
+                     std::shared_ptr<const TaxonSet> taxa,
+                     BinaryTreeOptions options = BinaryTreeOptions());
+
+    ~BinaryTreeWriter();
+
+    BinaryTreeWriter(const BinaryTreeWriter &) = delete;
+
+    BinaryTreeWriter &operator=(const BinaryTreeWriter &) = delete;
+
+    // Leaves are matched to the taxa of the writer by name if the tree uses another
+    // taxon set. Throws std::invalid_argument if a leaf is not in the taxa or if an
+    // annotation does not have the type of its column.
+    void Write(const Tree &tree);
+
+    void Write(const std::vector<std::shared_ptr<Tree>> &trees);
+
+    void Close();
+
+    size_t TreeCount() const { return offsets_.size(); }
+
+   private:
+    std::ofstream out_;
+    std::shared_ptr<const TaxonSet> taxa_;
+    BinaryTreeOptions options_;
+    BinaryTreeFormat::Header header_;
+    std::vector<uint64_t> offsets_;
+    uint64_t position_ = 0;
+    bool closed_ = false;
+    // reused between trees
+    std::string record_;
+    std::vector<const Node *> nodes_;  // in preorder
+    std::vector<std::pair<const Node *, size_t>> stack_;
+    std::vector<uint64_t> words_;
+    std::vector<std::string> strings_;  // values of a string column
+
+    void WriteBytes(const std::string &bytes);
+
+    void CheckOpen() const;
+};
+
+// Zero-copy view of a tree of a binary tree file, valid as long as the file is
+// open. Nodes are numbered by their position in preorder.
+class BinaryTreeView {
+   public:
+    BinaryTreeView(const char *data, size_t size, const BinaryTreeFormat::Header &header,
+                   const std::vector<BinaryColumn> &columns);
+
+    size_t NodeCount() const { return nodeCount_; }
+
+    size_t LeafNodeCount() const { return leafCount_; }
+
+    // True if bit i of the topology enters a node, false if it leaves one.
+    bool IsOpen(size_t i) const { return (Word(topology_, i / 64) >> (i % 64)) & 1; }
+
+    // Taxon index of the leaf-th leaf in preorder.
+    size_t Taxon(size_t leaf) const;
+
+    double Distance(size_t node) const;
+
+    bool HasInternalNames() const { return names_ != nullptr; }
+
+    std::string_view InternalName(size_t internal) const;
+
+    size_t ColumnCount() const { return columnData_.size(); }
+
+    bool HasValue(size_t column, size_t node) const;
+
+    // Value of node in column, which must be of type kDouble.
+    double DoubleValue(size_t column, size_t node) const;
+
+    // Value of node in column, which must be of type kInt or kInt64.
+    int64_t IntValue(size_t column, size_t node) const;
+
+    // Value of node in column, which must be of type kString.
+    std::string_view StringValue(size_t column, size_t node) const;
+
+    // Build the tree with the nodes allocated from arena when it is not null.
+    std::shared_ptr<Tree> ToTree(const std::shared_ptr<const TaxonSet> &taxa,
+                                 const std::shared_ptr<NodeArena> &arena = nullptr) const;
+
+   private:
+    const BinaryTreeFormat::Header *header_;
+    const std::vector<BinaryColumn> *columns_;
+    size_t nodeCount_ = 0;
+    size_t leafCount_ = 0;
+    const char *topology_ = nullptr;
+    const char *leaves_ = nullptr;
+    const char *lengths_ = nullptr;
+    const char *names_ = nullptr;
+    std::vector<const char *> columnData_;  // presence bitmap of every column
+
+    static uint64_t Word(const char *words, size_t index);
+
+    const char *Values(size_t column) const;
+};
+
+// Tree file reading a binary tree file from a memory mapped file. Opening the file
+// only reads the header, the taxa and the columns, trees are decoded from the
+// mapped records when they are accessed. Seek does not require an index.
+class BinaryTreeFile : public TreeFile {
+   public:
+    // Throws std::runtime_error if the file cannot be read or is not a binary tree
+    // file.
+    explicit BinaryTreeFile(const std::filesystem::path &path);
+
+    size_t Count() override { return header_.treeCount; }
+
+    std::vector<std::shared_ptr<Tree>> Parse() override;
+
+    std::shared_ptr<Tree> Next() override;
+
+    bool HasNext() override { return position_ < header_.treeCount; }
+
+    void SkipNext() override;
+
+    void Seek(size_t k) override;
+
+    // Tree k without decoding it. Throws std::out_of_range if k is not smaller than
+    // Count().
+    BinaryTreeView View(size_t k) const;
+
+    // Taxon set shared by every tree of the file.
+    using TreeFile::Taxa;
+
+    const std::vector<BinaryColumn> &Columns() const { return columns_; }
+
+    uint32_t Version() const { return header_.version; }
+
+    bool SinglePrecision() const {
+        return header_.flags & BinaryTreeFormat::kSinglePrecision;
+    }
+
+   private:
+    MappedFile file_;
+    BinaryTreeFormat::Header header_;
+    std::vector<BinaryColumn> columns_;
+    const char *offsets_ = nullptr;
+    size_t position_ = 0;
+};
+
+// Read every tree of in and write them to a binary tree file at path, e.g. to
+// convert a NewickFile or a NexusFile. Returns the number of trees written.
+size_t ConvertToBinary(TreeFile &in, const std::filesystem::path &path,
+                       const BinaryTreeOptions &options = BinaryTreeOptions());
+}  // namespace cladokit
@@ -4,29 +4,29 @@
 #pragma once
 
 #include <memory>
+#include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "cladokit/bitset.hpp"
+#include "cladokit/compact_tree.hpp"
+#include "cladokit/split_hash.hpp"
 #include "cladokit/tree.hpp"
 
 namespace cladokit {
-using BiPartition = std::vector<bool>;
+using BiPartition = Bitset;
 
 struct BiPartitionHash {
-    std::size_t operator()(const BiPartition& v) const {
-        // return std::hash<std::vector<bool>>{}(v);
-        std::size_t h = 0;
-        for (bool b : v) {
-            h = (h << 1) ^ std::hash<bool>{}(b);
-        }
-        return h;
-    }
+    std::size_t operator()(const BiPartition& v) const { return v.Hash(); }
 };
 
 using BiPartitionSet = std::unordered_set<BiPartition, BiPartitionHash>;
 
-static BiPartitionSet GetBiPartitionSet(const Tree::TreePtr& tree) {
+// Splits identified by their hash only (see TaxonKey).
+using SplitHashSet = std::unordered_set<uint64_t>;
+
+inline BiPartitionSet GetBiPartitionSet(const Tree::TreePtr& tree) {
     std::unordered_set<BiPartition, BiPartitionHash> result;
     for (auto it = tree->Root()->begin_postorder(); it != tree->Root()->end_postorder();
          ++it) {
@@ -38,4 +38,56 @@ static BiPartitionSet GetBiPartitionSet(const Tree::TreePtr& tree) {
 
     return result;
 }
+
+// Internal nodes of a compact tree are stored after their children so the bitsets
+// can be built in a single pass without traversing the tree.
+inline BiPartitionSet GetBiPartitionSet(const CompactTree& tree) {
+    using Index = CompactTree::Index;
+    size_t leafCount = tree.LeafNodeCount();
+    std::vector<BiPartition> bitsets(tree.InternalNodeCount(), BiPartition(leafCount));
+    BiPartitionSet result;
+    for (Index node = leafCount; node < tree.NodeCount(); node++) {
+        auto& bitset = bitsets[node - leafCount];
+        for (Index child = tree.FirstChild(node); child != CompactTree::kNone;
+             child = tree.NextSibling(child)) {
+            if (tree.IsLeaf(child)) {
+                bitset.Set(child);
+            } else {
+                bitset |= bitsets[child - leafCount];
+            }
+        }
+        if (!tree.IsRoot(node)) {
+            result.insert(bitset);
+        }
+    }
+    return result;
+}
+
+// Hashes of the non trivial clades of tree. Tree::ComputeSplitHashes must be called
+// first, tree is not modified.
+inline SplitHashSet GetSplitHashSet(const Tree::TreePtr& tree) {
+    if (!tree->HasSplitHashes()) {
+        throw std::logic_error("Tree::ComputeSplitHashes must be called first");
+    }
+    SplitHashSet result;
+    for (auto it = tree->Root()->begin_postorder(); it != tree->Root()->end_postorder();
+         ++it) {
+        auto node = *it;
+        if (!node->IsRoot() && !node->IsLeaf()) {
+            result.insert(node->SplitHash());
+        }
+    }
+    return result;
+}
+
+// Hash identifying the topology of tree, independent of the order of the children.
+// Tree::ComputeSplitHashes must be called first like for GetSplitHashSet.
+inline uint64_t TopologyHash(const Tree::TreePtr& tree) {
+    uint64_t hash = 0;
+    for (auto splitHash : GetSplitHashSet(tree)) {
+        // mix each split hash so that the sum does not cancel out like a XOR would
+        hash += TaxonKey(splitHash);
+    }
+    return hash;
+}
 }  // namespace cladokit
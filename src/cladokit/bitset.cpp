@@ -0,0 +1,174 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/bitset.hpp"
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+#include "cladokit/split_hash.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace cladokit {
+
+namespace {
+inline size_t PopCount(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<size_t>(__builtin_popcountll(word));
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<size_t>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// XOR of the TaxonKey of the bits set in the wordIndex-th word
+uint64_t WordHash(size_t wordIndex, uint64_t word) {
+    uint64_t hash = 0;
+    for (; word != 0; word &= word - 1) {
+#if defined(__GNUC__) || defined(__clang__)
+        size_t bit = static_cast<size_t>(__builtin_ctzll(word));
+#else
+        size_t bit = PopCount((word & (~word + 1)) - 1);
+#endif
+        hash ^= TaxonKey(wordIndex * Bitset::kWordBits + bit);
+    }
+    return hash;
+}
+
+// Bitwise operators on a single word and on a vector register.
+struct OrOp {
+    uint64_t operator()(uint64_t a, uint64_t b) const { return a | b; }
+#if defined(__AVX2__)
+    __m256i operator()(__m256i a, __m256i b) const { return _mm256_or_si256(a, b); }
+#elif defined(__ARM_NEON)
+    uint64x2_t operator()(uint64x2_t a, uint64x2_t b) const { return vorrq_u64(a, b); }
+#endif
+};
+
+struct AndOp {
+    uint64_t operator()(uint64_t a, uint64_t b) const { return a & b; }
+#if defined(__AVX2__)
+    __m256i operator()(__m256i a, __m256i b) const { return _mm256_and_si256(a, b); }
+#elif defined(__ARM_NEON)
+    uint64x2_t operator()(uint64x2_t a, uint64x2_t b) const { return vandq_u64(a, b); }
+#endif
+};
+
+struct XorOp {
+    uint64_t operator()(uint64_t a, uint64_t b) const { return a ^ b; }
+#if defined(__AVX2__)
+    __m256i operator()(__m256i a, __m256i b) const { return _mm256_xor_si256(a, b); }
+#elif defined(__ARM_NEON)
+    uint64x2_t operator()(uint64x2_t a, uint64x2_t b) const { return veorq_u64(a, b); }
+#endif
+};
+
+// Applies op to blocks of words using the widest available vector registers and
+// finishes the remaining words one at a time.
+template <typename Op>
+inline void ApplyWords(uint64_t *destination, const uint64_t *source, size_t count,
+                       Op op) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= count; i += 4) {
+        auto *d = reinterpret_cast<__m256i *>(destination + i);
+        auto *s = reinterpret_cast<const __m256i *>(source + i);
+        _mm256_storeu_si256(d, op(_mm256_loadu_si256(d), _mm256_loadu_si256(s)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 2 <= count; i += 2) {
+        vst1q_u64(destination + i, op(vld1q_u64(destination + i), vld1q_u64(source + i)));
+    }
+#endif
+    for (; i < count; i++) {
+        destination[i] = op(destination[i], source[i]);
+    }
+}
+}  // namespace
+
+void OrWords(uint64_t *destination, const uint64_t *source, size_t count) {
+    ApplyWords(destination, source, count, OrOp());
+}
+
+void AndWords(uint64_t *destination, const uint64_t *source, size_t count) {
+    ApplyWords(destination, source, count, AndOp());
+}
+
+void XorWords(uint64_t *destination, const uint64_t *source, size_t count) {
+    ApplyWords(destination, source, count, XorOp());
+}
+
+size_t PopCountWords(const uint64_t *words, size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += PopCount(words[i]);
+    }
+    return total;
+}
+
+Bitset::Bitset(const std::vector<bool> &bits) : Bitset(bits.size()) {
+    for (size_t i = 0; i < bits.size(); i++) {
+        if (bits[i]) Set(i);
+    }
+}
+
+void Bitset::Resize(size_t size) {
+    size_ = size;
+    words_.assign(WordCount(size), 0);
+    hash_ = 0;
+}
+
+void Bitset::Clear() {
+    std::fill(words_.begin(), words_.end(), 0);
+    hash_ = 0;
+}
+
+void Bitset::Flip() {
+    hash_ = 0;
+    for (size_t w = 0; w < words_.size(); w++) {
+        words_[w] = ~words_[w];
+        if (w + 1 == words_.size() && size_ % kWordBits != 0) {
+            words_[w] &= (Word(1) << (size_ % kWordBits)) - 1;
+        }
+        hash_ ^= WordHash(w, words_[w]);
+    }
+}
+
+Bitset &Bitset::operator|=(const Bitset &other) {
+    for (size_t w = 0; w < words_.size(); w++) {
+        Word common = words_[w] & other.words_[w];
+        if (common != 0) hash_ ^= WordHash(w, common);
+    }
+    OrWords(words_.data(), other.words_.data(), words_.size());
+    hash_ ^= other.hash_;
+    return *this;
+}
+
+Bitset &Bitset::operator&=(const Bitset &other) {
+    for (size_t w = 0; w < words_.size(); w++) {
+        Word removed = words_[w] & ~other.words_[w];
+        if (removed != 0) hash_ ^= WordHash(w, removed);
+    }
+    AndWords(words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+bool Bitset::Any() const {
+    return std::any_of(words_.begin(), words_.end(), [](Word w) { return w != 0; });
+}
+
+std::ostream &operator<<(std::ostream &os, const Bitset &bitset) {
+    for (size_t i = 0; i < bitset.Size(); i++) {
+        os << (bitset[i] ? '1' : '0');
+    }
+    return os;
+}
+}  // namespace cladokit
@@ -0,0 +1,108 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "cladokit/split_hash.hpp"
+
+namespace cladokit {
+
+// Word kernels used by Bitset. They use AVX2 or NEON when the compiler targets
+// them and fall back to a scalar loop otherwise.
+void OrWords(uint64_t* destination, const uint64_t* source, size_t count);
+
+void AndWords(uint64_t* destination, const uint64_t* source, size_t count);
+
+void XorWords(uint64_t* destination, const uint64_t* source, size_t count);
+
+size_t PopCountWords(const uint64_t* words, size_t count);
+
+// Fixed size bitset packed in 64 bit words. Bits past Size() in the last word are
+// always zero so that words can be compared and counted directly.
+// The hash is the XOR of the TaxonKey of every set bit. Every modification keeps it
+// up to date so that Hash only reads it and can be called from several threads.
+class Bitset {
+   public:
+    using Word = uint64_t;
+
+    static constexpr size_t kWordBits = 64;
+
+    Bitset() = default;
+
+    explicit Bitset(size_t size) : size_(size), words_(WordCount(size), 0) {}
+
+    explicit Bitset(const std::vector<bool>& bits);
+
+    size_t Size() const { return size_; }
+
+    bool Empty() const { return size_ == 0; }
+
+    // Resize and clear all the bits.
+    void Resize(size_t size);
+
+    bool Test(size_t index) const {
+        return (words_[index / kWordBits] >> (index % kWordBits)) & 1;
+    }
+
+    bool operator[](size_t index) const { return Test(index); }
+
+    void Set(size_t index) {
+        Word bit = Word(1) << (index % kWordBits);
+        Word& word = words_[index / kWordBits];
+        if (!(word & bit)) hash_ ^= TaxonKey(index);
+        word |= bit;
+    }
+
+    void Reset(size_t index) {
+        Word bit = Word(1) << (index % kWordBits);
+        Word& word = words_[index / kWordBits];
+        if (word & bit) hash_ ^= TaxonKey(index);
+        word &= ~bit;
+    }
+
+    void Clear();
+
+    // Complement every bit.
+    void Flip();
+
+    size_t Count() const { return PopCountWords(words_.data(), words_.size()); }
+
+    bool Any() const;
+
+    const std::vector<Word>& Words() const { return words_; }
+
+    // The hash of the union is the XOR of both hashes and of the hash of the common
+    // bits, so the hash of disjoint bitsets, e.g. the clades of siblings, is cheap.
+    Bitset& operator|=(const Bitset& other);
+
+    Bitset& operator&=(const Bitset& other);
+
+    Bitset& operator^=(const Bitset& other) {
+        XorWords(words_.data(), other.words_.data(), words_.size());
+        hash_ ^= other.hash_;
+        return *this;
+    }
+
+    bool operator==(const Bitset& other) const {
+        return size_ == other.size_ && words_ == other.words_;
+    }
+
+    bool operator!=(const Bitset& other) const { return !(*this == other); }
+
+    size_t Hash() const { return static_cast<size_t>(hash_); }
+
+    static size_t WordCount(size_t size) { return (size + kWordBits - 1) / kWordBits; }
+
+   private:
+    size_t size_ = 0;
+    std::vector<Word> words_;
+    uint64_t hash_ = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const Bitset& bitset);
+}  // namespace cladokit
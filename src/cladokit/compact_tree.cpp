@@ -0,0 +1,374 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/compact_tree.hpp"
+
+#include <deque>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cladokit/newick_tokenizer.hpp"
+#include "cladokit/taxon_set.hpp"
+
+using cladokit::CompactTree;
+using cladokit::NewickTokenizer;
+using cladokit::Node;
+using cladokit::TaxonSet;
+using cladokit::Tree;
+using std::string;
+using std::vector;
+using TokenType = cladokit::NewickTokenizer::TokenType;
+
+namespace {
+using Index = CompactTree::Index;
+constexpr Index kNone = CompactTree::kNone;
+
+// Calls visit on every node below root in postorder using first-child/next-sibling
+// links, without any auxiliary stack.
+template <typename Visitor>
+void VisitPostOrder(Index root, const vector<Index> &parent,
+                    const vector<Index> &firstChild, const vector<Index> &nextSibling,
+                    Visitor visit) {
+    auto leftmost = [&](Index node) {
+        while (firstChild[node] != kNone) node = firstChild[node];
+        return node;
+    };
+    Index node = leftmost(root);
+    while (true) {
+        visit(node);
+        if (node == root) break;
+        if (nextSibling[node] != kNone) {
+            node = leftmost(nextSibling[node]);
+        } else {
+            node = parent[node];
+        }
+    }
+}
+}  // namespace
+
+CompactTree::CompactTree(const Tree &tree)
+    : leafCount_(tree.LeafNodeCount()), taxonNames_(tree.TaxonNames()) {
+    Resize(leafCount_, tree.NodeCount());
+
+    // Tree ids are dense so they can be used to remap nodes to compact indices
+    vector<Index> remap(tree.NodeCount(), kNone);
+    auto next = static_cast<Index>(leafCount_);
+    auto root = tree.Root();
+    for (auto it = root->begin_postorder(); it != root->end_postorder(); ++it) {
+        auto node = *it;
+        Index index = node->IsLeaf() ? static_cast<Index>(node->Id()) : next++;
+        remap[node->Id()] = index;
+        distance_[index] = node->Distance();
+        if (!node->IsLeaf()) {
+            internalNames_[index - leafCount_] = node->Name();
+        }
+        Index previous = kNone;
+        for (const auto &child : node->Children()) {
+            Index childIndex = remap[child->Id()];
+            parent_[childIndex] = index;
+            if (previous == kNone) {
+                firstChild_[index] = childIndex;
+            } else {
+                nextSibling_[previous] = childIndex;
+            }
+            previous = childIndex;
+        }
+    }
+    BuildTraversals();
+}
+
+void CompactTree::Resize(size_t leafCount, size_t nodeCount) {
+    leafCount_ = leafCount;
+    parent_.assign(nodeCount, kNone);
+    firstChild_.assign(nodeCount, kNone);
+    nextSibling_.assign(nodeCount, kNone);
+    distance_.assign(nodeCount, std::numeric_limits<double>::quiet_NaN());
+    internalNames_.assign(nodeCount - leafCount, string());
+}
+
+void CompactTree::BuildTraversals() {
+    postorder_.clear();
+    preorder_.clear();
+    postorder_.reserve(NodeCount());
+    preorder_.reserve(NodeCount());
+
+    Index root = Root();
+    VisitPostOrder(root, parent_, firstChild_, nextSibling_,
+                   [this](Index node) { postorder_.push_back(node); });
+
+    Index node = root;
+    while (true) {
+        preorder_.push_back(node);
+        if (firstChild_[node] != kNone) {
+            node = firstChild_[node];
+            continue;
+        }
+        while (node != root && nextSibling_[node] == kNone) {
+            node = parent_[node];
+        }
+        if (node == root) break;
+        node = nextSibling_[node];
+    }
+}
+
+size_t CompactTree::ChildCount(Index node) const {
+    size_t count = 0;
+    for (Index child = firstChild_[node]; child != kNone; child = nextSibling_[child]) {
+        count++;
+    }
+    return count;
+}
+
+const string &CompactTree::Name(Index node) const {
+    if (IsLeaf(node)) {
+        return taxonNames_->at(node);
+    }
+    return internalNames_[node - leafCount_];
+}
+
+Tree::TreePtr CompactTree::ToTree() const {
+    vector<Node::NodePtr> nodes(NodeCount());
+    for (Index i = 0; i < NodeCount(); i++) {
+        nodes[i] = std::make_shared<Node>(Name(i));
+        nodes[i]->SetDistance(distance_[i]);
+    }
+    for (Index i = static_cast<Index>(leafCount_); i < NodeCount(); i++) {
+        for (Index child = firstChild_[i]; child != kNone; child = nextSibling_[child]) {
+            nodes[i]->AddChild(nodes[child]);
+        }
+    }
+    return std::make_shared<Tree>(nodes[Root()], taxonNames_);
+}
+
+CompactTree::CompactTreePtr CompactTree::FromNewick(std::string_view newick) {
+    auto taxonNames = std::make_shared<std::vector<string>>();
+    return FromNewick(newick, taxonNames);
+}
+
+CompactTree::CompactTreePtr CompactTree::FromNewick(
+    std::string_view newick, std::shared_ptr<std::vector<string>> taxonNames) {
+    if (taxonNames->empty()) {
+        return Parse(newick, nullptr, taxonNames);
+    }
+    return Parse(newick, std::make_shared<TaxonSet>(*taxonNames), nullptr);
+}
+
+CompactTree::CompactTreePtr CompactTree::FromNewick(
+    std::string_view newick, std::shared_ptr<const TaxonSet> taxonSet) {
+    if (taxonSet) {
+        return Parse(newick, taxonSet, nullptr);
+    }
+    return Parse(newick, nullptr, std::make_shared<vector<string>>());
+}
+
+CompactTree::CompactTreePtr CompactTree::Parse(
+    std::string_view newick, std::shared_ptr<const TaxonSet> taxonSet,
+    std::shared_ptr<std::vector<string>> taxonNames) {
+    // Nodes are first created in the order they appear in the newick string and
+    // renumbered once the whole topology is known.
+    vector<Index> parent;
+    vector<Index> firstChild;
+    vector<Index> lastChild;
+    vector<Index> nextSibling;
+    vector<double> distance;
+    // views of newick, names are only copied when kept
+    vector<std::string_view> names;
+    std::deque<string> unquoted;  // names of quoted labels
+    vector<bool> isLeaf;
+    vector<Index> nodeStack;
+    NewickTokenizer tokenizer(newick);
+    size_t leafCount = 0;
+    bool justClosed = false;     // a label is the name of the node just closed
+    size_t depth = 0;            // number of open parentheses
+    bool expectingNode = false;  // after an opening parenthesis or a comma
+
+    // a node starts the tree or follows an opening parenthesis or a comma
+    auto checkNodeExpected = [&]() {
+        if (!parent.empty() && !expectingNode) {
+            throw std::invalid_argument(
+                (depth == 0 ? "Unexpected text after the root at position "
+                            : "Missing comma between nodes at position ") +
+                std::to_string(tokenizer.Position()));
+        }
+    };
+
+    auto addNode = [&](bool leaf) {
+        auto index = static_cast<Index>(parent.size());
+        Index parentIndex = nodeStack.empty() ? kNone : nodeStack.back();
+        parent.push_back(parentIndex);
+        firstChild.push_back(kNone);
+        lastChild.push_back(kNone);
+        nextSibling.push_back(kNone);
+        distance.push_back(std::numeric_limits<double>::quiet_NaN());
+        names.emplace_back();
+        isLeaf.push_back(leaf);
+        if (parentIndex != kNone) {
+            if (firstChild[parentIndex] == kNone) {
+                firstChild[parentIndex] = index;
+            } else {
+                nextSibling[lastChild[parentIndex]] = index;
+            }
+            lastChild[parentIndex] = index;
+        }
+        nodeStack.push_back(index);
+        return index;
+    };
+
+    for (auto token = tokenizer.Next(); token.type != TokenType::kEnd;
+         token = tokenizer.Next()) {
+        if (token.type == TokenType::kSemicolon) {
+            // only whitespace can follow the end of the tree
+            if (tokenizer.Next().type != TokenType::kEnd) {
+                throw std::invalid_argument(
+                    "Unexpected text after the tree at position " +
+                    std::to_string(tokenizer.Position()));
+            }
+            break;
+        }
+        switch (token.type) {
+            case TokenType::kColon:
+                if (nodeStack.empty() || expectingNode) {
+                    throw std::invalid_argument(
+                        "Branch length without node at position " +
+                        std::to_string(tokenizer.Position()));
+                }
+                token = tokenizer.Next();
+                // annotations are not kept in a compact tree
+                if (token.type == TokenType::kComment) {
+                    token = tokenizer.Next();
+                }
+                if (token.type != TokenType::kLabel) {
+                    throw std::invalid_argument("Missing branch length at position " +
+                                                std::to_string(tokenizer.Position()));
+                }
+                distance[nodeStack.back()] = NewickTokenizer::ParseNumber(token.text);
+                break;
+            case TokenType::kLabel: {
+                std::string_view name = token.text;
+                if (name.front() == '\'' || name.front() == '"') {
+                    name = unquoted.emplace_back(NewickTokenizer::Unquote(name));
+                }
+                if (justClosed) {
+                    names[nodeStack.back()] = name;
+                    justClosed = false;
+                } else {
+                    checkNodeExpected();
+                    addNode(true);
+                    names.back() = name;
+                    leafCount++;
+                    expectingNode = false;
+                }
+                break;
+            }
+            case TokenType::kOpen:
+                checkNodeExpected();
+                justClosed = false;
+                depth++;
+                expectingNode = true;
+                addNode(false);
+                break;
+            case TokenType::kClose:
+            case TokenType::kComma:
+                // the root cannot be closed or have siblings
+                if (depth == 0) {
+                    throw std::invalid_argument(
+                        (token.type == TokenType::kClose
+                             ? "Unbalanced closing parenthesis at position "
+                             : "Comma outside of parentheses at position ") +
+                        std::to_string(tokenizer.Position()));
+                }
+                if (expectingNode) {
+                    throw std::invalid_argument("Missing node at position " +
+                                                std::to_string(tokenizer.Position()));
+                }
+                nodeStack.pop_back();
+                if (token.type == TokenType::kClose) {
+                    depth--;
+                } else {
+                    expectingNode = true;
+                }
+                justClosed = token.type == TokenType::kClose;
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (parent.empty()) {
+        throw std::invalid_argument("Empty newick string");
+    }
+    if (depth > 0 || expectingNode) {
+        throw std::invalid_argument("Incomplete newick string");
+    }
+
+    // Leaves are numbered after their taxon index
+    vector<Index> remap(parent.size(), kNone);
+    if (!taxonSet) {
+        taxonNames->reserve(leafCount);
+        for (Index i = 0; i < parent.size(); i++) {
+            if (isLeaf[i]) {
+                remap[i] = static_cast<Index>(taxonNames->size());
+                taxonNames->emplace_back(names[i]);
+            }
+        }
+    } else {
+        vector<bool> seen(taxonSet->Size(), false);
+        vector<std::string_view> missing;
+        for (Index i = 0; i < parent.size(); i++) {
+            if (!isLeaf[i]) continue;
+            size_t taxonIndex = taxonSet->IndexOf(names[i]);
+            if (taxonIndex == TaxonSet::kNotFound) {
+                missing.push_back(names[i]);
+            } else if (seen[taxonIndex]) {
+                throw std::runtime_error("Error: taxon name " + string(names[i]) +
+                                         " appears more than once");
+            } else {
+                seen[taxonIndex] = true;
+                remap[i] = static_cast<Index>(taxonIndex);
+            }
+        }
+        if (!missing.empty() || leafCount != taxonSet->Size()) {
+            std::ostringstream message;
+            message << "Error: taxon names do not match";
+            for (const auto &name : missing) {
+                message << "\nMissing taxon name: " << name;
+            }
+            for (size_t i = 0; i < seen.size(); i++) {
+                if (!seen[i]) {
+                    message << "\nExtra taxon name: " << taxonSet->Name(i);
+                }
+            }
+            throw std::runtime_error(message.str());
+        }
+    }
+
+    // and internal nodes in postorder
+    auto next = static_cast<Index>(leafCount);
+    VisitPostOrder(0, parent, firstChild, nextSibling, [&](Index node) {
+        if (!isLeaf[node]) remap[node] = next++;
+    });
+
+    auto tree = std::make_shared<CompactTree>();
+    tree->taxonNames_ = taxonSet ? taxonSet->Names() : taxonNames;
+    tree->Resize(leafCount, parent.size());
+    for (Index i = 0; i < parent.size(); i++) {
+        Index index = remap[i];
+        auto mapped = [&remap](Index node) {
+            return node == kNone ? kNone : remap[node];
+        };
+        tree->parent_[index] = mapped(parent[i]);
+        tree->firstChild_[index] = mapped(firstChild[i]);
+        tree->nextSibling_[index] = mapped(nextSibling[i]);
+        tree->distance_[index] = distance[i];
+        if (!isLeaf[i]) {
+            tree->internalNames_[index - leafCount] = names[i];
+        }
+    }
+    tree->BuildTraversals();
+    return tree;
+}
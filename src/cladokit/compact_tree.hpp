@@ -0,0 +1,119 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cladokit/tree.hpp"
+
+namespace cladokit {
+
+// Flat, index-based tree. Topology is stored as parent/first-child/next-sibling
+// index arrays and branch lengths in a contiguous array.
+// Leaves occupy indices [0, LeafNodeCount()) using their taxon index and internal
+// nodes occupy [LeafNodeCount(), NodeCount()) in postorder, so the root is always
+// the last node and every child has a smaller index than its parent.
+//
+// Only the topology, the branch lengths and the node names are kept: node and branch
+// annotations and raw comments are dropped when converting from a Tree or parsing a
+// newick string. Internal nodes are renumbered in postorder, so their indices match
+// the ids of the Tree they were converted from only if those ids were in postorder,
+// e.g. before any topology edit. Tree::FromNewick does not build a CompactTree, use
+// CompactTree::FromNewick to parse a newick string directly into this representation.
+class CompactTree {
+   public:
+    using Index = uint32_t;
+    using CompactTreePtr = std::shared_ptr<CompactTree>;
+
+    static constexpr Index kNone = std::numeric_limits<Index>::max();
+
+    CompactTree() = default;
+
+    // Annotations and comments of tree are not copied.
+    explicit CompactTree(const Tree& tree);
+
+    std::shared_ptr<const std::vector<std::string>> TaxonNames() const {
+        return taxonNames_;
+    }
+
+    size_t NodeCount() const { return parent_.size(); }
+
+    size_t LeafNodeCount() const { return leafCount_; }
+
+    size_t InternalNodeCount() const { return NodeCount() - leafCount_; }
+
+    Index Root() const { return static_cast<Index>(NodeCount() - 1); }
+
+    Index Parent(Index node) const { return parent_[node]; }
+
+    Index FirstChild(Index node) const { return firstChild_[node]; }
+
+    Index NextSibling(Index node) const { return nextSibling_[node]; }
+
+    size_t ChildCount(Index node) const;
+
+    bool IsLeaf(Index node) const { return node < leafCount_; }
+
+    bool IsRoot(Index node) const { return parent_[node] == kNone; }
+
+    double Distance(Index node) const { return distance_[node]; }
+
+    void SetDistance(Index node, double distance) { distance_[node] = distance; }
+
+    const std::vector<double>& Distances() const { return distance_; }
+
+    const std::string& Name(Index node) const;
+
+    // Nodes in the same order as Node::PostOrderIterator.
+    const std::vector<Index>& PostOrder() const { return postorder_; }
+
+    // Nodes in the same order as Node::PreOrderIterator.
+    const std::vector<Index>& PreOrder() const { return preorder_; }
+
+    // Tree with the same topology, branch lengths and names, without annotations.
+    Tree::TreePtr ToTree() const;
+
+    // Throws std::invalid_argument if a parenthesis is unbalanced, a node or a branch
+    // length is missing, the root is followed by a comma or another node or text
+    // follows the terminating semicolon.
+    static CompactTreePtr FromNewick(std::string_view newick);
+
+    // Throws std::runtime_error listing the taxa missing from taxonNames or from the
+    // tree if taxonNames is not empty and they do not match, like Tree::FromNewick.
+    static CompactTreePtr FromNewick(
+        std::string_view newick, std::shared_ptr<std::vector<std::string>> taxonNames);
+
+    // Leaves are looked up in taxonSet, which can be shared by every tree of a file.
+    // If taxonSet is null the taxa are numbered in the order they appear in newick.
+    static CompactTreePtr FromNewick(std::string_view newick,
+                                     std::shared_ptr<const TaxonSet> taxonSet);
+
+   private:
+    size_t leafCount_ = 0;
+    std::vector<Index> parent_;
+    std::vector<Index> firstChild_;
+    std::vector<Index> nextSibling_;
+    std::vector<double> distance_;
+    std::vector<std::string> internalNames_;
+    std::vector<Index> postorder_;
+    std::vector<Index> preorder_;
+    std::shared_ptr<const std::vector<std::string>> taxonNames_;
+
+    // Exactly one of taxonSet and taxonNames is not null, the names of the taxa are
+    // appended to taxonNames.
+    static CompactTreePtr Parse(std::string_view newick,
+                                std::shared_ptr<const TaxonSet> taxonSet,
+                                std::shared_ptr<std::vector<std::string>> taxonNames);
+
+    void Resize(size_t leafCount, size_t nodeCount);
+
+    void BuildTraversals();
+};
+}  // namespace cladokit
@@ -0,0 +1,502 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/compressed_stream.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#ifdef CLADOKIT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CLADOKIT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using cladokit::CompressedIfstream;
+using cladokit::CompressedOfstream;
+using cladokit::CompressingStreamBuffer;
+using cladokit::Compression;
+using cladokit::DecompressingStreamBuffer;
+
+namespace cladokit {
+
+// Streaming decompressor. Decode consumes input and returns the number of bytes
+// written to output. It must be called with an empty input to get the data it could
+// not write when output was full.
+class DecompressingStreamBuffer::Decoder {
+   public:
+    virtual ~Decoder() = default;
+
+    virtual size_t Decode(std::string_view &input, char *output, size_t capacity) = 0;
+
+    // Whether the input decoded so far ends with a complete gzip member or zstd
+    // frame, i.e. the input is not truncated if it ends here.
+    virtual bool Finished() const = 0;
+
+    virtual void Reset() = 0;
+};
+
+// Streaming compressor writing to sink. With flush, everything encoded so far is
+// made decompressible and with finish the compressed stream is terminated.
+class CompressingStreamBuffer::Encoder {
+   public:
+    virtual ~Encoder() = default;
+
+    virtual void Encode(std::string_view input, bool flush, bool finish,
+                        std::ostream &sink) = 0;
+};
+}  // namespace cladokit
+
+namespace {
+using Decoder = DecompressingStreamBuffer::Decoder;
+using Encoder = CompressingStreamBuffer::Encoder;
+
+#ifdef CLADOKIT_HAVE_ZLIB
+class GzipDecoder : public Decoder {
+   public:
+    GzipDecoder() {
+        // 32 enables the detection of gzip and zlib headers
+        if (inflateInit2(&stream_, 15 + 32) != Z_OK) {
+            throw std::runtime_error("Cannot initialize gzip decompression");
+        }
+    }
+
+    ~GzipDecoder() override { inflateEnd(&stream_); }
+
+    size_t Decode(std::string_view &input, char *output, size_t capacity) override {
+        stream_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+        stream_.avail_in = static_cast<uInt>(input.size());
+        stream_.next_out = reinterpret_cast<Bytef *>(output);
+        stream_.avail_out = static_cast<uInt>(capacity);
+        while (stream_.avail_out > 0) {
+            if (stream_.avail_in > 0) finished_ = false;
+            int status = inflate(&stream_, Z_NO_FLUSH);
+            if (status == Z_STREAM_END) {
+                // the file can contain several gzip members
+                finished_ = true;
+                inflateReset(&stream_);
+                if (stream_.avail_in == 0) break;
+            } else if (status == Z_BUF_ERROR) {
+                break;
+            } else if (status != Z_OK) {
+                throw std::runtime_error("Corrupted gzip stream");
+            }
+        }
+        input.remove_prefix(input.size() - stream_.avail_in);
+        return capacity - stream_.avail_out;
+    }
+
+    bool Finished() const override { return finished_; }
+
+    void Reset() override {
+        inflateReset(&stream_);
+        finished_ = false;
+    }
+
+   private:
+    z_stream stream_{};
+    bool finished_ = false;
+};
+
+class GzipEncoder : public Encoder {
+   public:
+    explicit GzipEncoder(int level) {
+        // 16 writes a gzip header instead of a zlib header
+        if (deflateInit2(&stream_, level < 0 ? Z_DEFAULT_COMPRESSION : level, Z_DEFLATED,
+                         15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("Cannot initialize gzip compression");
+        }
+    }
+
+    ~GzipEncoder() override { deflateEnd(&stream_); }
+
+    void Encode(std::string_view input, bool flush, bool finish,
+                std::ostream &sink) override {
+        int mode = finish ? Z_FINISH : (flush ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+        stream_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+        stream_.avail_in = static_cast<uInt>(input.size());
+        char output[1 << 16];
+        int status;
+        do {
+            stream_.next_out = reinterpret_cast<Bytef *>(output);
+            stream_.avail_out = sizeof(output);
+            status = deflate(&stream_, mode);
+            if (status == Z_STREAM_ERROR) {
+                throw std::runtime_error("gzip compression failed");
+            }
+            sink.write(output, sizeof(output) - stream_.avail_out);
+        } while (stream_.avail_out == 0 || (finish && status != Z_STREAM_END));
+    }
+
+   private:
+    z_stream stream_{};
+};
+#endif
+
+#ifdef CLADOKIT_HAVE_ZSTD
+class ZstdDecoder : public Decoder {
+   public:
+    ZstdDecoder() : context_(ZSTD_createDCtx()) {
+        if (context_ == nullptr) {
+            throw std::runtime_error("Cannot initialize zstd decompression");
+        }
+    }
+
+    ~ZstdDecoder() override { ZSTD_freeDCtx(context_); }
+
+    size_t Decode(std::string_view &input, char *output, size_t capacity) override {
+        ZSTD_inBuffer in = {input.data(), input.size(), 0};
+        ZSTD_outBuffer out = {output, capacity, 0};
+        do {
+            size_t position = in.pos;
+            size_t status = ZSTD_decompressStream(context_, &out, &in);
+            if (ZSTD_isError(status)) {
+                throw std::runtime_error(std::string("Corrupted zstd stream: ") +
+                                         ZSTD_getErrorName(status));
+            }
+            // 0 once a frame is decoded and flushed, without input the status is a
+            // hint for the header of a next frame
+            if (status == 0) {
+                finished_ = true;
+            } else if (in.pos > position) {
+                finished_ = false;
+            }
+        } while (out.pos < out.size && in.pos < in.size);
+        input.remove_prefix(in.pos);
+        return out.pos;
+    }
+
+    bool Finished() const override { return finished_; }
+
+    void Reset() override {
+        ZSTD_DCtx_reset(context_, ZSTD_reset_session_only);
+        finished_ = false;
+    }
+
+   private:
+    ZSTD_DCtx *context_;
+    bool finished_ = false;
+};
+
+class ZstdEncoder : public Encoder {
+   public:
+    explicit ZstdEncoder(int level) : context_(ZSTD_createCCtx()) {
+        if (context_ == nullptr) {
+            throw std::runtime_error("Cannot initialize zstd compression");
+        }
+        if (level >= 0) {
+            ZSTD_CCtx_setParameter(context_, ZSTD_c_compressionLevel, level);
+        }
+    }
+
+    ~ZstdEncoder() override { ZSTD_freeCCtx(context_); }
+
+    void Encode(std::string_view input, bool flush, bool finish,
+                std::ostream &sink) override {
+        ZSTD_EndDirective mode =
+            finish ? ZSTD_e_end : (flush ? ZSTD_e_flush : ZSTD_e_continue);
+        ZSTD_inBuffer in = {input.data(), input.size(), 0};
+        char output[1 << 16];
+        size_t remaining;
+        do {
+            ZSTD_outBuffer out = {output, sizeof(output), 0};
+            remaining = ZSTD_compressStream2(context_, &out, &in, mode);
+            if (ZSTD_isError(remaining)) {
+                throw std::runtime_error(std::string("zstd compression failed: ") +
+                                         ZSTD_getErrorName(remaining));
+            }
+            sink.write(output, out.pos);
+        } while (in.pos < in.size || (mode != ZSTD_e_continue && remaining != 0));
+    }
+
+   private:
+    ZSTD_CCtx *context_;
+};
+#endif
+
+std::string Name(Compression compression) {
+    return compression == Compression::kGzip ? "gzip" : "zstd";
+}
+
+std::unique_ptr<Decoder> MakeDecoder(Compression compression) {
+#ifdef CLADOKIT_HAVE_ZLIB
+    if (compression == Compression::kGzip) return std::make_unique<GzipDecoder>();
+#endif
+#ifdef CLADOKIT_HAVE_ZSTD
+    if (compression == Compression::kZstd) return std::make_unique<ZstdDecoder>();
+#endif
+    throw std::runtime_error("Decompression not supported: " + Name(compression));
+}
+
+std::unique_ptr<Encoder> MakeEncoder(Compression compression, int level) {
+#ifdef CLADOKIT_HAVE_ZLIB
+    if (compression == Compression::kGzip) return std::make_unique<GzipEncoder>(level);
+#endif
+#ifdef CLADOKIT_HAVE_ZSTD
+    if (compression == Compression::kZstd) return std::make_unique<ZstdEncoder>(level);
+#endif
+    throw std::runtime_error("Compression not supported: " + Name(compression));
+}
+}  // namespace
+
+bool cladokit::CompressionSupported(Compression compression) {
+    switch (compression) {
+        case Compression::kNone:
+            return true;
+        case Compression::kGzip:
+#ifdef CLADOKIT_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case Compression::kZstd:
+#ifdef CLADOKIT_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+Compression cladokit::DetectCompression(std::istream &in) {
+    std::streambuf *buffer = in.rdbuf();
+    auto position = buffer->pubseekoff(0, std::ios_base::cur, std::ios_base::in);
+    unsigned char magic[4] = {0, 0, 0, 0};
+    std::streamsize count = buffer->sgetn(reinterpret_cast<char *>(magic), 4);
+    buffer->pubseekpos(position, std::ios_base::in);
+
+    if (count >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        return Compression::kGzip;
+    }
+    if (count == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f &&
+        magic[3] == 0xfd) {
+        return Compression::kZstd;
+    }
+    return Compression::kNone;
+}
+
+Compression cladokit::CompressionFromExtension(const std::filesystem::path &path) {
+    auto extension = path.extension();
+    if (extension == ".gz") return Compression::kGzip;
+    if (extension == ".zst") return Compression::kZstd;
+    return Compression::kNone;
+}
+
+DecompressingStreamBuffer::DecompressingStreamBuffer(std::istream &source,
+                                                     Compression compression)
+    : source_(source), decoder_(MakeDecoder(compression)) {
+    Start();
+}
+
+DecompressingStreamBuffer::~DecompressingStreamBuffer() { Stop(); }
+
+void DecompressingStreamBuffer::Start() {
+    stop_ = false;
+    finished_ = false;
+    error_ = nullptr;
+    thread_ = std::thread(&DecompressingStreamBuffer::ReadAhead, this);
+}
+
+void DecompressingStreamBuffer::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    blocks_.clear();
+}
+
+void DecompressingStreamBuffer::ReadAhead() {
+    try {
+        std::vector<char> input(kBlockSize);
+        std::string_view pending;
+        bool sourceEnd = false;
+        while (true) {
+            if (pending.empty() && !sourceEnd) {
+                source_.read(input.data(), input.size());
+                auto count = static_cast<size_t>(source_.gcount());
+                sourceEnd = count < input.size();
+                pending = std::string_view(input.data(), count);
+            }
+
+            std::vector<char> block(kBlockSize);
+            size_t pendingSize = pending.size();
+            size_t produced = decoder_->Decode(pending, block.data(), block.size());
+            if (produced > 0) {
+                block.resize(produced);
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock,
+                                [this] { return stop_ || blocks_.size() < kQueueSize; });
+                if (stop_) return;
+                blocks_.push_back(std::move(block));
+                condition_.notify_all();
+            } else if (pending.empty()) {
+                if (!sourceEnd) continue;
+                if (!decoder_->Finished()) {
+                    throw std::runtime_error("Truncated compressed stream");
+                }
+                break;
+            } else if (pending.size() == pendingSize) {
+                throw std::runtime_error("Corrupted compressed stream");
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+    condition_.notify_all();
+}
+
+DecompressingStreamBuffer::int_type DecompressingStreamBuffer::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] { return !blocks_.empty() || finished_; });
+    if (blocks_.empty()) {
+        if (error_) std::rethrow_exception(error_);
+        return traits_type::eof();
+    }
+    blockStart_ += current_.size();
+    current_ = std::move(blocks_.front());
+    blocks_.pop_front();
+    condition_.notify_all();
+    lock.unlock();
+
+    setg(current_.data(), current_.data(), current_.data() + current_.size());
+    return traits_type::to_int_type(*gptr());
+}
+
+DecompressingStreamBuffer::pos_type DecompressingStreamBuffer::seekoff(
+    off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode) {
+    if (direction == std::ios_base::cur) {
+        offset += static_cast<off_type>(blockStart_ + (gptr() - eback()));
+    } else if (direction != std::ios_base::beg) {
+        // the size of the decompressed content is unknown
+        return pos_type(off_type(-1));
+    }
+    return seekpos(pos_type(offset), mode);
+}
+
+DecompressingStreamBuffer::pos_type DecompressingStreamBuffer::seekpos(
+    pos_type position, std::ios_base::openmode mode) {
+    auto target = static_cast<off_type>(position);
+    if (!(mode & std::ios_base::in) || target < 0) {
+        return pos_type(off_type(-1));
+    }
+
+    if (static_cast<uint64_t>(target) < blockStart_) {
+        // decompress again from the beginning
+        Stop();
+        source_.clear();
+        source_.seekg(0, std::ios::beg);
+        decoder_->Reset();
+        current_.clear();
+        blockStart_ = 0;
+        setg(nullptr, nullptr, nullptr);
+        Start();
+    }
+
+    while (true) {
+        uint64_t blockEnd = blockStart_ + current_.size();
+        if (static_cast<uint64_t>(target) <= blockEnd) {
+            char *begin = current_.data();
+            setg(begin, begin + (target - blockStart_), begin + current_.size());
+            return position;
+        }
+        setg(egptr(), egptr(), egptr());
+        if (traits_type::eq_int_type(underflow(), traits_type::eof())) {
+            return pos_type(off_type(-1));
+        }
+    }
+}
+
+CompressingStreamBuffer::CompressingStreamBuffer(std::ostream &sink,
+                                                 Compression compression, int level)
+    : sink_(sink), encoder_(MakeEncoder(compression, level)), buffer_(kBlockSize) {
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+CompressingStreamBuffer::~CompressingStreamBuffer() {
+    try {
+        Finish();
+    } catch (const std::exception &) {
+        // destructors must not throw
+    }
+}
+
+void CompressingStreamBuffer::Finish() {
+    if (finished_) return;
+    encoder_->Encode(std::string_view(pbase(), pptr() - pbase()), false, true, sink_);
+    setp(buffer_.data(), buffer_.data());
+    finished_ = true;
+    sink_.flush();
+}
+
+CompressingStreamBuffer::int_type CompressingStreamBuffer::overflow(int_type c) {
+    if (finished_) return traits_type::eof();
+    encoder_->Encode(std::string_view(pbase(), pptr() - pbase()), false, false, sink_);
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return sink_ ? traits_type::not_eof(c) : traits_type::eof();
+}
+
+int CompressingStreamBuffer::sync() {
+    if (finished_) return 0;
+    encoder_->Encode(std::string_view(pbase(), pptr() - pbase()), true, false, sink_);
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+    sink_.flush();
+    return sink_ ? 0 : -1;
+}
+
+CompressedIfstream::CompressedIfstream(const std::filesystem::path &path)
+    : std::istream(nullptr), file_(path, std::ios::binary) {
+    if (!file_) {
+        throw std::runtime_error("Cannot open file: " + path.string());
+    }
+    compression_ = DetectCompression(file_);
+    if (compression_ == Compression::kNone) {
+        rdbuf(file_.rdbuf());
+    } else {
+        buffer_ = std::make_unique<DecompressingStreamBuffer>(file_, compression_);
+        rdbuf(buffer_.get());
+    }
+    // errors of the decompression are thrown instead of only setting badbit
+    exceptions(std::ios::badbit);
+}
+
+CompressedOfstream::CompressedOfstream(const std::filesystem::path &path,
+                                       Compression compression, int level)
+    : std::ostream(nullptr), file_(path, std::ios::binary | std::ios::trunc) {
+    if (!file_) {
+        throw std::runtime_error("Cannot open file: " + path.string());
+    }
+    if (compression == Compression::kNone) {
+        rdbuf(file_.rdbuf());
+    } else {
+        buffer_ = std::make_unique<CompressingStreamBuffer>(file_, compression, level);
+        rdbuf(buffer_.get());
+    }
+}
+
+void CompressedOfstream::Close() {
+    if (buffer_) {
+        buffer_->Finish();
+    }
+    file_.close();
+}
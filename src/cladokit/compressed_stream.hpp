@@ -0,0 +1,156 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace cladokit {
+
+enum class Compression { kNone, kGzip, kZstd };
+
+// Whether the library was built with support for compression.
+bool CompressionSupported(Compression compression);
+
+// Compression of the content of in from its magic bytes. The position of in is
+// left unchanged.
+Compression DetectCompression(std::istream &in);
+
+// kGzip for .gz files, kZstd for .zst files and kNone otherwise.
+Compression CompressionFromExtension(const std::filesystem::path &path);
+
+// Stream buffer decompressing the content of a source stream. Blocks are decompressed
+// ahead of the reader on a background thread. Seeking is supported but seeking
+// backward decompresses the source again from its beginning. A corrupted or truncated
+// source is reported by throwing std::runtime_error from underflow, which an istream
+// only rethrows if badbit is in its exception mask.
+class DecompressingStreamBuffer : public std::streambuf {
+   public:
+    static constexpr size_t kBlockSize = 1 << 18;
+
+    // maximum number of decompressed blocks waiting to be read
+    static constexpr size_t kQueueSize = 4;
+
+    // Throws std::runtime_error if compression is not supported.
+    DecompressingStreamBuffer(std::istream &source, Compression compression);
+
+    ~DecompressingStreamBuffer() override;
+
+    DecompressingStreamBuffer(const DecompressingStreamBuffer &) = delete;
+
+    DecompressingStreamBuffer &operator=(const DecompressingStreamBuffer &) = delete;
+
+    // Codec specific decompressor, defined in the source file.
+    class Decoder;
+
+   protected:
+    int_type underflow() override;
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+                     std::ios_base::openmode mode) override;
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode mode) override;
+
+   private:
+    void Start();
+
+    void Stop();
+
+    // Body of the background thread.
+    void ReadAhead();
+
+    std::istream &source_;
+    std::unique_ptr<Decoder> decoder_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::vector<char>> blocks_;
+    bool finished_ = false;
+    bool stop_ = false;
+    std::exception_ptr error_;
+    std::vector<char> current_;  // block being read
+    uint64_t blockStart_ = 0;    // offset of current_ in the decompressed content
+};
+
+// Stream buffer compressing everything written to it into a sink stream. sync makes
+// everything written so far decompressible. The compressed stream is terminated by
+// Finish or on destruction.
+class CompressingStreamBuffer : public std::streambuf {
+   public:
+    static constexpr size_t kBlockSize = 1 << 18;
+
+    // level is the compression level of the codec, -1 selects its default.
+    // Throws std::runtime_error if compression is not supported.
+    CompressingStreamBuffer(std::ostream &sink, Compression compression, int level = -1);
+
+    ~CompressingStreamBuffer() override;
+
+    CompressingStreamBuffer(const CompressingStreamBuffer &) = delete;
+
+    CompressingStreamBuffer &operator=(const CompressingStreamBuffer &) = delete;
+
+    // Codec specific compressor, defined in the source file.
+    class Encoder;
+
+    void Finish();
+
+   protected:
+    int_type overflow(int_type c) override;
+
+    int sync() override;
+
+   private:
+    std::ostream &sink_;
+    std::unique_ptr<Encoder> encoder_;
+    std::vector<char> buffer_;
+    bool finished_ = false;
+};
+
+// Input file stream decompressing gzip and zstd files, detected from their magic
+// bytes. Files that are not compressed are read directly. badbit is in the exception
+// mask so that reading a corrupted or truncated file throws std::runtime_error.
+class CompressedIfstream : public std::istream {
+   public:
+    // Throws std::runtime_error if the file cannot be opened.
+    explicit CompressedIfstream(const std::filesystem::path &path);
+
+    Compression GetCompression() const { return compression_; }
+
+   private:
+    std::ifstream file_;
+    Compression compression_ = Compression::kNone;
+    std::unique_ptr<DecompressingStreamBuffer> buffer_;
+};
+
+// Output file stream compressing what is written to it, by default according to the
+// extension of the file.
+class CompressedOfstream : public std::ostream {
+   public:
+    // Throws std::runtime_error if the file cannot be opened.
+    explicit CompressedOfstream(const std::filesystem::path &path)
+        : CompressedOfstream(path, CompressionFromExtension(path)) {}
+
+    CompressedOfstream(const std::filesystem::path &path, Compression compression,
+                       int level = -1);
+
+    // Terminate the compressed stream, nothing can be written afterwards.
+    void Close();
+
+   private:
+    std::ofstream file_;
+    std::unique_ptr<CompressingStreamBuffer> buffer_;
+};
+}  // namespace cladokit
@@ -0,0 +1,92 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/mapped_file.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CLADOKIT_HAVE_MMAP 1
+#endif
+
+using cladokit::MappedFile;
+using cladokit::MappedStream;
+using cladokit::ViewStreamBuffer;
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+#ifdef CLADOKIT_HAVE_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + path.string());
+    }
+    struct stat status;
+    if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+        size_t size = static_cast<size_t>(status.st_size);
+        void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            madvise(address, size, MADV_SEQUENTIAL);
+            data_ = static_cast<const char *>(address);
+            size_ = size;
+            mapped_ = true;
+        }
+    }
+    close(fd);
+    if (mapped_) return;
+#endif
+    // files that cannot be mapped are read into memory
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open file: " + path.string());
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile() {
+#ifdef CLADOKIT_HAVE_MMAP
+    if (mapped_) {
+        munmap(const_cast<char *>(data_), size_);
+    }
+#endif
+}
+
+ViewStreamBuffer::ViewStreamBuffer(std::string_view view) {
+    // the get area is never written to
+    char *begin = const_cast<char *>(view.data());
+    setg(begin, begin, begin + view.size());
+}
+
+ViewStreamBuffer::pos_type ViewStreamBuffer::seekoff(off_type offset,
+                                                     std::ios_base::seekdir direction,
+                                                     std::ios_base::openmode mode) {
+    if (!(mode & std::ios_base::in)) return pos_type(off_type(-1));
+    off_type position = offset;
+    if (direction == std::ios_base::cur) {
+        position += gptr() - eback();
+    } else if (direction == std::ios_base::end) {
+        position += egptr() - eback();
+    }
+    if (position < 0 || position > egptr() - eback()) return pos_type(off_type(-1));
+    setg(eback(), eback() + position, egptr());
+    return pos_type(position);
+}
+
+ViewStreamBuffer::pos_type ViewStreamBuffer::seekpos(pos_type position,
+                                                     std::ios_base::openmode mode) {
+    return seekoff(off_type(position), std::ios_base::beg, mode);
+}
+
+size_t MappedStream::StreamPosition() {
+    if (!stream_.good()) {
+        stream_.clear();
+        return file_.Size();
+    }
+    return static_cast<size_t>(stream_.tellg());
+}
@@ -0,0 +1,77 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <istream>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+namespace cladokit {
+
+// Read-only view of the content of a file. The file is memory mapped with a
+// sequential access hint on POSIX systems and read into memory otherwise.
+class MappedFile {
+   public:
+    // Throws std::runtime_error if the file cannot be opened.
+    explicit MappedFile(const std::filesystem::path &path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *Data() const { return data_; }
+
+    size_t Size() const { return size_; }
+
+    std::string_view View() const { return std::string_view(data_, size_); }
+
+   private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> buffer_;  // content of the file when it is not mapped
+};
+
+// Stream buffer reading a view without copying it. Supports seekg and tellg.
+class ViewStreamBuffer : public std::streambuf {
+   public:
+    explicit ViewStreamBuffer(std::string_view view);
+
+   protected:
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+                     std::ios_base::openmode mode) override;
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode mode) override;
+};
+
+// Mapped file and a stream reading it. Tree files backed by a mapped file inherit
+// from it before TreeFile so that the stream exists when TreeFile is constructed.
+class MappedStream {
+   protected:
+    explicit MappedStream(const std::filesystem::path &path)
+        : file_(path), buffer_(file_.View()), stream_(&buffer_) {}
+
+    // Position of stream_ in file_, the size of the file once the end was reached.
+    size_t StreamPosition();
+
+    MappedFile file_;
+    ViewStreamBuffer buffer_;
+    std::istream stream_;
+};
+
+// Line of text starting at position without the line feed. position is moved to the
+// beginning of the next line.
+inline std::string_view NextLine(std::string_view text, size_t &position) {
+    size_t end = text.find('\n', position);
+    if (end == std::string_view::npos) end = text.size();
+    std::string_view line = text.substr(position, end - position);
+    position = end < text.size() ? end + 1 : end;
+    return line;
+}
+}  // namespace cladokit
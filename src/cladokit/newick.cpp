@@ -5,17 +5,25 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "cladokit/tree.hpp"
 #include "cladokit/treeio.hpp"
 
+using cladokit::MappedNewickFile;
 using cladokit::NewickFile;
 using cladokit::Node;
+using cladokit::NodeArena;
+using cladokit::TaxonSet;
 using cladokit::Tree;
+using cladokit::TreeIndex;
 using std::string;
 using std::vector;
 
 size_t NewickFile::Count() {
+    if (index_) return index_->Count();
     if (count_ > 0) return count_;
 
     string buffer;
@@ -33,10 +41,20 @@ size_t NewickFile::Count() {
 vector<std::shared_ptr<Tree>> NewickFile::Parse() {
     vector<std::shared_ptr<Tree>> trees;
     string buffer;
+    if (threadCount_ != 1) {
+        vector<string> lines;
+        while (!in_.eof()) {
+            std::getline(in_, buffer, '\n');
+            if (buffer.size() > 0 && buffer.at(0) == '(') {
+                lines.push_back(buffer);
+            }
+        }
+        return ParseTrees(vector<std::string_view>(lines.begin(), lines.end()));
+    }
     while (!in_.eof()) {
         std::getline(in_, buffer, '\n');
         if (buffer.size() > 0 && buffer.at(0) == '(') {
-            auto tree = Tree::FromNewick(buffer, taxonNames_);
+            auto tree = ParseTree(buffer);
             trees.push_back(tree);
         }
     }
@@ -77,8 +95,120 @@ void NewickFile::SkipNext() {
 std::shared_ptr<Tree> NewickFile::Next() {
     std::shared_ptr<Tree> tree;
     if (HasNext()) {
-        tree = Tree::FromNewick(currentTreeString_, taxonNames_);
+        tree = ParseTree(currentTreeString_);
         currentTreeString_.clear();
     }
     return tree;
 }
+
+bool NewickFile::NextInto(Tree &tree) {
+    if (!HasNext()) return false;
+    ParseTreeInto(currentTreeString_, tree);
+    currentTreeString_.clear();
+    return true;
+}
+
+std::shared_ptr<Tree> NewickFile::ParseTree(std::string_view newick) {
+    // the taxon names are taken from the first tree when they were not provided
+    if (taxonNames_->empty()) {
+        auto tree = Tree::FromNewick(newick, taxonNames_, parseOptions_, arena_);
+        taxonSet_ = tree->Taxa();
+        return tree;
+    }
+    return Tree::FromNewick(newick, Taxa(), parseOptions_, arena_);
+}
+
+void NewickFile::ParseTreeInto(std::string_view newick, Tree &tree) {
+    if (taxonNames_->empty()) {
+        tree = std::move(*ParseTree(newick));
+    } else {
+        tree.Rebuild(newick, Taxa(), parseOptions_, arena_);
+    }
+}
+
+vector<std::shared_ptr<Tree>> NewickFile::ParseTrees(
+    const vector<std::string_view> &newicks) {
+    return ParseStatements(
+        newicks, [this](std::string_view newick) { return ParseTree(newick); },
+        [this](std::string_view newick, const std::shared_ptr<const TaxonSet> &taxa,
+               const std::shared_ptr<NodeArena> &arena) {
+            return Tree::FromNewick(newick, taxa, parseOptions_, arena);
+        });
+}
+
+size_t MappedNewickFile::Count() {
+    if (index_) return index_->Count();
+    if (count_ > 0) return count_;
+
+    std::string_view text = file_.View();
+    for (size_t position = 0; position < text.size();) {
+        std::string_view line = NextLine(text, position);
+        if (!line.empty() && line.front() == '(') {
+            count_++;
+        }
+    }
+    return count_;
+}
+
+vector<std::shared_ptr<Tree>> MappedNewickFile::Parse() {
+    vector<std::shared_ptr<Tree>> trees;
+    if (threadCount_ != 1) {
+        vector<std::string_view> newicks;
+        while (HasNext()) {
+            newicks.push_back(currentTree_);
+            currentTree_ = std::string_view();
+        }
+        return ParseTrees(newicks);
+    }
+    while (HasNext()) {
+        trees.push_back(Next());
+    }
+    return trees;
+}
+
+bool MappedNewickFile::HasNext() {
+    if (!currentTree_.empty()) {
+        return true;
+    }
+    SkipNext();
+    return !currentTree_.empty();
+}
+
+// move to the next tree in the file
+void MappedNewickFile::SkipNext() {
+    std::string_view text = file_.View();
+    while (position_ < text.size()) {
+        currentTree_ = NextLine(text, position_);
+        if (!currentTree_.empty() && currentTree_.front() == '(') {
+            return;
+        }
+    }
+    currentTree_ = std::string_view();
+}
+
+std::shared_ptr<Tree> MappedNewickFile::Next() {
+    std::shared_ptr<Tree> tree;
+    if (HasNext()) {
+        tree = ParseTree(currentTree_);
+        currentTree_ = std::string_view();
+    }
+    return tree;
+}
+
+bool MappedNewickFile::NextInto(Tree &tree) {
+    if (!HasNext()) return false;
+    ParseTreeInto(currentTree_, tree);
+    currentTree_ = std::string_view();
+    return true;
+}
+
+void NewickFile::SeekTo(const TreeIndex::Entry &entry) {
+    in_.clear();
+    in_.seekg(entry.offset, std::ios::beg);
+    currentTreeString_.clear();
+}
+
+void MappedNewickFile::SeekTo(const TreeIndex::Entry &entry) {
+    position_ = entry.offset;
+    currentTree_ = std::string_view();
+}
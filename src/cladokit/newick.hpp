@@ -3,12 +3,15 @@
 
 #pragma once
 
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "cladokit/mapped_file.hpp"
 #include "cladokit/tree.hpp"
 #include "cladokit/treeio.hpp"
 
@@ -27,7 +30,52 @@ class NewickFile : public TreeFile {
 
     void SkipNext() override;
 
+    bool NextInto(Tree &tree) override;
+
+   protected:
+    void SeekTo(const TreeIndex::Entry &entry) override;
+
+    std::shared_ptr<Tree> ParseTree(std::string_view newick);
+
+    // Parse newick into tree, reusing its nodes once the taxa are known.
+    void ParseTreeInto(std::string_view newick, Tree &tree);
+
+    // Parse newick strings with ThreadCount() threads.
+    std::vector<std::shared_ptr<Tree>> ParseTrees(
+        const std::vector<std::string_view> &newicks);
+
    private:
     std::string currentTreeString_ = "";
 };
+
+// Newick file read from a memory mapped file. Trees are parsed in place without
+// copying the lines of the file.
+class MappedNewickFile : private MappedStream, public NewickFile {
+   public:
+    explicit MappedNewickFile(const std::filesystem::path &path)
+        : MappedStream(path), NewickFile(stream_) {}
+
+    MappedNewickFile(const std::filesystem::path &path,
+                     std::shared_ptr<std::vector<std::string>> taxonNames)
+        : MappedStream(path), NewickFile(stream_, taxonNames) {}
+
+    size_t Count() override;
+
+    std::vector<std::shared_ptr<Tree>> Parse() override;
+
+    std::shared_ptr<Tree> Next() override;
+
+    bool HasNext() override;
+
+    void SkipNext() override;
+
+    bool NextInto(Tree &tree) override;
+
+   protected:
+    void SeekTo(const TreeIndex::Entry &entry) override;
+
+   private:
+    size_t position_ = 0;  // beginning of the next line
+    std::string_view currentTree_;
+};
 }  // namespace cladokit
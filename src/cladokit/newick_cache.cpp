@@ -0,0 +1,92 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/newick_cache.hpp"
+
+#include <atomic>
+#include <string>
+#include <utility>
+
+#include "cladokit/node.hpp"
+
+using cladokit::NewickCache;
+using cladokit::Node;
+using std::string;
+
+NewickCache::NewickCache(const NewickExportOptions &options) : writer_(options) {}
+
+const string &NewickCache::Update(Node &root) {
+    std::swap(previous_, current_);
+    current_.clear();
+    uint64_t previousGeneration = generation_;
+    generation_ = NextGeneration();
+    formattedCount_ = 0;
+
+    stack_.clear();
+    Enter(root, PreviousStart(root, kUnknown, previousGeneration), 0);
+    while (!stack_.empty()) {
+        Frame &frame = stack_.back();
+        const auto &children = frame.node->children_;
+        if (frame.next < children.size()) {
+            current_ += frame.next == 0 ? '(' : ',';
+            Node &child = *children[frame.next++];
+            size_t parentStart = frame.start;
+            // Enter can reallocate the stack
+            Enter(child, PreviousStart(child, frame.previousStart, previousGeneration),
+                  parentStart);
+        } else {
+            if (!children.empty()) current_ += ')';
+            writer_.AppendSuffix(*frame.node, current_);
+            Node::NewickSpan &span = frame.node->newickSpan_;
+            size_t parentStart = stack_.size() > 1 ? stack_[stack_.size() - 2].start : 0;
+            span.offset = frame.start - parentStart;
+            span.length = current_.size() - frame.start;
+            span.generation = generation_;
+            span.valid = true;
+            span.absolute = false;
+            formattedCount_++;
+            stack_.pop_back();
+        }
+    }
+
+    // the root is the only node positioned from the start of the buffer
+    Node::NewickSpan &span = root.newickSpan_;
+    span.offset = 0;
+    span.generation = generation_;
+    span.absolute = true;
+    current_ += ';';
+    return current_;
+}
+
+const string &NewickCache::Rebuild(Node &root) {
+    generation_ = 0;
+    return Update(root);
+}
+
+size_t NewickCache::PreviousStart(const Node &node, size_t parentStart,
+                                  uint64_t previousGeneration) const {
+    const Node::NewickSpan &span = node.newickSpan_;
+    if (span.generation == 0 || previousGeneration == 0) return kUnknown;
+    if (span.absolute) {
+        return span.generation == previousGeneration ? span.offset : kUnknown;
+    }
+    return parentStart == kUnknown ? kUnknown : parentStart + span.offset;
+}
+
+void NewickCache::Enter(Node &node, size_t previousStart, size_t parentStart) {
+    size_t start = current_.size();
+    Node::NewickSpan &span = node.newickSpan_;
+    if (span.valid && previousStart != kUnknown) {
+        current_.append(previous_, previousStart, span.length);
+        span.offset = start - parentStart;
+        span.absolute = false;
+        return;
+    }
+    stack_.push_back({&node, 0, start, previousStart});
+}
+
+uint64_t NewickCache::NextGeneration() {
+    // unique across caches so that a node cached by another cache is not reused
+    static std::atomic<uint64_t> generation(0);
+    return ++generation;
+}
@@ -0,0 +1,68 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cladokit/newick_options.hpp"
+#include "cladokit/newick_writer.hpp"
+
+namespace cladokit {
+class Node;
+
+// Newick string of a tree updated incrementally. Every node records the position of
+// the string of its subtree in the previous string, relative to its parent, so that
+// the subtrees that were not modified since are copied instead of formatted again.
+// Update formats the modified nodes, i.e. the nodes on the paths from the changes
+// to the root, and copies the rest of the string.
+// The nodes must only be modified through the Node API, or InvalidateNewick must be
+// called after the change. A node can only be cached by one NewickCache at a time.
+class NewickCache {
+   public:
+    explicit NewickCache(const NewickExportOptions &options = NewickExportOptions());
+
+    const NewickExportOptions &Options() const { return writer_.Options(); }
+
+    // Newick string of the tree rooted at root followed by a semicolon, valid until
+    // the next call.
+    const std::string &Update(Node &root);
+
+    // Same as Update but all the nodes are formatted.
+    const std::string &Rebuild(Node &root);
+
+    // Number of nodes formatted by the last call to Update.
+    size_t FormattedCount() const { return formattedCount_; }
+
+   private:
+    // Node being written, index of its next child, start of its string in current_
+    // and in previous_ (kUnknown if it is not there).
+    struct Frame {
+        Node *node;
+        size_t next;
+        size_t start;
+        size_t previousStart;
+    };
+
+    static constexpr size_t kUnknown = static_cast<size_t>(-1);
+
+    NewickWriter writer_;
+    std::string previous_;
+    std::string current_;
+    uint64_t generation_ = 0;
+    size_t formattedCount_ = 0;
+    std::vector<Frame> stack_;
+
+    // Start of the string of node in previous_ given the start of its parent.
+    size_t PreviousStart(const Node &node, size_t parentStart,
+                         uint64_t previousGeneration) const;
+
+    // Copy the string of node if it is up to date, otherwise push node on the stack.
+    void Enter(Node &node, size_t previousStart, size_t parentStart);
+
+    static uint64_t NextGeneration();
+};
+}  // namespace cladokit
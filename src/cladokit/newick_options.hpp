@@ -3,11 +3,33 @@
 
 #pragma once
 
+#include <any>
+#include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace cladokit {
+class TranslateTable;
+
+using Converter = std::function<std::any(const std::string&)>;
+
+struct NewickParseOptions {
+    // Decode the annotations of node and branch comments while parsing.
+    bool parseAnnotations = false;
+    // Only decode these keys, all the keys are decoded if empty.
+    std::vector<std::string> annotationKeys;
+    // Values of keys without converter are stored as strings.
+    std::unordered_map<std::string, Converter> converters;
+    // Keep the raw comments in the nodes (see Node::Comment and Node::BranchComment).
+    bool keepRawComments = true;
+    // Leaf labels are tokens of this table, leaves are named after the taxon they
+    // translate to. Ignored unless the tree is parsed with the taxon set of the table.
+    std::shared_ptr<const TranslateTable> translate;
+};
+
 struct NewickExportOptions {
     bool includeInternalNodeName = false;
     bool includeBranchLengths = true;
@@ -15,6 +37,9 @@ struct NewickExportOptions {
     std::vector<std::string> annotationKeys;
     std::vector<std::string> branchAnnotationKeys;
     int decimalPrecision = -1;  // -1 means no precision limit
+    // Write the shortest branch lengths that are parsed back to the same value
+    // instead of 6 significant digits. Ignored if decimalPrecision is set.
+    bool roundTripBranchLengths = false;
 
     NewickExportOptions() = default;
 
@@ -0,0 +1,277 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/newick_stream_parser.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using cladokit::NewickStreamParser;
+using cladokit::StreamingNewickFile;
+using cladokit::TaxonSet;
+using cladokit::Tree;
+using std::string;
+using std::vector;
+using TokenType = cladokit::NewickTokenizer::TokenType;
+
+namespace {
+inline bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+inline bool IsDelimiter(char c) {
+    return c == '(' || c == ')' || c == ',' || c == ':' || c == ';' || c == '[';
+}
+
+// Unquoted labels can contain spaces, only the trailing ones are removed.
+inline std::string_view TrimRight(std::string_view label) {
+    while (!label.empty() && IsSpace(label.back())) label.remove_suffix(1);
+    return label;
+}
+}  // namespace
+
+NewickStreamParser::NewickStreamParser(std::shared_ptr<vector<string>> taxonNames,
+                                       const cladokit::NewickParseOptions &options,
+                                       std::shared_ptr<cladokit::NodeArena> arena)
+    : taxonNames_(std::move(taxonNames)), options_(options), arena_(std::move(arena)) {}
+
+NewickStreamParser::NewickStreamParser(CountOnly) : build_(false) {}
+
+void NewickStreamParser::Feed(std::string_view chunk) {
+    size_t i = 0;
+    size_t size = chunk.size();
+    while (i < size) {
+        switch (state_) {
+            case State::kLabel: {
+                size_t end = i;
+                while (end < size && !IsDelimiter(chunk[end])) end++;
+                pending_.append(chunk.data() + i, end - i);
+                i = end;
+                if (i < size) {
+                    state_ = State::kDefault;
+                    Emit(TokenType::kLabel, TrimRight(pending_));
+                    pending_.clear();
+                }
+                break;
+            }
+            case State::kQuotedLabel: {
+                if (quoteClosed_) {
+                    quoteClosed_ = false;
+                    if (chunk[i] != quote_) {
+                        state_ = State::kDefault;
+                        Emit(TokenType::kLabel, pending_);
+                        pending_.clear();
+                        break;
+                    }
+                    // doubled quote
+                    pending_.push_back(chunk[i++]);
+                }
+                size_t end = chunk.find(quote_, i);
+                if (end == std::string_view::npos) {
+                    pending_.append(chunk.data() + i, size - i);
+                    i = size;
+                } else {
+                    pending_.append(chunk.data() + i, end + 1 - i);
+                    i = end + 1;
+                    quoteClosed_ = true;
+                }
+                break;
+            }
+            case State::kComment: {
+                size_t end = chunk.find(']', i);
+                if (end == std::string_view::npos) {
+                    pending_.append(chunk.data() + i, size - i);
+                    i = size;
+                } else {
+                    pending_.append(chunk.data() + i, end + 1 - i);
+                    i = end + 1;
+                    state_ = State::kDefault;
+                    Emit(TokenType::kComment, pending_);
+                    pending_.clear();
+                }
+                break;
+            }
+            case State::kDefault: {
+                char c = chunk[i];
+                switch (c) {
+                    case ' ':
+                    case '\t':
+                    case '\n':
+                    case '\r':
+                        i++;
+                        break;
+                    case '(':
+                        Emit(TokenType::kOpen, chunk.substr(i++, 1));
+                        break;
+                    case ')':
+                        Emit(TokenType::kClose, chunk.substr(i++, 1));
+                        break;
+                    case ',':
+                        Emit(TokenType::kComma, chunk.substr(i++, 1));
+                        break;
+                    case ':':
+                        Emit(TokenType::kColon, chunk.substr(i++, 1));
+                        break;
+                    case ';':
+                        Emit(TokenType::kSemicolon, chunk.substr(i++, 1));
+                        break;
+                    case '[': {
+                        size_t end = chunk.find(']', i);
+                        if (end == std::string_view::npos) {
+                            state_ = State::kComment;
+                            pending_.assign(chunk.data() + i, size - i);
+                            i = size;
+                        } else {
+                            Emit(TokenType::kComment, chunk.substr(i, end + 1 - i));
+                            i = end + 1;
+                        }
+                        break;
+                    }
+                    case '\'':
+                    case '"':
+                        state_ = State::kQuotedLabel;
+                        quote_ = c;
+                        pending_.assign(1, c);
+                        i++;
+                        break;
+                    default: {
+                        size_t end = i;
+                        while (end < size && !IsDelimiter(chunk[end])) end++;
+                        if (end == size) {
+                            // the label may continue in the next chunk
+                            state_ = State::kLabel;
+                            pending_.assign(chunk.data() + i, size - i);
+                        } else {
+                            Emit(TokenType::kLabel, TrimRight(chunk.substr(i, end - i)));
+                        }
+                        i = end;
+                        break;
+                    }
+                }
+                break;
+            }
+        }
+    }
+}
+
+void NewickStreamParser::Finish() {
+    if (state_ == State::kLabel || (state_ == State::kQuotedLabel && quoteClosed_)) {
+        state_ = State::kDefault;
+        quoteClosed_ = false;
+        Emit(TokenType::kLabel, TrimRight(pending_));
+        pending_.clear();
+    } else if (state_ == State::kQuotedLabel) {
+        throw std::invalid_argument("Unterminated quoted label at end of input");
+    } else if (state_ == State::kComment) {
+        throw std::invalid_argument("Unterminated comment at end of input");
+    }
+
+    if (inTree_) {
+        if (build_ && !builder_->Complete()) {
+            throw std::invalid_argument("Incomplete tree at end of input");
+        }
+        // the semicolon of the last tree is optional
+        Emit(TokenType::kSemicolon, ";");
+    }
+}
+
+std::shared_ptr<Tree> NewickStreamParser::Take() {
+    if (trees_.empty()) return nullptr;
+    auto tree = std::move(trees_.front());
+    trees_.pop_front();
+    return tree;
+}
+
+void NewickStreamParser::Emit(TokenType type, std::string_view text) {
+    if (!inTree_) {
+        // skip the text preceding the tree
+        if (type != TokenType::kOpen) return;
+        inTree_ = true;
+        if (build_) {
+            if (!taxonSet_ && !taxonNames_->empty()) {
+                taxonSet_ = std::make_shared<TaxonSet>(*taxonNames_);
+            }
+            builder_.emplace(taxonSet_, taxonSet_ ? nullptr : taxonNames_, options_,
+                             arena_);
+        }
+    }
+
+    if (type == TokenType::kSemicolon) {
+        inTree_ = false;
+        count_++;
+        if (build_) {
+            auto tree = builder_->Build();
+            builder_.reset();
+            // the taxa of the first tree are used for the next trees
+            taxonSet_ = tree->Taxa();
+            trees_.push_back(std::move(tree));
+        }
+    } else if (build_) {
+        builder_->Add({type, text});
+    }
+}
+
+size_t NewickStreamParser::CountTrees(std::istream &in) {
+    NewickStreamParser parser{CountOnly()};
+    vector<char> chunk(StreamingNewickFile::kChunkSize);
+    while (in) {
+        in.read(chunk.data(), chunk.size());
+        parser.Feed(std::string_view(chunk.data(), in.gcount()));
+    }
+    parser.Finish();
+    return parser.count_;
+}
+
+NewickStreamParser &StreamingNewickFile::Parser() {
+    if (!parser_) {
+        parser_ =
+            std::make_unique<NewickStreamParser>(taxonNames_, parseOptions_, arena_);
+        chunk_.resize(kChunkSize);
+    }
+    return *parser_;
+}
+
+size_t StreamingNewickFile::Count() {
+    if (count_ > 0) return count_;
+
+    // the parser may already have read past the trees it returned, up to the end of
+    // the stream, so count from the beginning and restore the position and state
+    auto state = in_.rdstate();
+    in_.clear();
+    auto position = in_.tellg();
+    in_.seekg(0, std::ios::beg);
+    count_ = NewickStreamParser::CountTrees(in_);
+    in_.clear();
+    in_.seekg(position, std::ios::beg);
+    in_.setstate(state);
+    return count_;
+}
+
+vector<std::shared_ptr<Tree>> StreamingNewickFile::Parse() {
+    vector<std::shared_ptr<Tree>> trees;
+    while (HasNext()) {
+        trees.push_back(Next());
+    }
+    return trees;
+}
+
+bool StreamingNewickFile::HasNext() {
+    NewickStreamParser &parser = Parser();
+    while (parser.Available() == 0 && in_) {
+        in_.read(chunk_.data(), chunk_.size());
+        parser.Feed(std::string_view(chunk_.data(), in_.gcount()));
+        if (!in_) {
+            parser.Finish();
+        }
+    }
+    return parser.Available() > 0;
+}
+
+std::shared_ptr<Tree> StreamingNewickFile::Next() {
+    if (!HasNext()) return nullptr;
+    return Parser().Take();
+}
+
+void StreamingNewickFile::SkipNext() { Next(); }
@@ -0,0 +1,118 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cladokit/newick_options.hpp"
+#include "cladokit/newick_tokenizer.hpp"
+#include "cladokit/newick_tree_builder.hpp"
+#include "cladokit/node_arena.hpp"
+#include "cladokit/taxon_set.hpp"
+#include "cladokit/tree.hpp"
+#include "cladokit/treeio.hpp"
+
+namespace cladokit {
+
+// Incremental newick parser fed with chunks of text split at arbitrary positions.
+// Trees can span several lines and are terminated by a semicolon. Tokens split
+// between two chunks are copied, other tokens are read in place, so the memory used
+// is bounded by the tree being built rather than by the size of the input.
+// Text outside trees, before their first parenthesis, is skipped.
+class NewickStreamParser {
+   public:
+    // If taxonNames is empty it is filled with the taxa of the first tree, in the
+    // order they appear. The taxa of the first tree are used for the other trees.
+    explicit NewickStreamParser(
+        std::shared_ptr<std::vector<std::string>> taxonNames =
+            std::make_shared<std::vector<std::string>>(),
+        const NewickParseOptions &options = NewickParseOptions(),
+        std::shared_ptr<NodeArena> arena = nullptr);
+
+    NewickStreamParser(const NewickStreamParser &) = delete;
+
+    NewickStreamParser &operator=(const NewickStreamParser &) = delete;
+
+    // Parse chunk, which does not need to outlive the call. Throws
+    // std::invalid_argument if a tree is malformed.
+    void Feed(std::string_view chunk);
+
+    // Signal the end of the input. Throws std::invalid_argument if a tree, a comment
+    // or a quoted label is not terminated.
+    void Finish();
+
+    // Number of trees parsed and not taken yet.
+    size_t Available() const { return trees_.size(); }
+
+    // Oldest tree not taken yet, or nullptr if there is none.
+    std::shared_ptr<Tree> Take();
+
+    // Count the trees of in without building them.
+    static size_t CountTrees(std::istream &in);
+
+   private:
+    enum class State { kDefault, kLabel, kQuotedLabel, kComment };
+
+    struct CountOnly {};
+
+    explicit NewickStreamParser(CountOnly);
+
+    void Emit(NewickTokenizer::TokenType type, std::string_view text);
+
+    std::shared_ptr<std::vector<std::string>> taxonNames_;
+    std::shared_ptr<const TaxonSet> taxonSet_;
+    NewickParseOptions options_;
+    std::shared_ptr<NodeArena> arena_;
+    std::optional<NewickTreeBuilder> builder_;
+    std::deque<std::shared_ptr<Tree>> trees_;
+
+    bool build_ = true;  // false when only counting trees
+    bool inTree_ = false;
+    size_t count_ = 0;
+
+    State state_ = State::kDefault;
+    char quote_ = 0;
+    bool quoteClosed_ = false;  // quoted label closed unless the next char is quote_
+    std::string pending_;       // beginning of a token split between chunks
+};
+
+// Newick file parsed incrementally from a stream read in chunks. Unlike NewickFile,
+// trees can span several lines and the stream does not need to be seekable unless
+// Count is called.
+class StreamingNewickFile : public TreeFile {
+   public:
+    static constexpr size_t kChunkSize = 1 << 16;
+
+    explicit StreamingNewickFile(std::istream &in) : TreeFile(in) {}
+
+    StreamingNewickFile(std::istream &in,
+                        std::shared_ptr<std::vector<std::string>> taxonNames)
+        : TreeFile(in, taxonNames) {}
+
+    // Number of trees from the beginning of the stream, whether or not trees were
+    // already read. Reads the stream once and restores its position.
+    size_t Count() override;
+
+    std::vector<std::shared_ptr<Tree>> Parse() override;
+
+    std::shared_ptr<Tree> Next() override;
+
+    bool HasNext() override;
+
+    void SkipNext() override;
+
+   private:
+    NewickStreamParser &Parser();
+
+    std::unique_ptr<NewickStreamParser> parser_;
+    std::vector<char> chunk_;
+};
+}  // namespace cladokit
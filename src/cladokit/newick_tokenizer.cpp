@@ -0,0 +1,110 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/newick_tokenizer.hpp"
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+using cladokit::NewickTokenizer;
+using std::string;
+
+namespace {
+inline bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+inline bool IsDelimiter(char c) {
+    return c == '(' || c == ')' || c == ',' || c == ':' || c == ';' || c == '[';
+}
+}  // namespace
+
+NewickTokenizer::Token NewickTokenizer::Next() {
+    while (position_ < newick_.size() && IsSpace(newick_[position_])) {
+        position_++;
+    }
+    if (position_ == newick_.size()) {
+        return {TokenType::kEnd, newick_.substr(position_)};
+    }
+
+    size_t start = position_;
+    char c = newick_[position_];
+    switch (c) {
+        case '(':
+            return {TokenType::kOpen, newick_.substr(position_++, 1)};
+        case ')':
+            return {TokenType::kClose, newick_.substr(position_++, 1)};
+        case ',':
+            return {TokenType::kComma, newick_.substr(position_++, 1)};
+        case ':':
+            return {TokenType::kColon, newick_.substr(position_++, 1)};
+        case ';':
+            return {TokenType::kSemicolon, newick_.substr(position_++, 1)};
+        case '[': {
+            size_t end = newick_.find(']', position_);
+            if (end == std::string_view::npos) {
+                throw std::invalid_argument("Unterminated comment at position " +
+                                            std::to_string(start));
+            }
+            position_ = end + 1;
+            return {TokenType::kComment, newick_.substr(start, position_ - start)};
+        }
+        case '\'':
+        case '"': {
+            // a doubled quote inside the label is an escaped quote
+            position_++;
+            while (true) {
+                size_t end = newick_.find(c, position_);
+                if (end == std::string_view::npos) {
+                    throw std::invalid_argument("Unterminated quoted label at position " +
+                                                std::to_string(start));
+                }
+                position_ = end + 1;
+                if (position_ == newick_.size() || newick_[position_] != c) break;
+                position_++;
+            }
+            return {TokenType::kLabel, newick_.substr(start, position_ - start)};
+        }
+        default: {
+            // unquoted labels can contain spaces, only the trailing ones are removed
+            while (position_ < newick_.size() && !IsDelimiter(newick_[position_])) {
+                position_++;
+            }
+            size_t end = position_;
+            while (IsSpace(newick_[end - 1])) end--;
+            return {TokenType::kLabel, newick_.substr(start, end - start)};
+        }
+    }
+}
+
+double NewickTokenizer::ParseNumber(std::string_view text) {
+    const char *first = text.data();
+    const char *last = text.data() + text.size();
+    // from_chars does not accept a plus sign
+    if (first != last && *first == '+') first++;
+    double value = 0;
+    auto [end, error] = std::from_chars(first, last, value);
+    if (error == std::errc::result_out_of_range) {
+        throw std::out_of_range("Number out of range: " + string(text));
+    }
+    if (error != std::errc() || end != last || first == last) {
+        throw std::invalid_argument("Invalid number: " + string(text));
+    }
+    return value;
+}
+
+string NewickTokenizer::Unquote(std::string_view label) {
+    if (label.size() < 2 || (label.front() != '\'' && label.front() != '"') ||
+        label.back() != label.front()) {
+        return string(label);
+    }
+    char quote = label.front();
+    string unquoted;
+    unquoted.reserve(label.size() - 2);
+    for (size_t i = 1; i + 1 < label.size(); i++) {
+        unquoted.push_back(label[i]);
+        if (label[i] == quote) i++;
+    }
+    return unquoted;
+}
@@ -0,0 +1,52 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace cladokit {
+
+// Splits a newick string into tokens that are views of the input, which must outlive
+// them. Labels can be quoted with single or double quotes, in which case they may
+// contain delimiters. Unquoted labels may contain whitespace, the whitespace around
+// tokens is skipped.
+class NewickTokenizer {
+   public:
+    enum class TokenType {
+        kOpen,       // (
+        kClose,      // )
+        kComma,      // ,
+        kColon,      // :
+        kSemicolon,  // ;
+        kComment,    // [...] including the brackets
+        kLabel,      // taxon name, internal node name or branch length
+        kEnd
+    };
+
+    struct Token {
+        TokenType type;
+        std::string_view text;
+    };
+
+    explicit NewickTokenizer(std::string_view newick) : newick_(newick) {}
+
+    // Throws std::invalid_argument if a comment or a quoted label is not terminated.
+    Token Next();
+
+    size_t Position() const { return position_; }
+
+    // Parse a branch length independently of the locale. Throws std::invalid_argument
+    // if text is not a number.
+    static double ParseNumber(std::string_view text);
+
+    // Remove the quotes around label and unescape doubled quotes.
+    static std::string Unquote(std::string_view label);
+
+   private:
+    std::string_view newick_;
+    size_t position_ = 0;
+};
+}  // namespace cladokit
@@ -0,0 +1,234 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/newick_tree_builder.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using cladokit::NewickTokenizer;
+using cladokit::NewickTreeBuilder;
+using cladokit::Node;
+using cladokit::TaxonSet;
+using cladokit::Tree;
+using std::string;
+using std::vector;
+using TokenType = cladokit::NewickTokenizer::TokenType;
+
+NewickTreeBuilder::NewickTreeBuilder(std::shared_ptr<const TaxonSet> taxonSet,
+                                     std::shared_ptr<vector<string>> taxonNames,
+                                     const cladokit::NewickParseOptions &options,
+                                     std::shared_ptr<cladokit::NodeArena> arena)
+    : taxonSet_(std::move(taxonSet)),
+      taxonNames_(std::move(taxonNames)),
+      options_(options),
+      arena_(std::move(arena)),
+      seen_(taxonSet_ ? taxonSet_->Size() : 0, false) {
+    if (options.translate && taxonSet_ && options.translate->Taxa() == taxonSet_) {
+        translate_ = options.translate.get();
+    }
+}
+
+void NewickTreeBuilder::Add(const NewickTokenizer::Token &token) {
+    if (afterColon_) {
+        // branch comment
+        if (token.type == TokenType::kComment) {
+            if (options_.keepRawComments) {
+                stack_.back()->SetBranchComment(string(token.text));
+            }
+            if (options_.parseAnnotations) {
+                stack_.back()->ParseBranchComment(token.text, options_.converters,
+                                                  options_.annotationKeys);
+            }
+            return;
+        }
+        if (token.type != TokenType::kLabel) {
+            throw std::invalid_argument("Missing branch length");
+        }
+        stack_.back()->SetDistance(NewickTokenizer::ParseNumber(token.text));
+        afterColon_ = false;
+        return;
+    }
+
+    switch (token.type) {
+        // node comment
+        case TokenType::kComment:
+            // e.g. [&R] before the tree
+            if (stack_.empty()) break;
+            if (options_.keepRawComments) {
+                stack_.back()->SetComment(string(token.text));
+            }
+            if (options_.parseAnnotations) {
+                stack_.back()->ParseComment(token.text, options_.converters,
+                                            options_.annotationKeys);
+            }
+            break;
+        case TokenType::kColon:
+            if (stack_.empty() || expectingNode_) {
+                throw std::invalid_argument("Branch length without node");
+            }
+            afterColon_ = true;
+            break;
+        case TokenType::kLabel:
+            if (justClosed_) {
+                stack_.back()->SetName(NewickTokenizer::Unquote(token.text));
+                justClosed_ = false;
+            } else {
+                CheckNodeExpected();
+                AddLeaf(token.text);
+                expectingNode_ = false;
+            }
+            break;
+        case TokenType::kOpen: {
+            CheckNodeExpected();
+            justClosed_ = false;
+            depth_++;
+            expectingNode_ = true;
+            auto node = NewNode(std::string_view(), TaxonSet::kNotFound);
+            if (!stack_.empty()) {
+                stack_.back()->AddChild(node);
+            } else if (!root_) {
+                root_ = node;
+            }
+            stack_.push_back(node);
+            break;
+        }
+        case TokenType::kClose:
+        case TokenType::kComma:
+            if (token.type == TokenType::kClose) {
+                if (depth_ == 0) {
+                    throw std::invalid_argument("Unbalanced closing parenthesis");
+                }
+                if (expectingNode_) {
+                    throw std::invalid_argument("Missing node before parenthesis");
+                }
+                depth_--;
+            } else {
+                // the root cannot have siblings
+                if (depth_ == 0) {
+                    throw std::invalid_argument("Comma outside of parentheses");
+                }
+                if (expectingNode_) {
+                    throw std::invalid_argument("Missing node before comma");
+                }
+                expectingNode_ = true;
+            }
+            if (!stack_.empty()) {
+                stack_.pop_back();
+            }
+            // check if there is a name after the closing parenthesis
+            justClosed_ = token.type == TokenType::kClose;
+            break;
+        default:
+            break;
+    }
+}
+
+void NewickTreeBuilder::CheckNodeExpected() const {
+    // a node starts the tree or follows an opening parenthesis or a comma
+    if (root_ && !expectingNode_) {
+        throw std::invalid_argument(depth_ == 0 ? "Unexpected text after the root"
+                                                : "Missing comma between nodes");
+    }
+}
+
+void NewickTreeBuilder::Recycle(vector<Node::NodePtr> *nodes, size_t leafCount) {
+    recycled_ = nodes;
+    recycledLeafCount_ = std::min(leafCount, nodes->size());
+    nextRecycled_ = recycledLeafCount_;
+}
+
+Node::NodePtr NewickTreeBuilder::NewNode(std::string_view name, size_t taxonIndex) {
+    if (recycled_) {
+        Node::NodePtr node;
+        // a leaf takes the node of the same taxon in the previous tree
+        if (taxonIndex < recycledLeafCount_) {
+            node = std::move((*recycled_)[taxonIndex]);
+        }
+        while (!node && nextRecycled_ < recycled_->size()) {
+            node = std::move((*recycled_)[nextRecycled_++]);
+        }
+        if (node) {
+            node->Reset(name);
+            return node;
+        }
+    }
+    return MakeNode(arena_, string(name));
+}
+
+void NewickTreeBuilder::AddLeaf(std::string_view label) {
+    // only quoted labels are copied
+    string unquoted;
+    std::string_view name = label;
+    if (!label.empty() && (label.front() == '\'' || label.front() == '"')) {
+        unquoted = NewickTokenizer::Unquote(label);
+        name = unquoted;
+    }
+
+    Node::NodePtr node;
+    size_t translated = translate_ ? translate_->IndexOf(name) : TaxonSet::kNotFound;
+    if (translated != TaxonSet::kNotFound) {
+        // the leaf gets its final name and id directly
+        node = NewNode(taxonSet_->Name(translated), translated);
+        node->SetId(translated);
+        seen_[translated] = true;
+    } else if (taxonSet_) {
+        size_t taxonIndex = taxonSet_->IndexOf(name);
+        node = NewNode(name, taxonIndex);
+        if (taxonIndex != TaxonSet::kNotFound) {
+            node->SetId(taxonIndex);
+            seen_[taxonIndex] = true;
+        } else {
+            missingTaxonNames_.push_back(node->Name());
+        }
+    } else {
+        node = NewNode(name, taxonNames_->size());
+        node->SetId(taxonNames_->size());
+        taxonNames_->push_back(node->Name());
+    }
+    if (!stack_.empty()) {
+        stack_.back()->AddChild(node);
+    } else if (!root_) {
+        root_ = node;
+    }
+    stack_.push_back(node);
+}
+
+Node::NodePtr NewickTreeBuilder::Finish() {
+    if (stack_.empty()) {
+        throw std::invalid_argument("Empty newick string");
+    }
+    if (depth_ > 0 || expectingNode_) {
+        throw std::invalid_argument("Incomplete newick string");
+    }
+
+    if (!taxonSet_) {
+        taxonSet_ = std::make_shared<TaxonSet>(*taxonNames_);
+    } else if (!missingTaxonNames_.empty() ||
+               std::find(seen_.begin(), seen_.end(), false) != seen_.end()) {
+        // thrown rather than printed since trees can be parsed by worker threads
+        std::ostringstream message;
+        message << "Error: taxon names do not match";
+        for (const auto &name : missingTaxonNames_) {
+            message << "\nMissing taxon name: " << name;
+        }
+        for (size_t i = 0; i < seen_.size(); i++) {
+            if (!seen_[i]) {
+                message << "\nExtra taxon name: " << taxonSet_->Name(i);
+            }
+        }
+        throw std::runtime_error(message.str());
+    }
+
+    // every node but the root was closed by a parenthesis or a comma
+    if (stack_.size() != 1 || stack_.front() != root_) {
+        throw std::invalid_argument("Incomplete newick string");
+    }
+    return root_;
+}
@@ -0,0 +1,96 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cladokit/newick_options.hpp"
+#include "cladokit/newick_tokenizer.hpp"
+#include "cladokit/node.hpp"
+#include "cladokit/node_arena.hpp"
+#include "cladokit/taxon_set.hpp"
+#include "cladokit/translate_table.hpp"
+#include "cladokit/tree.hpp"
+
+namespace cladokit {
+
+// Builds a tree from the tokens of a newick string added one at a time, so that the
+// tokens can come from a string or from a stream read in chunks. Only the nodes of
+// the tree are kept, the text of the tokens can be discarded once added.
+class NewickTreeBuilder {
+   public:
+    // Leaf ids are looked up in taxonSet. If taxonSet is null the taxa are numbered in
+    // the order they appear and their names are appended to taxonNames. options must
+    // outlive the builder.
+    NewickTreeBuilder(std::shared_ptr<const TaxonSet> taxonSet,
+                      std::shared_ptr<std::vector<std::string>> taxonNames,
+                      const NewickParseOptions &options,
+                      std::shared_ptr<NodeArena> arena = nullptr);
+
+    // Reuse the nodes of a previous tree instead of allocating new ones. nodes is
+    // indexed by node id, its first leafCount nodes are leaves. A leaf whose taxon
+    // index is i reuses nodes[i]. Reused nodes are replaced with nullptr in nodes.
+    void Recycle(std::vector<Node::NodePtr> *nodes, size_t leafCount);
+
+    // Throws std::invalid_argument if a branch length is missing or is not a number,
+    // if a parenthesis is unbalanced, if a node is missing or if the root is followed
+    // by a comma or by another node.
+    void Add(const NewickTokenizer::Token &token);
+
+    // Whether a node was created.
+    bool Started() const { return root_ != nullptr; }
+
+    // Whether every parenthesis is closed, no node is expected after a parenthesis or
+    // a comma and the last branch length was read.
+    bool Complete() const {
+        return stack_.size() == 1 && depth_ == 0 && !expectingNode_ && !afterColon_;
+    }
+
+    // Root of the tree built from the tokens. Throws std::invalid_argument if no node
+    // was created or if a parenthesis is not closed or a node is missing, and
+    // std::runtime_error listing the taxa missing from the taxon set or from the tree
+    // if they do not match.
+    Node::NodePtr Finish();
+
+    // Taxa of the tree, available after Finish.
+    const std::shared_ptr<const TaxonSet> &Taxa() const { return taxonSet_; }
+
+    // Throws std::invalid_argument if no node was created.
+    std::shared_ptr<Tree> Build() {
+        auto root = Finish();
+        return std::make_shared<Tree>(root, taxonSet_);
+    }
+
+   private:
+    // Throws std::invalid_argument if a new node cannot start here.
+    void CheckNodeExpected() const;
+
+    // label is unquoted before it is looked up.
+    void AddLeaf(std::string_view label);
+
+    // New node, recycled if possible. taxonIndex is the index of a leaf or kNotFound.
+    Node::NodePtr NewNode(std::string_view name, size_t taxonIndex);
+
+    std::shared_ptr<const TaxonSet> taxonSet_;
+    std::shared_ptr<std::vector<std::string>> taxonNames_;
+    const NewickParseOptions &options_;
+    std::shared_ptr<NodeArena> arena_;
+    const TranslateTable *translate_ = nullptr;  // used if it refers to taxonSet_
+    Node::NodePtr root_;
+    std::vector<Node::NodePtr> stack_;
+    bool justClosed_ = false;  // a label is the name of the node just closed
+    bool afterColon_ = false;  // expecting a branch comment or a branch length
+    size_t depth_ = 0;             // number of open parentheses
+    bool expectingNode_ = false;   // after an opening parenthesis or a comma
+    // taxa of taxonSet found and names missing from taxonSet
+    std::vector<bool> seen_;
+    std::vector<std::string> missingTaxonNames_;
+    std::vector<Node::NodePtr> *recycled_ = nullptr;
+    size_t recycledLeafCount_ = 0;
+    size_t nextRecycled_ = 0;  // next node of recycled_ that is not a leaf
+};
+}  // namespace cladokit
@@ -0,0 +1,209 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/newick_writer.hpp"
+
+#include <algorithm>
+#include <any>
+#include <charconv>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "cladokit/node.hpp"
+#include "cladokit/tree.hpp"
+
+using cladokit::AnnotationTable;
+using cladokit::NewickWriter;
+using cladokit::Node;
+using cladokit::Tree;
+using std::string;
+
+namespace {
+// Append value formatted by std::to_chars with the given format and precision, or
+// with the shortest representation if precision is negative.
+void AppendDouble(double value, std::chars_format format, int precision, string &out) {
+    char buffer[128];
+    auto result = precision < 0
+                      ? std::to_chars(buffer, buffer + sizeof(buffer), value, format)
+                      : std::to_chars(buffer, buffer + sizeof(buffer), value, format,
+                                      precision);
+    if (result.ec == std::errc()) {
+        out.append(buffer, result.ptr);
+        return;
+    }
+    // large values in fixed notation
+    string large(400 + static_cast<size_t>(std::max(precision, 0)), '\0');
+    result = precision < 0
+                 ? std::to_chars(large.data(), large.data() + large.size(), value, format)
+                 : std::to_chars(large.data(), large.data() + large.size(), value, format,
+                                 precision);
+    out.append(large.data(), result.ptr);
+}
+
+template <typename T>
+void AppendInteger(T value, string &out) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+}  // namespace
+
+void NewickWriter::Append(const Node &node, string &out) {
+    stack_.clear();
+    stack_.emplace_back(&node, 0);
+    while (!stack_.empty()) {
+        const Node *current = stack_.back().first;
+        size_t next = stack_.back().second;
+        const auto &children = current->children_;
+        if (next < children.size()) {
+            out += next == 0 ? '(' : ',';
+            stack_.back().second++;
+            stack_.emplace_back(children[next].get(), 0);
+        } else {
+            if (!children.empty()) out += ')';
+            AppendSuffix(*current, out);
+            stack_.pop_back();
+        }
+    }
+}
+
+void NewickWriter::Append(const Tree &tree, string &out) {
+    Append(*tree.Root(), out);
+    out += ';';
+}
+
+void NewickWriter::Write(const Node &node, std::ostream &os) {
+    buffer_.clear();
+    Append(node, buffer_);
+    os.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+}
+
+void NewickWriter::Write(const Tree &tree, std::ostream &os) {
+    buffer_.clear();
+    Append(tree, buffer_);
+    buffer_ += '\n';
+    os.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+}
+
+void NewickWriter::AppendFixed(double value, int precision, string &out) {
+    AppendDouble(value, std::chars_format::fixed, precision, out);
+}
+
+void NewickWriter::AppendLabel(const string &label, string &out) {
+    if (label.find_first_of(" \t\n\r()[],:;'\"") == string::npos) {
+        out += label;
+        return;
+    }
+    out += '\'';
+    for (char c : label) {
+        if (c == '\'') out += '\'';
+        out += c;
+    }
+    out += '\'';
+}
+
+void NewickWriter::AppendSuffix(const Node &node, string &out) const {
+    if (!node.children_.empty()) {
+        if (options_.includeInternalNodeName) AppendLabel(node.name_, out);
+    } else if (leafLabels_) {
+        out += leafLabels_->at(node.id_);
+    } else {
+        AppendLabel(node.name_, out);
+    }
+    AppendComment(node.comment_, node.annotations_, node.annotationTable_.get(), node.id_,
+                  options_.annotationKeys, out);
+    if (options_.includeBranchLengths && !std::isnan(node.distance_)) {
+        out += ':';
+        AppendComment(node.branchComment_, node.branchAnnotations_,
+                      node.branchAnnotationTable_.get(), node.id_,
+                      options_.branchAnnotationKeys, out);
+        AppendLength(node.distance_, out);
+    }
+}
+
+void NewickWriter::AppendLength(double distance, string &out) const {
+    if (options_.decimalPrecision > 0) {
+        AppendDouble(distance, std::chars_format::fixed, options_.decimalPrecision, out);
+    } else if (options_.roundTripBranchLengths) {
+        AppendDouble(distance, std::chars_format::general, -1, out);
+    } else {
+        // default precision of output streams
+        AppendDouble(distance, std::chars_format::general, 6, out);
+    }
+}
+
+void NewickWriter::AppendComment(const string &rawComment,
+                                 const std::map<string, std::any> &annotations,
+                                 const AnnotationTable *table, size_t row,
+                                 const std::vector<string> &keys, string &out) const {
+    if (options_.includeRawComment && !rawComment.empty()) {
+        out += rawComment;
+        return;
+    }
+    // like BuildCommentForNewick, annotations are only written if node annotation
+    // keys are requested
+    if (options_.annotationKeys.empty()) return;
+
+    size_t start = out.size();
+    out += "[&";
+    for (const auto &key : keys) {
+        if (table) {
+            auto id = table->Find(key);
+            if (id == AnnotationTable::kNoKey || !table->Contains(id, row)) continue;
+            switch (table->Type(id)) {
+                case AnnotationTable::ColumnType::kDouble:
+                    out += key;
+                    out += '=';
+                    AppendFixed(table->DoubleColumn(id)[row], 6, out);
+                    break;
+                case AnnotationTable::ColumnType::kInt:
+                    out += key;
+                    out += '=';
+                    AppendInteger(table->IntegerColumn(id)[row], out);
+                    break;
+                case AnnotationTable::ColumnType::kString:
+                    out += key;
+                    out += '=';
+                    out += table->StringColumn(id)[row];
+                    break;
+                default:
+                    AppendValue(key, table->Get(id, row), out);
+                    continue;
+            }
+        } else {
+            auto it = annotations.find(key);
+            if (it == annotations.end()) continue;
+            AppendValue(key, it->second, out);
+            continue;
+        }
+        out += ',';
+    }
+    if (out.size() == start + 2) {
+        out.resize(start);
+    } else {
+        out.back() = ']';
+    }
+}
+
+void NewickWriter::AppendValue(const string &key, const std::any &value, string &out) {
+    out += key;
+    out += '=';
+    if (value.type() == typeid(double)) {
+        AppendFixed(std::any_cast<double>(value), 6, out);
+    } else if (value.type() == typeid(int)) {
+        AppendInteger(std::any_cast<int>(value), out);
+    } else if (value.type() == typeid(string)) {
+        out += std::any_cast<const string &>(value);
+    } else {
+        std::cerr << "Warning: Unsupported type for annotation key '" << key
+                  << "'. Only double, int, and string are supported. "
+                  << value.type().name() << std::endl;
+        return;
+    }
+    out += ',';
+}
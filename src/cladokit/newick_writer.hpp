@@ -0,0 +1,84 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <any>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cladokit/annotation_table.hpp"
+#include "cladokit/newick_options.hpp"
+
+namespace cladokit {
+class Node;
+class Tree;
+
+// Writes newick strings without recursion by appending to a single buffer. The
+// output is the same as Node::Newick for the same options. Numbers are formatted
+// with std::to_chars: branch lengths like an output stream with the default
+// precision, with decimalPrecision digits after the decimal point or with the
+// shortest representation that reads back exactly (roundTripBranchLengths), and
+// annotations like std::to_string.
+// A writer can be reused for many trees, its traversal stack keeps its capacity.
+class NewickWriter {
+   public:
+    explicit NewickWriter(NewickExportOptions options = NewickExportOptions())
+        : options_(std::move(options)) {}
+
+    const NewickExportOptions &Options() const { return options_; }
+
+    // Write leaves as labels[Id()] instead of their name, e.g. the tokens of a Nexus
+    // translate table. Leaves are written with their name again if labels is null.
+    void SetLeafLabels(std::shared_ptr<const std::vector<std::string>> labels) {
+        leafLabels_ = std::move(labels);
+    }
+
+    // Append the newick string of the subtree rooted at node to out, without the
+    // terminating semicolon.
+    void Append(const Node &node, std::string &out);
+
+    // Append the newick string of tree to out, followed by a semicolon.
+    void Append(const Tree &tree, std::string &out);
+
+    void Write(const Node &node, std::ostream &os);
+
+    // Write the newick string of tree followed by a semicolon and a new line.
+    void Write(const Tree &tree, std::ostream &os);
+
+    // Append value with precision digits after the decimal point, like printf %.*f.
+    static void AppendFixed(double value, int precision, std::string &out);
+
+    // Append label between single quotes, doubling the quotes it contains, if it
+    // contains whitespace, quotes or newick delimiters.
+    static void AppendLabel(const std::string &label, std::string &out);
+
+   private:
+    friend class NewickCache;
+
+    NewickExportOptions options_;
+    std::shared_ptr<const std::vector<std::string>> leafLabels_;
+    // Node being written and index of its next child.
+    std::vector<std::pair<const Node *, size_t>> stack_;
+    std::string buffer_;
+
+    void AppendSuffix(const Node &node, std::string &out) const;
+
+    void AppendLength(double distance, std::string &out) const;
+
+    // Raw comment or annotations of keys, stored either in annotations or in row of
+    // table when table is not null.
+    void AppendComment(const std::string &rawComment,
+                       const std::map<std::string, std::any> &annotations,
+                       const AnnotationTable *table, size_t row,
+                       const std::vector<std::string> &keys, std::string &out) const;
+
+    static void AppendValue(const std::string &key, const std::any &value,
+                            std::string &out);
+};
+}  // namespace cladokit
@@ -3,20 +3,82 @@
 
 #include "cladokit/nexus.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <map>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "cladokit/newick_tokenizer.hpp"
+#include "cladokit/translate_table.hpp"
 #include "cladokit/tree.hpp"
 #include "cladokit/utils.hpp"
 
+using cladokit::MappedNexusFile;
+using cladokit::NewickTokenizer;
 using cladokit::NexusFile;
+using cladokit::NexusTreeHeader;
 using cladokit::Node;
+using cladokit::NodeArena;
+using cladokit::StatementScanner;
+using cladokit::TaxonSet;
+using cladokit::TranslateTable;
 using cladokit::Tree;
+using cladokit::TreeIndex;
 using std::string;
 using std::vector;
+using TokenType = cladokit::NewickTokenizer::TokenType;
+
+namespace {
+// Newick string of a tree statement without the comments surrounding it. line can be
+// a view of a memory mapped file, so no scan goes past its end.
+std::string_view NewickOfTreeStatement(std::string_view line) {
+    size_t size = line.size();
+    size_t start = std::min<size_t>(4, size);
+    // Go to the first '(' of the newick tree
+    // while avoiding comments at the beginning.
+    // For example: tree STATE_1 = [&R] (A,B);
+    while (start < size && line[start] != '(') {
+        if (line[start] == '[') {
+            while (start < size && line[start] != ']') {
+                start++;
+            }
+        } else if (line[start] == '\'' || line[start] == '"') {
+            // quoted tree name
+            char quote = line[start++];
+            while (start < size && line[start] != quote) {
+                start++;
+            }
+        }
+        start++;
+    }
+    if (start >= size) {
+        throw std::invalid_argument("Missing newick string in tree statement");
+    }
+    // We don't want comments at the end either.
+    size_t end = size;  // after the semicolon
+    while (end > start && line[end - 1] != ';') {
+        if (line[end - 1] == ']') {
+            while (end > start && line[end - 1] != '[') {
+                end--;
+            }
+        }
+        if (end > start) end--;
+    }
+    // the statement of a truncated file has no semicolon, the parser reports it if
+    // the tree is incomplete
+    if (end == start) end = size;
+
+    return line.substr(start, end - start);
+}
+}  // namespace
 
 size_t NexusFile::Count() {
+    if (index_) return index_->Count();
     if (count_ > 0) return count_;
 
     bool found = findBlock("trees");
@@ -43,11 +105,7 @@ size_t NexusFile::Count() {
 vector<std::shared_ptr<Tree>> NexusFile::Parse() {
     vector<std::shared_ptr<Tree>> trees;
 
-    if (!taxonNames_->empty()) {
-        for (size_t i = 0; i < taxonNames_->size(); i++) {
-            taxonMap_[taxonNames_->at(i)] = i;
-        }
-    }
+    FillTaxonMap();
 
     bool found = findBlock("trees");
     if (!found) {
@@ -55,6 +113,8 @@ vector<std::shared_ptr<Tree>> NexusFile::Parse() {
         return trees;
     }
     string buffer;
+    // tree statements parsed once they are all read when using several threads
+    vector<string> lines;
     while (!in_.eof()) {
         std::getline(in_, buffer, '\n');
         if (StartsWithCaseInsensitive(buffer, "end;")) {
@@ -62,61 +122,48 @@ vector<std::shared_ptr<Tree>> NexusFile::Parse() {
         } else if (StartsWithCaseInsensitiveLeftTrim(buffer, "translate")) {
             ParseTranslate();
         } else if (StartsWithCaseInsensitive(buffer, "tree")) {
-            auto tree = ParseTreeLine(buffer);
-            trees.push_back(tree);
-        }
-    }
-    return trees;
-}
-
-std::shared_ptr<Tree> NexusFile::ParseTreeLine(const string &line) {
-    size_t start = 4;
-    // Go to the first '(' of the newick tree
-    // while avoiding comments at the beginning.
-    // For example: tree STATE_1 = [&R] (A,B);
-    while (line[start] != '(') {
-        if (line[start] == '[') {
-            while (line[start] != ']') {
-                start++;
+            ReadTreeStatement(buffer);
+            if (!Accept(buffer)) continue;
+            if (threadCount_ != 1) {
+                lines.push_back(buffer);
+            } else {
+                auto tree = ParseTreeLine(buffer);
+                trees.push_back(tree);
             }
         }
-        start++;
     }
-    // We don't want comments at the end either.
-    size_t end = line.size() - 1;
-    while (line[end] != ';') {
-        if (line[end] == ']') {
-            while (line[end] != '[') {
-                end--;
-            }
-        }
-        end--;
+    if (threadCount_ != 1) {
+        return ParseTreeLines(vector<std::string_view>(lines.begin(), lines.end()));
     }
+    return trees;
+}
 
-    string newick = line.substr(start, end - start + 1);
+std::shared_ptr<Tree> NexusFile::ParseTreeLine(std::string_view line) {
+    std::string_view newick = NewickOfTreeStatement(line);
 
-    if (!translateMap_.empty()) {
+    if (!translateMap_.empty() && !taxonNames_->empty()) {
+        // leaves are created with their taxon index
+        return Tree::FromNewick(newick, Taxa(), TranslateOptions(), arena_);
+    } else if (!translateMap_.empty()) {
         // provide empty taxon names because at this stage the taxa in the newick tree
         // are just numbers.
         auto emptyTaxonNames = std::make_shared<std::vector<std::string>>();
-        auto tree = Tree::FromNewick(newick, emptyTaxonNames);
-        for (auto it = tree->Root()->begin_postorder();
-             it != tree->Root()->end_postorder(); ++it) {
-            auto node = *it;
-            if (node->IsLeaf()) {
-                // Translate the name if there was translate block
-                // For example: "2" -> "sequencexyz"
-                auto it2 = translateMap_.find(node->Name());
-                if (it2 != translateMap_.end()) {
-                    node->SetName(it2->second);
-                }
-                auto it3 = taxonMap_.find(node->Name());
-                // change ID of node using its index in taxonMap
-                if (it3 != taxonMap_.end()) {
-                    node->SetId(it3->second);
-                } else {  // if it is not found in taxonMap, add it.
-                    taxonMap_[node->Name()] = node->Id();
-                }
+        auto tree = Tree::FromNewick(newick, emptyTaxonNames, parseOptions_, arena_);
+        // leaves occupy the first ids
+        for (size_t id = 0; id < tree->LeafNodeCount(); id++) {
+            const auto &node = tree->Nodes()[id];
+            // Translate the name if there was translate block
+            // For example: "2" -> "sequencexyz"
+            auto it2 = translateMap_.find(node->Name());
+            if (it2 != translateMap_.end()) {
+                node->SetName(it2->second);
+            }
+            auto it3 = taxonMap_.find(node->Name());
+            // change ID of node using its index in taxonMap
+            if (it3 != taxonMap_.end()) {
+                node->SetId(it3->second);
+            } else {  // if it is not found in taxonMap, add it.
+                taxonMap_[node->Name()] = node->Id();
             }
         }
         if (!taxonMap_.empty() && taxonNames_->empty()) {
@@ -125,20 +172,102 @@ std::shared_ptr<Tree> NexusFile::ParseTreeLine(const string &line) {
                 (*taxonNames_)[index] = name;
             }
         }
-        tree->SetTaxonNames(taxonNames_);
+        tree->SetTaxonSet(Taxa());
         return tree;
+    } else if (taxonNames_->empty()) {
+        return Tree::FromNewick(newick, taxonNames_, parseOptions_, arena_);
     } else {
-        return Tree::FromNewick(newick, taxonNames_);
+        return Tree::FromNewick(newick, Taxa(), parseOptions_, arena_);
+    }
+}
+
+void NexusFile::ParseTreeLineInto(std::string_view line, Tree &tree) {
+    if (taxonNames_->empty()) {
+        tree = std::move(*ParseTreeLine(line));
+        return;
+    }
+    const auto &options = translateMap_.empty() ? parseOptions_ : TranslateOptions();
+    tree.Rebuild(NewickOfTreeStatement(line), Taxa(), options, arena_);
+}
+
+std::shared_ptr<Tree> NexusFile::ParseTreeLine(
+    std::string_view line, const std::shared_ptr<const TaxonSet> &taxa,
+    const std::shared_ptr<NodeArena> &arena) const {
+    std::string_view newick = NewickOfTreeStatement(line);
+    if (translateMap_.empty()) {
+        return Tree::FromNewick(newick, taxa, parseOptions_, arena);
+    }
+    if (translateOptionsValid_ && translateTable_->Taxa() == taxa) {
+        return Tree::FromNewick(newick, taxa, translateOptions_, arena);
+    }
+    auto tree = Tree::FromNewick(newick, std::make_shared<std::vector<std::string>>(),
+                                 parseOptions_, arena);
+    for (size_t id = 0; id < tree->LeafNodeCount(); id++) {
+        const auto &node = tree->Nodes()[id];
+        auto it = translateMap_.find(node->Name());
+        if (it != translateMap_.end()) {
+            node->SetName(it->second);
+        }
+    }
+    tree->SetTaxonSet(taxa);
+    return tree;
+}
+
+const cladokit::NewickParseOptions &NexusFile::TranslateOptions() {
+    auto taxa = Taxa();
+    if (!translateTable_ || translateTable_->Taxa() != taxa) {
+        translateTable_ = std::make_shared<TranslateTable>(translateMap_, taxa);
+        translateOptionsValid_ = false;
+    }
+    if (!translateOptionsValid_) {
+        translateOptions_ = parseOptions_;
+        translateOptions_.translate = translateTable_;
+        translateOptionsValid_ = true;
+    }
+    return translateOptions_;
+}
+
+void NexusFile::SetParseOptions(const NewickParseOptions &options) {
+    TreeFile::SetParseOptions(options);
+    translateOptionsValid_ = false;
+}
+
+vector<std::shared_ptr<Tree>> NexusFile::ParseTreeLines(
+    const vector<std::string_view> &lines) {
+    auto parseFirst = [this](std::string_view line) {
+        auto tree = ParseTreeLine(line);
+        // the taxa are known, the other trees are parsed with the translate table
+        if (!translateMap_.empty()) TranslateOptions();
+        return tree;
+    };
+    return ParseStatements(
+        lines, parseFirst,
+        [this](std::string_view line, const std::shared_ptr<const TaxonSet> &taxa,
+               const std::shared_ptr<NodeArena> &arena) {
+            return ParseTreeLine(line, taxa, arena);
+        });
+}
+
+void NexusFile::ReadTreeStatement(string &statement) {
+    StatementScanner scanner;
+    if (scanner.Terminates(statement)) return;
+    string line;
+    while (std::getline(in_, line, '\n')) {
+        statement += '\n';
+        statement += line;
+        if (scanner.Terminates(line)) return;
+    }
+}
+
+void NexusFile::FillTaxonMap() {
+    for (size_t i = 0; i < taxonNames_->size(); i++) {
+        taxonMap_[taxonNames_->at(i)] = i;
     }
 }
 
 void NexusFile::PointToFirstTree() {
     if (translateParsed_ == false) {
-        if (!taxonNames_->empty()) {
-            for (size_t i = 0; i < taxonNames_->size(); i++) {
-                taxonMap_[taxonNames_->at(i)] = i;
-            }
-        }
+        FillTaxonMap();
 
         bool found = findBlock("trees");
         if (!found) {
@@ -153,6 +282,8 @@ void NexusFile::PointToFirstTree() {
                 } else if (StartsWithCaseInsensitiveLeftTrim(buffer, "translate")) {
                     ParseTranslate();
                 } else if (StartsWithCaseInsensitive(buffer, "tree")) {
+                    ReadTreeStatement(buffer);
+                    if (!Accept(buffer)) continue;
                     currentTreeString_ = buffer;
                     break;
                 }
@@ -179,7 +310,8 @@ bool NexusFile::HasNext() {
         if (cladokit::StartsWithCaseInsensitive(currentTreeString_, "end;")) {
             break;
         } else if (cladokit::StartsWithCaseInsensitive(currentTreeString_, "tree")) {
-            return true;
+            ReadTreeStatement(currentTreeString_);
+            if (Accept(currentTreeString_)) return true;
         }
     }
     currentTreeString_.clear();
@@ -191,7 +323,8 @@ void NexusFile::SkipNext() {
         while (!in_.eof()) {
             std::getline(in_, currentTreeString_, '\n');
             if (cladokit::StartsWithCaseInsensitive(currentTreeString_, "tree")) {
-                return;
+                ReadTreeStatement(currentTreeString_);
+                if (Accept(currentTreeString_)) return;
             }
         }
     }
@@ -210,50 +343,116 @@ std::shared_ptr<Tree> NexusFile::Next() {
     return tree;
 }
 
-void NexusFile::ParseTranslate() {
-    bool done = false;
-    string line;
-    while (!in_.eof() && !done) {
-        line = nextLineUncommented();
-        RightTrim(line);
-        LeftTrim(line);
-
-        if (line == ";") break;
+vector<cladokit::NexusTreeHeader> NexusFile::Headers() {
+    vector<NexusTreeHeader> headers;
+    while (HasNext()) {
+        headers.push_back(ParseTreeHeader(currentTreeString_, parseOptions_.converters));
+        currentTreeString_.clear();
+    }
+    return headers;
+}
 
-        size_t found = line.find(";");
+cladokit::NexusTreeHeader NexusFile::ParseTreeHeader(
+    std::string_view statement,
+    const std::unordered_map<std::string, cladokit::Converter> &converters) {
+    NexusTreeHeader header;
+    // skip the tree keyword and the asterisk marking the default tree
+    size_t start = std::min<size_t>(4, statement.size());
+    while (start < statement.size() && (std::isspace(statement[start]) ||
+                                        statement[start] == '*')) {
+        start++;
+    }
 
-        if (found != string::npos) {
-            line = line.substr(0, found);
-            done = true;
+    NewickTokenizer tokenizer(statement.substr(start));
+    bool named = false;
+    for (auto token = tokenizer.Next(); token.type != TokenType::kEnd;
+         token = tokenizer.Next()) {
+        if (token.type == TokenType::kOpen) {
+            break;
+        } else if (token.type == TokenType::kLabel && !named) {
+            // the name can be followed by the equal sign without space
+            std::string_view name = token.text;
+            if (name.front() != '\'' && name.front() != '"') {
+                name = name.substr(0, name.find('='));
+                while (!name.empty() &&
+                       std::isspace(static_cast<unsigned char>(name.back()))) {
+                    name.remove_suffix(1);
+                }
+            }
+            header.name = NewickTokenizer::Unquote(name);
+            named = true;
+        } else if (token.type == TokenType::kComment) {
+            if (StartsWithCaseInsensitive(token.text, "[&R]")) {
+                header.rooting = NexusTreeHeader::Rooting::kRooted;
+            } else if (StartsWithCaseInsensitive(token.text, "[&U]")) {
+                header.rooting = NexusTreeHeader::Rooting::kUnrooted;
+            } else if (token.text.size() > 1 && token.text[1] == '&') {
+                ParseRawComment(token.text, header.annotations, converters, {});
+            }
         }
+    }
 
-        found = line.find(",");
+    size_t digits = header.name.size();
+    while (digits > 0 &&
+           std::isdigit(static_cast<unsigned char>(header.name[digits - 1]))) {
+        digits--;
+    }
+    if (digits < header.name.size() && header.name.size() - digits < 19) {
+        header.state = std::stoll(header.name.substr(digits));
+    }
+    return header;
+}
 
-        if (found == string::npos) {
-            size_t index = line.find_first_of("\t ");
-            string shorthand = line.substr(0, index);
-            line.erase(0, index + 1);
-            translateMap_[shorthand] = line;
-        } else {
-            std::size_t start = 0;
-
-            while (found != string::npos) {
-                string temp = line.substr(start, found);
-                if (temp.size() != 0) {
-                    std::size_t index = temp.find_first_of("\t ");
-                    string shorthand = temp.substr(0, index);
-                    temp.erase(0, index + 1);
-                    RightTrim(temp);
-                    LeftTrim(temp);
-                    translateMap_[shorthand] = temp;
-                }
-                start = found + 1;
-                found = line.find(",", start);
+bool NexusFile::Accept(std::string_view statement) const {
+    return !treeFilter_ ||
+           treeFilter_(ParseTreeHeader(statement, parseOptions_.converters));
+}
+
+bool NexusFile::NextInto(Tree &tree) {
+    if (!HasNext()) return false;
+    ParseTreeLineInto(currentTreeString_, tree);
+    currentTreeString_.clear();
+    return true;
+}
+
+void NexusFile::ParseTranslate() {
+    bool done = false;
+    string line;
+    while (!in_.eof() && !done) {
+        line = nextLineUncommented();
+        // entries end with a comma and the last one with a semicolon, neither of
+        // them ends an entry inside a quoted label
+        char quote = 0;
+        size_t start = 0;
+        for (size_t i = 0; i <= line.size() && !done; i++) {
+            char c = i < line.size() ? line[i] : ',';
+            if (quote != 0) {
+                if (c == quote) quote = 0;
+                if (i < line.size()) continue;
+            } else if (c == '\'' || c == '"') {
+                quote = c;
+                continue;
+            } else if (c != ',' && c != ';') {
+                continue;
             }
+            AddTranslation(line.substr(start, i - start));
+            start = i + 1;
+            done = c == ';';
         }
     }
 }
 
+void NexusFile::AddTranslation(string entry) {
+    RightTrim(entry);
+    LeftTrim(entry);
+    if (entry.empty()) return;
+    size_t index = entry.find_first_of("\t ");
+    string shorthand = entry.substr(0, index);
+    string label = index == string::npos ? string() : entry.substr(index + 1);
+    LeftTrim(label);
+    translateMap_[shorthand] = NewickTokenizer::Unquote(label);
+}
+
 // it can return an empty string if it is a (single or multiple line) comment
 // with nothing around assumes one comment per line assumes it is not eof
 string NexusFile::nextLineUncommented() {
@@ -298,3 +497,170 @@ bool NexusFile::findBlock(const string &blockName) {
     }
     return found;
 }
+
+size_t MappedNexusFile::Count() {
+    if (index_) return index_->Count();
+    if (count_ > 0) return count_;
+
+    std::string_view text = file_.View();
+    size_t position = 0;
+    bool found = false;
+    while (position < text.size() && !found) {
+        found = StartsWithCaseInsensitive(NextLine(text, position), "begin trees");
+    }
+    if (!found) {
+        std::cerr << "Error: trees block not found" << std::endl;
+        return 0;
+    }
+
+    while (position < text.size()) {
+        std::string_view line = NextLine(text, position);
+        if (StartsWithCaseInsensitive(line, "end;")) {
+            break;
+        }
+        if (StartsWithCaseInsensitive(line, "tree")) {
+            count_++;
+        }
+    }
+    return count_;
+}
+
+vector<std::shared_ptr<Tree>> MappedNexusFile::Parse() {
+    vector<std::shared_ptr<Tree>> trees;
+    if (threadCount_ != 1) {
+        vector<std::string_view> lines;
+        while (HasNext()) {
+            lines.push_back(currentTree_);
+            currentTree_ = std::string_view();
+        }
+        return ParseTreeLines(lines);
+    }
+    while (HasNext()) {
+        trees.push_back(Next());
+    }
+    return trees;
+}
+
+void MappedNexusFile::PointToFirstTree() {
+    headerParsed_ = true;
+    FillTaxonMap();
+
+    std::string_view text = file_.View();
+    stream_.seekg(position_);
+    if (!findBlock("trees")) {
+        std::cerr << "Error: trees block not found" << std::endl;
+        position_ = text.size();
+        return;
+    }
+    position_ = StreamPosition();
+
+    while (position_ < text.size()) {
+        std::string_view line = NextLine(text, position_);
+        if (StartsWithCaseInsensitive(line, "end;")) {
+            // should not be here
+            position_ = text.size();
+        } else if (StartsWithCaseInsensitiveLeftTrim(line, "translate")) {
+            stream_.seekg(position_);
+            ParseTranslate();
+            position_ = StreamPosition();
+        } else if (StartsWithCaseInsensitive(line, "tree")) {
+            currentTree_ = ExtendTreeStatement(line);
+            if (Accept(currentTree_)) return;
+            currentTree_ = std::string_view();
+        }
+    }
+}
+
+std::string_view MappedNexusFile::ExtendTreeStatement(std::string_view line) {
+    std::string_view text = file_.View();
+    StatementScanner scanner;
+    size_t end = line.data() + line.size() - text.data();
+    if (scanner.Terminates(line)) return line;
+    while (position_ < text.size()) {
+        std::string_view next = NextLine(text, position_);
+        end = next.data() + next.size() - text.data();
+        if (scanner.Terminates(next)) break;
+    }
+    return text.substr(line.data() - text.data(), end - (line.data() - text.data()));
+}
+
+bool MappedNexusFile::HasNext() {
+    // there is a tree in currentTree_ so it has not been parsed
+    if (!currentTree_.empty()) {
+        return true;
+    }
+    if (!headerParsed_) {
+        PointToFirstTree();
+        return !currentTree_.empty();
+    }
+
+    std::string_view text = file_.View();
+    while (position_ < text.size()) {
+        std::string_view line = NextLine(text, position_);
+        if (StartsWithCaseInsensitive(line, "end;")) {
+            position_ = text.size();
+        } else if (StartsWithCaseInsensitive(line, "tree")) {
+            currentTree_ = ExtendTreeStatement(line);
+            if (Accept(currentTree_)) return true;
+            currentTree_ = std::string_view();
+        }
+    }
+    return false;
+}
+
+void MappedNexusFile::SkipNext() {
+    if (HasNext()) {
+        currentTree_ = std::string_view();
+        HasNext();
+    }
+}
+
+std::shared_ptr<Tree> MappedNexusFile::Next() {
+    std::shared_ptr<Tree> tree;
+    if (HasNext()) {
+        tree = ParseTreeLine(currentTree_);
+        currentTree_ = std::string_view();
+    }
+    return tree;
+}
+
+vector<cladokit::NexusTreeHeader> MappedNexusFile::Headers() {
+    vector<NexusTreeHeader> headers;
+    while (HasNext()) {
+        headers.push_back(ParseTreeHeader(currentTree_, parseOptions_.converters));
+        currentTree_ = std::string_view();
+    }
+    return headers;
+}
+
+bool MappedNexusFile::NextInto(Tree &tree) {
+    if (!HasNext()) return false;
+    ParseTreeLineInto(currentTree_, tree);
+    currentTree_ = std::string_view();
+    return true;
+}
+
+void NexusFile::SeekTo(const TreeIndex::Entry &entry) {
+    // the translate block is read before the first tree
+    if (!translateParsed_) {
+        PointToFirstTree();
+    } else if (taxonMap_.empty()) {
+        FillTaxonMap();
+    }
+    in_.clear();
+    in_.seekg(entry.offset, std::ios::beg);
+    // the statement is read here so that the filter does not skip it
+    std::getline(in_, currentTreeString_, '\n');
+    ReadTreeStatement(currentTreeString_);
+}
+
+void MappedNexusFile::SeekTo(const TreeIndex::Entry &entry) {
+    if (!headerParsed_) {
+        PointToFirstTree();
+    } else if (taxonMap_.empty()) {
+        FillTaxonMap();
+    }
+    // the statement is read here so that the filter does not skip it
+    position_ = entry.offset;
+    currentTree_ = ExtendTreeStatement(NextLine(file_.View(), position_));
+}
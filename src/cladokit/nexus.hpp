@@ -3,18 +3,75 @@
 
 #pragma once
 
+#include <any>
 #include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "cladokit/mapped_file.hpp"
+#include "cladokit/translate_table.hpp"
 #include "cladokit/treeio.hpp"
 
 // use cladokit::Tree;
 namespace cladokit {
 
+// Finds the semicolon terminating a tree statement read one line at a time. Tree
+// statements of pretty-printed files span several lines and their comments can
+// contain newlines.
+class StatementScanner {
+   public:
+    // Scan the next line of the statement, returns true if it terminates it.
+    bool Terminates(std::string_view line) {
+        for (char c : line) {
+            if (quote_ != 0) {
+                if (c == quote_) quote_ = 0;  // a doubled quote reopens the label
+            } else if (inComment_) {
+                inComment_ = c != ']';
+            } else if (c == '[') {
+                inComment_ = true;
+            } else if (c == '\'' || c == '"') {
+                quote_ = c;
+            } else if (c == ';') {
+                return true;
+            }
+        }
+        return false;
+    }
+
+   private:
+    char quote_ = 0;
+    bool inComment_ = false;
+};
+
+// Metadata preceding the newick string of a tree statement, for example
+// tree STATE_12000 [&lnP=-3456.7,joint=-3401.2] = [&R] (...);
+struct NexusTreeHeader {
+    enum class Rooting { kUnknown, kRooted, kUnrooted };
+
+    std::string name;
+    // Number ending the name, e.g. 12000 for STATE_12000, or -1 if there is none.
+    int64_t state = -1;
+    // Given by a [&R] or [&U] comment.
+    Rooting rooting = Rooting::kUnknown;
+    // Key/values of the other comments. Values are strings unless a converter is
+    // given for their key.
+    std::map<std::string, std::any> annotations;
+};
+
+using TreeFilter = std::function<bool(const NexusTreeHeader &)>;
+
+// Nexus file read one tree statement at a time. A statement spanning several lines is
+// joined into a single string before its newick string is parsed, so the memory used
+// is bounded by the largest tree statement of the file. Unlike NewickStreamParser, a
+// statement is not parsed in chunks.
 class NexusFile : public TreeFile {
    public:
     using TreeFile::TreeFile;
@@ -29,20 +86,117 @@ class NexusFile : public TreeFile {
 
     void SkipNext() override;
 
+    bool NextInto(Tree &tree) override;
+
+    // The translate table of the file replaces the one of options for the files
+    // with a translate command, options itself is left unchanged.
+    void SetParseOptions(const NewickParseOptions &options) override;
+
+    // Only the trees whose header is accepted by filter are returned by Next, Parse
+    // and NextInto, the others are skipped without parsing their newick string. The
+    // filter is ignored by Count, Seek and At: At(k) returns the k-th tree of the
+    // file even if it is rejected, the following calls to Next apply the filter.
+    void SetTreeFilter(TreeFilter filter) { treeFilter_ = std::move(filter); }
+
+    // Headers of the remaining trees accepted by the filter, read without parsing
+    // the trees.
+    virtual std::vector<NexusTreeHeader> Headers();
+
+    // Header of a tree statement. The converters of the parse options are applied
+    // to the annotations.
+    static NexusTreeHeader ParseTreeHeader(
+        std::string_view statement,
+        const std::unordered_map<std::string, Converter> &converters = {});
+
     void ParseTranslate();
 
+    // Add an entry "token label" of the translate command.
+    void AddTranslation(std::string entry);
+
     std::string nextLineUncommented();
 
     bool findBlock(const std::string &blockName);
 
    protected:
-    std::shared_ptr<Tree> ParseTreeLine(const std::string &buffer);
+    void SeekTo(const TreeIndex::Entry &entry) override;
+
+    std::shared_ptr<Tree> ParseTreeLine(std::string_view buffer);
+
+    // Parse a tree statement into tree, reusing its nodes once the taxa are known.
+    void ParseTreeLineInto(std::string_view buffer, Tree &tree);
+
+    // Parse a tree statement without modifying the file, once the taxa are known.
+    std::shared_ptr<Tree> ParseTreeLine(std::string_view buffer,
+                                        const std::shared_ptr<const TaxonSet> &taxa,
+                                        const std::shared_ptr<NodeArena> &arena) const;
+
+    // Parse tree statements with ThreadCount() threads.
+    std::vector<std::shared_ptr<Tree>> ParseTreeLines(
+        const std::vector<std::string_view> &lines);
     void PointToFirstTree();
+    void FillTaxonMap();
+
+    // Append the next lines of the file to statement until it is terminated. The whole
+    // statement is held in memory.
+    void ReadTreeStatement(std::string &statement);
+
+    // Copy of the parse options resolving the tokens of translateMap_ against
+    // Taxa().
+    const NewickParseOptions &TranslateOptions();
 
-   private:
     std::map<std::string, std::string> translateMap_;
     std::map<std::string, size_t> taxonMap_;
+    std::shared_ptr<const TranslateTable> translateTable_;
+    NewickParseOptions translateOptions_;
+    bool translateOptionsValid_ = false;
+    TreeFilter treeFilter_;
+
+    // Whether the tree statement passes the filter.
+    bool Accept(std::string_view statement) const;
+
+   private:
     bool translateParsed_ = false;
     std::string currentTreeString_ = "";
 };
+
+// Nexus file read from a memory mapped file. The blocks preceding the trees are
+// read with NexusFile and tree statements are parsed in place without copying the
+// lines of the file.
+class MappedNexusFile : private MappedStream, public NexusFile {
+   public:
+    explicit MappedNexusFile(const std::filesystem::path &path)
+        : MappedStream(path), NexusFile(stream_) {}
+
+    MappedNexusFile(const std::filesystem::path &path,
+                    std::shared_ptr<std::vector<std::string>> taxonNames)
+        : MappedStream(path), NexusFile(stream_, taxonNames) {}
+
+    size_t Count() override;
+
+    std::vector<std::shared_ptr<Tree>> Parse() override;
+
+    std::shared_ptr<Tree> Next() override;
+
+    bool HasNext() override;
+
+    void SkipNext() override;
+
+    bool NextInto(Tree &tree) override;
+
+    std::vector<NexusTreeHeader> Headers() override;
+
+   protected:
+    void SeekTo(const TreeIndex::Entry &entry) override;
+
+   private:
+    // Read the blocks preceding the first tree and point to it.
+    void PointToFirstTree();
+
+    // Extend line, the first line of a tree statement, to the line terminating it.
+    std::string_view ExtendTreeStatement(std::string_view line);
+
+    size_t position_ = 0;  // beginning of the next line
+    std::string_view currentTree_;
+    bool headerParsed_ = false;
+};
 }  // namespace cladokit
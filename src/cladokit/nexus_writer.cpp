@@ -0,0 +1,164 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/nexus_writer.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cladokit/parallel.hpp"
+
+using cladokit::NewickWriter;
+using cladokit::NexusWriter;
+using cladokit::TaxonSet;
+using cladokit::Tree;
+using std::string;
+using std::vector;
+
+namespace {
+// Taxon label quoted if it contains characters that are not allowed in an
+// unquoted Nexus word.
+string QuoteLabel(const string &label) {
+    if (!label.empty() &&
+        label.find_first_of(" \t\n\r()[]{}/\\,;:=*'\"`<>") == string::npos) {
+        return label;
+    }
+    string quoted = "'";
+    for (char c : label) {
+        if (c == '\'') quoted += '\'';
+        quoted += c;
+    }
+    return quoted + "'";
+}
+}  // namespace
+
+NexusWriter::NexusWriter(std::ostream &os, std::shared_ptr<const TaxonSet> taxa,
+                         NewickExportOptions options)
+    : os_(os), taxa_(std::move(taxa)), options_(std::move(options)) {
+    if (!taxa_) {
+        throw std::invalid_argument("NexusWriter requires a taxon set");
+    }
+    auto tokens = std::make_shared<vector<string>>(taxa_->Size());
+    for (size_t i = 0; i < tokens->size(); i++) {
+        (*tokens)[i] = std::to_string(i + 1);
+    }
+    tokens_ = tokens;
+    writers_.emplace_back(options_);
+    os_ << Header(*taxa_);
+}
+
+void NexusWriter::SetThreadCount(size_t threadCount) {
+    threadCount_ = threadCount;
+    writers_.resize(threadCount == 0 ? DefaultThreadCount() : threadCount,
+                    NewickWriter(options_));
+}
+
+void NexusWriter::Write(const Tree &tree) {
+    Write(tree, "tree_" + std::to_string(treeCount_ + 1));
+}
+
+void NexusWriter::Write(const Tree &tree, const string &name) {
+    CheckOpen();
+    statements_.resize(1);
+    statements_[0].clear();
+    Format(tree, name, writers_[0], statements_[0]);
+    os_ << statements_[0];
+    treeCount_++;
+}
+
+void NexusWriter::Write(const vector<std::shared_ptr<Tree>> &trees) {
+    vector<string> names(trees.size());
+    for (size_t i = 0; i < trees.size(); i++) {
+        names[i] = "tree_" + std::to_string(treeCount_ + i + 1);
+    }
+    Write(trees, names);
+}
+
+void NexusWriter::Write(const vector<std::shared_ptr<Tree>> &trees,
+                        const vector<string> &names) {
+    CheckOpen();
+    if (names.size() != trees.size()) {
+        throw std::invalid_argument("Expected " + std::to_string(trees.size()) +
+                                    " tree names but got " +
+                                    std::to_string(names.size()));
+    }
+    // trees are formatted in chunks so that the statements of a few chunks only
+    // are held in memory
+    size_t chunk = kChunkSize * writers_.size();
+    statements_.resize(std::min(chunk, trees.size()));
+    for (size_t start = 0; start < trees.size(); start += chunk) {
+        size_t count = std::min(chunk, trees.size() - start);
+        ParallelFor(count, writers_.size(), [&](size_t index, size_t worker) {
+            statements_[index].clear();
+            Format(*trees[start + index], names[start + index], writers_[worker],
+                   statements_[index]);
+        });
+        for (size_t i = 0; i < count; i++) {
+            os_ << statements_[i];
+        }
+        treeCount_ += count;
+    }
+}
+
+void NexusWriter::Close() {
+    if (closed_) return;
+    closed_ = true;
+    os_ << "End;\n";
+    os_.flush();
+}
+
+string NexusWriter::Header(const TaxonSet &taxa) {
+    std::ostringstream header;
+    header << "#NEXUS\n\nBegin taxa;\n\tDimensions ntax=" << taxa.Size()
+           << ";\n\tTaxlabels\n";
+    for (size_t i = 0; i < taxa.Size(); i++) {
+        header << "\t\t" << QuoteLabel(taxa.Name(i)) << '\n';
+    }
+    header << "\t\t;\nEnd;\n\nBegin trees;\n\tTranslate\n";
+    for (size_t i = 0; i < taxa.Size(); i++) {
+        header << "\t\t" << i + 1 << ' ' << QuoteLabel(taxa.Name(i))
+               << (i + 1 < taxa.Size() ? ",\n" : "\n");
+    }
+    header << "\t\t;\n";
+    return header.str();
+}
+
+void NexusWriter::CheckOpen() const {
+    if (closed_) {
+        throw std::logic_error("Cannot write trees after NexusWriter::Close");
+    }
+}
+
+void NexusWriter::Format(const Tree &tree, const string &name, NewickWriter &writer,
+                         string &statement) const {
+    statement += "tree ";
+    statement += QuoteLabel(name);
+    statement += tree.IsRooted() ? " = [&R] " : " = [&U] ";
+    writer.SetLeafLabels(LeafTokens(tree));
+    writer.Append(tree, statement);
+    statement += '\n';
+}
+
+std::shared_ptr<const vector<string>> NexusWriter::LeafTokens(const Tree &tree) const {
+    if (tree.Taxa() == taxa_ || tree.TaxonNames() == taxa_->Names()) {
+        return tokens_;
+    }
+    // leaves are numbered after the taxa of the tree, find their index in taxa_
+    auto tokens = std::make_shared<vector<string>>(tree.LeafNodeCount());
+    for (size_t id = 0; id < tree.LeafNodeCount(); id++) {
+        const string &name = tree.NodeFromId(id)->Name();
+        size_t index = taxa_->IndexOf(name);
+        if (index == TaxonSet::kNotFound) {
+            throw std::invalid_argument("Taxon " + name +
+                                        " is not in the taxon set of the writer");
+        }
+        (*tokens)[id] = (*tokens_)[index];
+    }
+    return tokens;
+}
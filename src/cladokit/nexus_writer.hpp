@@ -0,0 +1,84 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "cladokit/newick_options.hpp"
+#include "cladokit/newick_writer.hpp"
+#include "cladokit/taxon_set.hpp"
+#include "cladokit/tree.hpp"
+
+namespace cladokit {
+
+// Writes trees to a Nexus file. The taxa are listed once in a TAXA block and in the
+// TRANSLATE table of the TREES block, and leaves are written as the integer token
+// of their taxon in every tree statement. The header is written by the constructor
+// and the TREES block is ended by Close or by the destructor.
+// Trees are formatted in parallel chunks with ThreadCount() threads and written in
+// the order they are given.
+class NexusWriter {
+   public:
+    NexusWriter(std::ostream &os, std::shared_ptr<const TaxonSet> taxa,
+                NewickExportOptions options = NewickExportOptions());
+
+    ~NexusWriter() { Close(); }
+
+    NexusWriter(const NexusWriter &) = delete;
+
+    NexusWriter &operator=(const NexusWriter &) = delete;
+
+    // Number of threads formatting the trees, 0 means one per hardware thread.
+    void SetThreadCount(size_t threadCount);
+
+    size_t ThreadCount() const { return threadCount_; }
+
+    // Write tree named tree_N where N is the number of trees written so far plus 1.
+    void Write(const Tree &tree);
+
+    void Write(const Tree &tree, const std::string &name);
+
+    void Write(const std::vector<std::shared_ptr<Tree>> &trees);
+
+    // Names must have the same size as trees.
+    void Write(const std::vector<std::shared_ptr<Tree>> &trees,
+               const std::vector<std::string> &names);
+
+    // End the TREES block and flush the stream. Nothing can be written afterwards.
+    void Close();
+
+    size_t TreeCount() const { return treeCount_; }
+
+    // TAXA block and beginning of the TREES block up to the TRANSLATE table included.
+    static std::string Header(const TaxonSet &taxa);
+
+    // Number of trees formatted by each thread in a call to ParallelFor.
+    static constexpr size_t kChunkSize = 64;
+
+   private:
+    std::ostream &os_;
+    std::shared_ptr<const TaxonSet> taxa_;
+    NewickExportOptions options_;
+    size_t threadCount_ = 1;
+    size_t treeCount_ = 0;
+    bool closed_ = false;
+    // token of taxon i is i+1
+    std::shared_ptr<const std::vector<std::string>> tokens_;
+    std::vector<NewickWriter> writers_;  // one per thread
+    std::vector<std::string> statements_;
+
+    void CheckOpen() const;
+
+    // Append the tree statement of tree to statement.
+    void Format(const Tree &tree, const std::string &name, NewickWriter &writer,
+                std::string &statement) const;
+
+    // Tokens of the leaves of tree indexed by node id.
+    std::shared_ptr<const std::vector<std::string>> LeafTokens(const Tree &tree) const;
+};
+}  // namespace cladokit
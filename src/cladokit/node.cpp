@@ -4,17 +4,20 @@
 #include "cladokit/node.hpp"
 
 #include <algorithm>
-#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <memory>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 
 #include "cladokit/newick_options.hpp"
+#include "cladokit/newick_writer.hpp"
+#include "cladokit/split_hash.hpp"
 
+using cladokit::NewickWriter;
 using cladokit::Node;
 using std::string;
 
@@ -24,15 +27,74 @@ Node::Node(const std::string &name) : name_(name) {}
 
 const string &Node::Name() const { return name_; }
 
-void Node::SetName(const string &name) { name_ = name; }
+void Node::SetName(const string &name) {
+    name_ = name;
+    InvalidateNewick();
+}
+
+void Node::Reset(std::string_view name) {
+    name_.assign(name.data(), name.size());
+    id_ = 0;
+    // forget the span first so that it is not made absolute
+    newickSpan_ = NewickSpan();
+    RemoveParent();
+    children_.clear();
+    distance_ = std::numeric_limits<double>::quiet_NaN();
+    annotations_.clear();
+    branchAnnotations_.clear();
+    annotationTable_.reset();
+    branchAnnotationTable_.reset();
+    comment_.clear();
+    branchComment_.clear();
+    descendantBitset_.Resize(0);
+    splitHash_ = 0;
+}
 
 size_t Node::Id() const { return id_; }
 
-void Node::SetId(size_t id) { id_ = id; }
+void Node::SetId(size_t id) {
+    if (id_ == id) return;
+    id_ = id;
+    InvalidateNewick();
+}
 
 double Node::Distance() const { return distance_; }
 
-void Node::SetDistance(double distance) { distance_ = distance; }
+void Node::SetDistance(double distance) {
+    distance_ = distance;
+    InvalidateNewick();
+}
+
+void Node::InvalidateNewick() {
+    // the ancestors of an outdated node are already outdated
+    for (Node *node = this; node != nullptr && node->newickSpan_.valid;
+         node = node->rawParent_) {
+        node->newickSpan_.valid = false;
+    }
+}
+
+void Node::DetachNewickSpan() {
+    // spans of nodes that were never written or are already absolute do not depend
+    // on the parent
+    if (newickSpan_.generation == 0 || newickSpan_.absolute) return;
+    if (rawParent_ != nullptr) {
+        // the parent of a moved node is absolute
+        size_t offset = newickSpan_.offset;
+        const Node *node = rawParent_;
+        while (!node->newickSpan_.absolute && node->rawParent_ != nullptr) {
+            offset += node->newickSpan_.offset;
+            node = node->rawParent_;
+        }
+        if (node->newickSpan_.absolute) {
+            newickSpan_.offset = offset + node->newickSpan_.offset;
+            newickSpan_.generation = node->newickSpan_.generation;
+            newickSpan_.absolute = true;
+            return;
+        }
+    }
+    // position unknown
+    newickSpan_ = NewickSpan();
+}
 
 std::vector<Node::NodePtr> Node::Siblings() const {
     std::vector<NodePtr> siblings;
@@ -53,21 +115,62 @@ std::vector<Node::NodePtr> Node::Siblings() const {
 bool Node::AddChild(const NodePtr &node) {
     if (find(children_.begin(), children_.end(), node) == children_.end()) {
         node->SetParent(shared_from_this());
+        node->childIndex_ = children_.size();
         children_.push_back(node);
+        InvalidateNewick();
         return true;
     }
     return false;
 }
 
 bool Node::RemoveChild(NodePtr node) {
-    for (size_t i = 0; i < children_.size(); i++) {
-        if (children_.at(i) == node) {
-            node->RemoveParent();
-            children_.erase(children_.begin() + i);
-            return true;
-        }
+    size_t index = node->childIndex_;
+    if (index >= children_.size() || children_[index] != node) {
+        index = find(children_.begin(), children_.end(), node) - children_.begin();
+        if (index == children_.size()) return false;
     }
-    return false;
+    node->RemoveParent();
+    children_.erase(children_.begin() + index);
+    IndexChildren(index);
+    InvalidateNewick();
+    return true;
+}
+
+void Node::IndexChildren(size_t first) {
+    for (size_t i = first; i < children_.size(); i++) {
+        // a node briefly listed by two parents keeps the index of its parent
+        if (children_[i]->rawParent_ == this) children_[i]->childIndex_ = i;
+    }
+}
+
+Node *Node::NextSibling() const {
+    const auto &siblings = rawParent_->children_;
+    size_t index = childIndex_;
+    if (index >= siblings.size() || siblings[index].get() != this) {
+        // the node was attached with SetParent instead of AddChild
+        index = 0;
+        while (siblings[index].get() != this) index++;
+    }
+    return index + 1 < siblings.size() ? siblings[index + 1].get() : nullptr;
+}
+
+Node *Node::NextPostOrder(const Node *root) {
+    if (this == root) return nullptr;
+    Node *next = NextSibling();
+    if (next == nullptr) return rawParent_;
+    while (!next->children_.empty()) {
+        next = next->children_.front().get();
+    }
+    return next;
+}
+
+Node *Node::NextPreOrder(const Node *root) {
+    if (!children_.empty()) return children_.front().get();
+    for (Node *node = this; node != root; node = node->rawParent_) {
+        Node *next = node->NextSibling();
+        if (next != nullptr) return next;
+    }
+    return nullptr;
 }
 
 bool Node::IsRoot() const { return parent_.expired(); }
@@ -81,10 +184,12 @@ void Node::Collapse() {
         parent->AddChild(child);
     }
     children_.clear();
+    InvalidateNewick();
 }
 
 // Node annotations
 std::vector<std::string> Node::AnnotationKeys() const {
+    if (annotationTable_) return annotationTable_->Keys(id_);
     std::vector<std::string> keys;
     keys.reserve(annotations_.size());
     for (const auto &pair : annotations_) {
@@ -93,6 +198,7 @@ std::vector<std::string> Node::AnnotationKeys() const {
     return keys;
 }
 std::any Node::Annotation(const std::string &key) const {
+    if (annotationTable_) return annotationTable_->Get(key, id_);
     auto it = annotations_.find(key);
     if (it == annotations_.end()) {
         throw std::out_of_range("Key not found: " + key);
@@ -100,21 +206,35 @@ std::any Node::Annotation(const std::string &key) const {
     return it->second;
 }
 void Node::SetAnnotation(const string &key, std::any value) {
-    annotations_[key] = std::move(value);
+    if (annotationTable_) {
+        annotationTable_->Set(key, id_, value);
+    } else {
+        annotations_[key] = std::move(value);
+    }
+    InvalidateNewick();
 }
 
 void Node::SetAnnotation(const std::string &key, const char *value) {
-    annotations_[key] = std::string(value);
+    SetAnnotation(key, std::any(std::string(value)));
 }
 
 bool Node::ContainsAnnotation(const string &key) const {
+    if (annotationTable_) return annotationTable_->Contains(key, id_);
     return annotations_.find(key) != annotations_.end();
 }
 
-void Node::RemoveAnnotation(const string &key) { annotations_.erase(key); }
+void Node::RemoveAnnotation(const string &key) {
+    if (annotationTable_) {
+        annotationTable_->Remove(key, id_);
+    } else {
+        annotations_.erase(key);
+    }
+    InvalidateNewick();
+}
 
 // Branch annotations
 std::vector<std::string> Node::BranchAnnotationKeys() const {
+    if (branchAnnotationTable_) return branchAnnotationTable_->Keys(id_);
     std::vector<std::string> keys;
     keys.reserve(branchAnnotations_.size());
     for (const auto &pair : branchAnnotations_) {
@@ -123,6 +243,7 @@ std::vector<std::string> Node::BranchAnnotationKeys() const {
     return keys;
 }
 std::any Node::BranchAnnotation(const std::string &key) const {
+    if (branchAnnotationTable_) return branchAnnotationTable_->Get(key, id_);
     auto it = branchAnnotations_.find(key);
     if (it == branchAnnotations_.end()) {
         throw std::out_of_range("Key not found: " + key);
@@ -130,20 +251,68 @@ std::any Node::BranchAnnotation(const std::string &key) const {
     return it->second;
 }
 void Node::SetBranchAnnotation(const string &key, std::any value) {
-    branchAnnotations_[key] = std::move(value);
+    if (branchAnnotationTable_) {
+        branchAnnotationTable_->Set(key, id_, value);
+    } else {
+        branchAnnotations_[key] = std::move(value);
+    }
+    InvalidateNewick();
 }
 
 void Node::SetBranchAnnotation(const std::string &key, const char *value) {
-    branchAnnotations_[key] = std::string(value);
+    SetBranchAnnotation(key, std::any(std::string(value)));
 }
 
 bool Node::ContainsBranchAnnotation(const string &key) const {
+    if (branchAnnotationTable_) return branchAnnotationTable_->Contains(key, id_);
     return branchAnnotations_.find(key) != branchAnnotations_.end();
 }
 
-void Node::RemoveBranchAnnotation(const string &key) { branchAnnotations_.erase(key); }
+void Node::RemoveBranchAnnotation(const string &key) {
+    if (branchAnnotationTable_) {
+        branchAnnotationTable_->Remove(key, id_);
+    } else {
+        branchAnnotations_.erase(key);
+    }
+    InvalidateNewick();
+}
+
+void Node::AttachAnnotationTables(std::shared_ptr<AnnotationTable> annotations,
+                                  std::shared_ptr<AnnotationTable> branchAnnotations) {
+    DetachAnnotationTables();
+    for (auto &[key, value] : annotations_) {
+        annotations->Set(key, id_, value);
+    }
+    for (auto &[key, value] : branchAnnotations_) {
+        branchAnnotations->Set(key, id_, value);
+    }
+    annotations_.clear();
+    branchAnnotations_.clear();
+    annotationTable_ = std::move(annotations);
+    branchAnnotationTable_ = std::move(branchAnnotations);
+}
+
+void Node::DetachAnnotationTables() {
+    if (annotationTable_) {
+        for (const auto &key : annotationTable_->Keys(id_)) {
+            annotations_[key] = annotationTable_->Get(key, id_);
+        }
+        annotationTable_.reset();
+    }
+    if (branchAnnotationTable_) {
+        for (const auto &key : branchAnnotationTable_->Keys(id_)) {
+            branchAnnotations_[key] = branchAnnotationTable_->Get(key, id_);
+        }
+        branchAnnotationTable_.reset();
+    }
+}
 
 bool Node::MakeBinary() {
+    std::vector<NodePtr> newNodes;
+    return MakeBinary(newNodes);
+}
+
+bool Node::MakeBinary(std::vector<NodePtr> &newNodes) {
     bool madeBinary = false;
     while (ChildCount() > 2) {
         // take the first two children and create a new node
@@ -159,6 +328,9 @@ bool Node::MakeBinary() {
         newNode->SetDistance(0);
         children_.insert(children_.begin(), newNode);
         newNode->SetParent(shared_from_this());
+        IndexChildren(0);
+        InvalidateNewick();
+        newNodes.push_back(newNode);
         madeBinary = true;
     }
     return madeBinary;
@@ -169,85 +341,73 @@ string Node::Newick() const {
     return Newick(options);
 }
 
-std::pair<string, string> Node::MakeCommentForNewick(
-    const NewickExportOptions &options) const {
-    string comment =
-        BuildCommentForNewick(comment_, annotations_, options, options.annotationKeys);
-    string branchComment = BuildCommentForNewick(branchComment_, branchAnnotations_,
-                                                 options, options.branchAnnotationKeys);
-    return std::make_pair(comment, branchComment);
-}
-
 void Node::ParseComment(const std::unordered_map<string, Converter> &converters) {
     if (comment_.empty()) return;
 
-    ParseRawComment(comment_, annotations_, converters);
+    ParseComment(comment_, converters, {});
 }
 
 void Node::ParseBranchComment(const std::unordered_map<string, Converter> &converters) {
     if (branchComment_.empty()) return;
 
-    ParseRawComment(branchComment_, branchAnnotations_, converters);
+    ParseBranchComment(branchComment_, converters, {});
 }
 
-string Node::Newick(const NewickExportOptions &options) const {
-    std::ostringstream oss;
-    double distance = Distance();
-    auto [comment, branchComment] = MakeCommentForNewick(options);
-
-    if (this->IsLeaf()) {
-        oss << Name();
-        if (options.includeBranchLengths && !std::isnan(distance)) {
-            if (options.decimalPrecision > 0) {
-                oss << comment << ":" << branchComment << std::fixed
-                    << std::setprecision(options.decimalPrecision) << distance;
-            } else {
-                oss << comment << ":" << branchComment << distance;
-            }
-        } else {
-            oss << comment;
+void Node::ParseComment(std::string_view comment,
+                        const std::unordered_map<string, Converter> &converters,
+                        const std::vector<string> &keys) {
+    ParseRawComment(comment, annotations_, converters, keys);
+    if (annotationTable_) {
+        for (auto &[key, value] : annotations_) {
+            annotationTable_->Set(key, id_, value);
         }
-    } else {
-        oss << "(";
-        string newickStr;
-        for (const auto &child : children_) {
-            newickStr += child->Newick(options) + ",";
-        }
-        newickStr.pop_back();
-        oss << newickStr << ")";
+        annotations_.clear();
+    }
+    InvalidateNewick();
+}
 
-        if (options.includeInternalNodeName && !name_.empty()) {
-            oss << name_;
-        }
-        if (options.includeBranchLengths && !std::isnan(distance)) {
-            if (options.decimalPrecision > 0) {
-                oss << comment << ":" << branchComment << std::fixed
-                    << std::setprecision(options.decimalPrecision) << distance;
-            } else {
-                oss << comment << ":" << branchComment << distance;
-            }
-        } else {
-            oss << comment;
+void Node::ParseBranchComment(std::string_view comment,
+                              const std::unordered_map<string, Converter> &converters,
+                              const std::vector<string> &keys) {
+    ParseRawComment(comment, branchAnnotations_, converters, keys);
+    if (branchAnnotationTable_) {
+        for (auto &[key, value] : branchAnnotations_) {
+            branchAnnotationTable_->Set(key, id_, value);
         }
+        branchAnnotations_.clear();
     }
-    return oss.str();
+    InvalidateNewick();
+}
+
+string Node::Newick(const NewickExportOptions &options) const {
+    string newick;
+    NewickWriter(options).Append(*this, newick);
+    return newick;
 }
 
 void Node::ComputeDescendantBitset(size_t size) {
-    if (descendantBitset_.size() != size) {
-        descendantBitset_.resize(size, false);
+    if (descendantBitset_.Size() != size) {
+        descendantBitset_.Resize(size);
+    } else {
+        descendantBitset_.Clear();
     }
 
     if (IsLeaf()) {
-        descendantBitset_[Id()] = true;
+        descendantBitset_.Set(Id());
     } else {
-        std::fill(descendantBitset_.begin(), descendantBitset_.end(), false);
+        for (const auto &child : children_) {
+            descendantBitset_ |= child->DescendantBitset();
+        }
+    }
+}
 
-        for (auto child : Children()) {
-            auto &childBitset = child->DescendantBitset();
-            for (size_t i = 0; i < size; i++) {
-                descendantBitset_[i] = descendantBitset_[i] | childBitset[i];
-            }
+void Node::ComputeSplitHash() {
+    if (IsLeaf()) {
+        splitHash_ = TaxonKey(Id());
+    } else {
+        splitHash_ = 0;
+        for (const auto &child : children_) {
+            splitHash_ ^= child->splitHash_;
         }
     }
 }
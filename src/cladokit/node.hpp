@@ -5,15 +5,21 @@
 
 #include <any>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <limits>
 #include <map>
 #include <memory>
 #include <stack>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "cladokit/annotation_table.hpp"
+#include "cladokit/bitset.hpp"
 #include "cladokit/newick_options.hpp"
 #include "cladokit/utils.hpp"
 
@@ -30,6 +36,10 @@ class Node : public std::enable_shared_from_this<Node> {
 
     void SetName(const std::string &name);
 
+    // Bring the node back to the state of a new node named name, keeping the capacity
+    // of its strings and of its list of children so that it can be reused.
+    void Reset(std::string_view name = std::string_view());
+
     size_t Id() const;
 
     void SetId(size_t id);
@@ -50,9 +60,17 @@ class Node : public std::enable_shared_from_this<Node> {
 
     bool RemoveChild(NodePtr node);
 
-    void RemoveParent() { parent_.reset(); }
+    void RemoveParent() {
+        DetachNewickSpan();
+        parent_.reset();
+        rawParent_ = nullptr;
+    }
 
-    void SetParent(NodePtr parent) { parent_ = parent; }
+    void SetParent(NodePtr parent) {
+        DetachNewickSpan();
+        parent_ = parent;
+        rawParent_ = parent.get();
+    }
 
     NodePtr Parent() const { return parent_.lock(); }
 
@@ -74,6 +92,9 @@ class Node : public std::enable_shared_from_this<Node> {
 
     template <typename T>
     T Annotation(const std::string &key) const {
+        if (annotationTable_) {
+            return annotationTable_->Get<T>(key, id_);
+        }
         auto it = annotations_.find(key);
         if (it == annotations_.end()) {
             throw std::out_of_range("Key not found: " + key);
@@ -87,7 +108,10 @@ class Node : public std::enable_shared_from_this<Node> {
 
     void RemoveAnnotation(const std::string &key);
 
-    void SetComment(const std::string &comment) { comment_ = comment; }
+    void SetComment(const std::string &comment) {
+        comment_ = comment;
+        InvalidateNewick();
+    }
 
     const std::string &Comment() const { return comment_; }
 
@@ -103,6 +127,9 @@ class Node : public std::enable_shared_from_this<Node> {
 
     template <typename T>
     T BranchAnnotation(const std::string &key) const {
+        if (branchAnnotationTable_) {
+            return branchAnnotationTable_->Get<T>(key, id_);
+        }
         auto it = branchAnnotations_.find(key);
         if (it == branchAnnotations_.end()) {
             throw std::out_of_range("Key not found: " + key);
@@ -116,29 +143,67 @@ class Node : public std::enable_shared_from_this<Node> {
 
     void SetBranchComment(const std::string &branchComment) {
         branchComment_ = branchComment;
+        InvalidateNewick();
     }
 
     const std::string &BranchComment() const { return branchComment_; }
 
     void RemoveBranchAnnotation(const std::string &key);
 
+    // Store the annotations of this node in row Id() of the tables instead of the
+    // node. Existing annotations are moved to the tables.
+    void AttachAnnotationTables(std::shared_ptr<AnnotationTable> annotations,
+                                std::shared_ptr<AnnotationTable> branchAnnotations);
+
+    // Move the annotations stored in the tables back to the node.
+    void DetachAnnotationTables();
+
+    const std::shared_ptr<AnnotationTable> &NodeAnnotationTable() const {
+        return annotationTable_;
+    }
+
     bool MakeBinary();
 
+    // The nodes created to resolve the polytomy are appended to newNodes, each
+    // after its children.
+    bool MakeBinary(std::vector<NodePtr> &newNodes);
+
     bool IsBinary() const { return children_.size() == 2; }
 
     std::string Newick() const;
 
     std::string Newick(const NewickExportOptions &options) const;
 
+    // Mark the newick strings cached for this node and its ancestors as outdated (see
+    // Tree::EnableNewickCache). The setters of the node call it, changes made directly
+    // to the annotation tables must be followed by a call.
+    void InvalidateNewick();
+
     void ParseComment(
         const std::unordered_map<std::string, cladokit::Converter> &converters);
 
     void ParseBranchComment(
         const std::unordered_map<std::string, cladokit::Converter> &converters);
 
+    // Decode the annotations of comment whose key is in keys (all if keys is empty).
+    void ParseComment(
+        std::string_view comment,
+        const std::unordered_map<std::string, cladokit::Converter> &converters,
+        const std::vector<std::string> &keys);
+
+    void ParseBranchComment(
+        std::string_view comment,
+        const std::unordered_map<std::string, cladokit::Converter> &converters,
+        const std::vector<std::string> &keys);
+
     void ComputeDescendantBitset(size_t size);
 
-    const std::vector<bool> &DescendantBitset() const { return descendantBitset_; }
+    const Bitset &DescendantBitset() const { return descendantBitset_; }
+
+    // XOR of the TaxonKey of the descendant leaves. Children must be hashed first.
+    void ComputeSplitHash();
+
+    uint64_t SplitHash() const { return splitHash_; }
 
     class PostOrderIterator;
     class PreOrderIterator;
@@ -148,22 +213,114 @@ class Node : public std::enable_shared_from_this<Node> {
     PreOrderIterator begin_preorder();
     PreOrderIterator end_preorder();
 
+    // Stackless traversals following parent links: no allocation and no reference
+    // counting. For example: for (Node& node : root->PostOrder()) {...}
+    class TraversalIterator;
+    class TraversalRange;
+
+    TraversalRange PostOrder();
+    TraversalRange PreOrder();
+
    private:
+    friend class NewickCache;
+    friend class NewickWriter;
+
+    // Position of the newick string of the subtree rooted at this node in the buffer
+    // of the NewickCache that wrote it last.
+    struct NewickSpan {
+        // from the start of the parent string, or from the start of the buffer of
+        // generation if absolute
+        size_t offset = 0;
+        size_t length = 0;
+        uint64_t generation = 0;  // 0 if the position is unknown
+        bool valid = false;       // the string is up to date
+        bool absolute = false;
+    };
+
     std::string name_;
     size_t id_ = 0;
     std::weak_ptr<Node> parent_;
+    Node *rawParent_ = nullptr;
+    size_t childIndex_ = 0;  // index of the node in the children of its parent
     std::vector<NodePtr> children_;
     double distance_ = std::numeric_limits<double>::quiet_NaN();
     std::map<std::string, std::any> annotations_;
     std::map<std::string, std::any> branchAnnotations_;
+    std::shared_ptr<AnnotationTable> annotationTable_;
+    std::shared_ptr<AnnotationTable> branchAnnotationTable_;
     std::string comment_;  // raw comment extraced from newick file
     std::string branchComment_;
-    std::vector<bool> descendantBitset_;
+    Bitset descendantBitset_;
+    uint64_t splitHash_ = 0;
+    NewickSpan newickSpan_;
 
-    std::pair<std::string, std::string> MakeCommentForNewick(
-        const NewickExportOptions &options) const;
+    // Make the span absolute before the node changes parent.
+    void DetachNewickSpan();
+
+    // Next node in the traversal of the subtree rooted at root, nullptr at the end.
+    Node *NextPostOrder(const Node *root);
+    Node *NextPreOrder(const Node *root);
+    Node *NextSibling() const;
+
+    // Update the child index of the children from first onwards.
+    void IndexChildren(size_t first);
 };
 
+class Node::TraversalIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Node;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Node *;
+    using reference = Node &;
+
+    TraversalIterator(Node *node, const Node *root, bool postorder)
+        : node_(node), root_(root), postorder_(postorder) {}
+
+    Node &operator*() const { return *node_; }
+
+    Node *operator->() const { return node_; }
+
+    TraversalIterator &operator++() {
+        node_ = postorder_ ? node_->NextPostOrder(root_) : node_->NextPreOrder(root_);
+        return *this;
+    }
+
+    bool operator==(const TraversalIterator &other) const { return node_ == other.node_; }
+
+    bool operator!=(const TraversalIterator &other) const { return node_ != other.node_; }
+
+   private:
+    Node *node_;
+    const Node *root_;
+    bool postorder_;
+};
+
+class Node::TraversalRange {
+   public:
+    TraversalRange(Node *root, bool postorder) : root_(root), postorder_(postorder) {}
+
+    TraversalIterator begin() const {
+        Node *first = root_;
+        if (postorder_) {
+            while (!first->children_.empty()) first = first->children_.front().get();
+        }
+        return TraversalIterator(first, root_, postorder_);
+    }
+
+    TraversalIterator end() const {
+        return TraversalIterator(nullptr, root_, postorder_);
+    }
+
+   private:
+    Node *root_;
+    bool postorder_;
+};
+
+inline Node::TraversalRange Node::PostOrder() { return TraversalRange(this, true); }
+
+inline Node::TraversalRange Node::PreOrder() { return TraversalRange(this, false); }
+
 class Node::PostOrderIterator {
    public:
     explicit PostOrderIterator(NodePtr root = nullptr) {
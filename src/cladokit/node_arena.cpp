@@ -0,0 +1,78 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/node_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+using cladokit::NodeArena;
+
+namespace {
+// Smallest power of two not smaller than size and than minimum.
+size_t RoundUpToPowerOfTwo(size_t size, size_t minimum) {
+    size_t power = minimum;
+    while (power < size) power <<= 1;
+    return power;
+}
+}  // namespace
+
+NodeArena::NodeArena(size_t slabSize)
+    : slabSize_(RoundUpToPowerOfTwo(slabSize, kMinimumSlabSize)) {}
+
+NodeArena::~NodeArena() {
+    if (current_) Release(current_);
+}
+
+void *NodeArena::Allocate(size_t bytes, size_t alignment) {
+    auto address = reinterpret_cast<std::uintptr_t>(cursor_);
+    size_t padding = (alignment - address % alignment) % alignment;
+
+    if (current_ == nullptr || padding + bytes > remaining_) {
+        NewSlab(bytes + alignment);
+        address = reinterpret_cast<std::uintptr_t>(cursor_);
+        padding = (alignment - address % alignment) % alignment;
+    }
+
+    void *pointer = cursor_ + padding;
+    cursor_ += padding + bytes;
+    remaining_ -= padding + bytes;
+
+    current_->live.fetch_add(1, std::memory_order_relaxed);
+    allocationCount_++;
+    bytesAllocated_ += bytes;
+    bytesInUse_.fetch_add(bytes, std::memory_order_relaxed);
+    return pointer;
+}
+
+void NodeArena::Deallocate(void *pointer, size_t bytes) noexcept {
+    deallocationCount_.fetch_add(1, std::memory_order_relaxed);
+    bytesInUse_.fetch_sub(bytes, std::memory_order_relaxed);
+    // every allocation starts in the first slabSize_ bytes of its slab, whose header
+    // is aligned on slabSize_
+    auto address = reinterpret_cast<std::uintptr_t>(pointer);
+    Release(reinterpret_cast<Slab *>(address & ~(slabSize_ - 1)));
+}
+
+void NodeArena::NewSlab(size_t bytes) {
+    // oversized requests get their own slab
+    size_t size = std::max(slabSize_, sizeof(Slab) + bytes);
+    void *memory = ::operator new(size, std::align_val_t(slabSize_));
+    auto *slab = new (memory) Slab();
+    slabCount_.fetch_add(1, std::memory_order_relaxed);
+
+    // the previous slab is freed with its last allocation
+    if (current_) Release(current_);
+    current_ = slab;
+    cursor_ = reinterpret_cast<std::byte *>(slab) + sizeof(Slab);
+    remaining_ = size - sizeof(Slab);
+}
+
+void NodeArena::Release(Slab *slab) noexcept {
+    if (slab->live.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        slab->~Slab();
+        ::operator delete(slab, std::align_val_t(slabSize_));
+        slabCount_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
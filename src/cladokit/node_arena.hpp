@@ -0,0 +1,123 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "cladokit/node.hpp"
+
+namespace cladokit {
+
+// Bump allocator handing out memory from large slabs. A slab is freed once every
+// node allocated from it is freed and the arena moved on to a newer slab, so the
+// memory held by an arena is bounded by the nodes alive rather than by every node
+// ever allocated, e.g. when the trees of a file are read one at a time with Next.
+// Allocations must come from one thread at a time, whereas nodes can be freed on any
+// thread, e.g. trees handed over by a PrefetchingTreeFile.
+class NodeArena {
+   public:
+    static constexpr size_t kDefaultSlabSize = 1 << 20;
+
+    // Smallest slab size, slab sizes are rounded up to a power of two.
+    static constexpr size_t kMinimumSlabSize = 256;
+
+    explicit NodeArena(size_t slabSize = kDefaultSlabSize);
+
+    ~NodeArena();
+
+    NodeArena(const NodeArena &) = delete;
+
+    NodeArena &operator=(const NodeArena &) = delete;
+
+    void *Allocate(size_t bytes, size_t alignment);
+
+    void Deallocate(void *pointer, size_t bytes) noexcept;
+
+    size_t SlabSize() const { return slabSize_; }
+
+    // Number of slabs currently held.
+    size_t SlabCount() const { return slabCount_; }
+
+    size_t AllocationCount() const { return allocationCount_; }
+
+    size_t DeallocationCount() const { return deallocationCount_; }
+
+    size_t BytesAllocated() const { return bytesAllocated_; }
+
+    size_t BytesInUse() const { return bytesInUse_; }
+
+   private:
+    // Header at the start of every slab, which is aligned on slabSize_.
+    struct alignas(std::max_align_t) Slab {
+        // allocations not freed yet, plus one while it is the current slab
+        std::atomic<size_t> live = 1;
+    };
+
+    size_t slabSize_;
+    Slab *current_ = nullptr;
+    std::byte *cursor_ = nullptr;
+    size_t remaining_ = 0;
+    size_t allocationCount_ = 0;
+    size_t bytesAllocated_ = 0;
+    // updated by Deallocate
+    std::atomic<size_t> slabCount_ = 0;
+    std::atomic<size_t> deallocationCount_ = 0;
+    std::atomic<size_t> bytesInUse_ = 0;
+
+    // Make a slab of at least bytes after its header the current slab.
+    void NewSlab(size_t bytes);
+
+    // Drop a reference to slab and free it if it was the last one.
+    void Release(Slab *slab) noexcept;
+};
+
+// Allocator to use with std::allocate_shared. Every copy keeps the arena alive.
+template <typename T>
+class ArenaAllocator {
+   public:
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<NodeArena> arena)
+        : arena_(std::move(arena)) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena_(other.Arena()) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(arena_->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *pointer, size_t n) noexcept {
+        arena_->Deallocate(pointer, n * sizeof(T));
+    }
+
+    const std::shared_ptr<NodeArena> &Arena() const { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const {
+        return arena_ == other.Arena();
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const {
+        return arena_ != other.Arena();
+    }
+
+   private:
+    std::shared_ptr<NodeArena> arena_;
+};
+
+// Create a node from arena, or from the heap if arena is null.
+template <typename... Args>
+Node::NodePtr MakeNode(const std::shared_ptr<NodeArena> &arena, Args &&...args) {
+    if (arena) {
+        return std::allocate_shared<Node>(ArenaAllocator<Node>(arena),
+                                          std::forward<Args>(args)...);
+    }
+    return std::make_shared<Node>(std::forward<Args>(args)...);
+}
+}  // namespace cladokit
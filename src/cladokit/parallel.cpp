@@ -0,0 +1,62 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cladokit {
+
+size_t DefaultThreadCount() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+void ParallelFor(size_t count, size_t threadCount,
+                 const std::function<void(size_t index, size_t worker)> &body) {
+    if (threadCount == 0) threadCount = DefaultThreadCount();
+    threadCount = std::min(threadCount, count);
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            body(i, 0);
+        }
+        return;
+    }
+
+    // indices are handed out one at a time since the cost of each can vary a lot
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto work = [&](size_t worker) {
+        for (size_t i = next++; i < count && !failed; i = next++) {
+            try {
+                body(i, worker);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (size_t worker = 1; worker < threadCount; worker++) {
+        threads.emplace_back(work, worker);
+    }
+    work(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+}  // namespace cladokit
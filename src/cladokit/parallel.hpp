@@ -0,0 +1,20 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace cladokit {
+
+// Number of threads used when 0 threads are requested.
+size_t DefaultThreadCount();
+
+// Calls body(index, worker) for every index in [0, count) on up to threadCount
+// threads, the calling thread included. worker is the index of the thread in
+// [0, threadCount) so that each thread can use its own resources. The first
+// exception thrown by body is rethrown once every thread has stopped.
+void ParallelFor(size_t count, size_t threadCount,
+                 const std::function<void(size_t index, size_t worker)> &body);
+}  // namespace cladokit
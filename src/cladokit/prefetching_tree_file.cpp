@@ -0,0 +1,120 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/prefetching_tree_file.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using cladokit::PrefetchingTreeFile;
+using cladokit::Tree;
+using std::vector;
+
+PrefetchingTreeFile::PrefetchingTreeFile(std::shared_ptr<TreeFile> source,
+                                         size_t capacity)
+    : source_(std::move(source)), capacity_(std::max<size_t>(1, capacity)) {
+    if (!source_) {
+        throw std::invalid_argument("Prefetching requires a source file");
+    }
+}
+
+PrefetchingTreeFile::~PrefetchingTreeFile() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void PrefetchingTreeFile::Start() {
+    if (started_) return;
+    started_ = true;
+    thread_ = std::thread(&PrefetchingTreeFile::ReadAhead, this);
+}
+
+void PrefetchingTreeFile::ReadAhead() {
+    try {
+        while (source_->HasNext()) {
+            auto tree = source_->Next();
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] { return stop_ || trees_.size() < capacity_; });
+            if (stop_) return;
+            trees_.push_back(std::move(tree));
+            condition_.notify_all();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+    condition_.notify_all();
+}
+
+void PrefetchingTreeFile::CheckNotStarted(const char *method) const {
+    if (started_) {
+        throw std::logic_error(std::string(method) +
+                               " must be called before reading trees");
+    }
+}
+
+size_t PrefetchingTreeFile::Count() {
+    CheckNotStarted("Count");
+    return source_->Count();
+}
+
+void PrefetchingTreeFile::SetNodeArena(std::shared_ptr<NodeArena> arena) {
+    CheckNotStarted("SetNodeArena");
+    TreeFile::SetNodeArena(arena);
+    source_->SetNodeArena(std::move(arena));
+}
+
+void PrefetchingTreeFile::SetParseOptions(const NewickParseOptions &options) {
+    CheckNotStarted("SetParseOptions");
+    TreeFile::SetParseOptions(options);
+    source_->SetParseOptions(options);
+}
+
+void PrefetchingTreeFile::SetThreadCount(size_t threadCount) {
+    CheckNotStarted("SetThreadCount");
+    TreeFile::SetThreadCount(threadCount);
+    source_->SetThreadCount(threadCount);
+}
+
+vector<std::shared_ptr<Tree>> PrefetchingTreeFile::Parse() {
+    vector<std::shared_ptr<Tree>> trees;
+    while (HasNext()) {
+        trees.push_back(Next());
+    }
+    return trees;
+}
+
+bool PrefetchingTreeFile::HasNext() {
+    Start();
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] { return !trees_.empty() || finished_; });
+    if (trees_.empty() && error_) {
+        // the error is only reported once
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+    return !trees_.empty();
+}
+
+std::shared_ptr<Tree> PrefetchingTreeFile::Next() {
+    if (!HasNext()) return nullptr;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto tree = std::move(trees_.front());
+    trees_.pop_front();
+    condition_.notify_all();
+    return tree;
+}
+
+void PrefetchingTreeFile::SkipNext() { Next(); }
@@ -0,0 +1,80 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cladokit/tree.hpp"
+#include "cladokit/treeio.hpp"
+
+namespace cladokit {
+
+// Reads and parses the trees of another TreeFile on a background thread, ahead of
+// the consumer. At most capacity trees wait in the queue, the background thread
+// stops reading when it is full. An exception thrown while reading the source is
+// rethrown by the HasNext or Next call that reaches the failing tree.
+class PrefetchingTreeFile : public TreeFile {
+   public:
+    static constexpr size_t kDefaultCapacity = 16;
+
+    // source must not be used directly once trees are read from this file.
+    explicit PrefetchingTreeFile(std::shared_ptr<TreeFile> source,
+                                 size_t capacity = kDefaultCapacity);
+
+    ~PrefetchingTreeFile() override;
+
+    PrefetchingTreeFile(const PrefetchingTreeFile &) = delete;
+
+    PrefetchingTreeFile &operator=(const PrefetchingTreeFile &) = delete;
+
+    // Count of the source. Throws std::logic_error once reading has started because
+    // the source is then read by the background thread.
+    size_t Count() override;
+
+    // Remaining trees.
+    std::vector<std::shared_ptr<Tree>> Parse() override;
+
+    std::shared_ptr<Tree> Next() override;
+
+    bool HasNext() override;
+
+    void SkipNext() override;
+
+    size_t Capacity() const { return capacity_; }
+
+    // The settings are forwarded to the source. They throw std::logic_error once
+    // reading has started.
+    void SetNodeArena(std::shared_ptr<NodeArena> arena) override;
+
+    void SetParseOptions(const NewickParseOptions &options) override;
+
+    void SetThreadCount(size_t threadCount) override;
+
+   private:
+    void Start();
+
+    void CheckNotStarted(const char *method) const;
+
+    // Body of the background thread.
+    void ReadAhead();
+
+    std::shared_ptr<TreeFile> source_;
+    size_t capacity_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::shared_ptr<Tree>> trees_;
+    bool started_ = false;
+    bool finished_ = false;
+    bool stop_ = false;
+    std::exception_ptr error_;
+};
+}  // namespace cladokit
@@ -0,0 +1,24 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cladokit {
+
+// Pseudo-random 64 bit key of a taxon (Zobrist hashing).
+// The hash of a split is the XOR of the keys of the taxa it contains, so the hash of
+// a clade is the XOR of the hashes of its children and can be computed in a single
+// postorder pass. Keys only depend on the taxon index so hashes can be compared
+// across trees sharing the same taxon names.
+inline uint64_t TaxonKey(size_t taxon) {
+    // splitmix64
+    uint64_t z =
+        static_cast<uint64_t>(taxon) * 0x9e3779b97f4a7c15ULL + 0x2545f4914f6cdd1dULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+}  // namespace cladokit
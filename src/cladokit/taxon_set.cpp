@@ -0,0 +1,20 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/taxon_set.hpp"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using cladokit::TaxonSet;
+
+TaxonSet::TaxonSet(std::vector<std::string> names)
+    : names_(std::make_shared<const std::vector<std::string>>(std::move(names))) {
+    indices_.reserve(names_->size());
+    for (size_t i = 0; i < names_->size(); i++) {
+        // the first occurrence of a duplicated name wins
+        indices_.emplace((*names_)[i], i);
+    }
+}
@@ -0,0 +1,47 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cladokit {
+
+// Immutable list of taxon names with constant time lookup of the index of a name.
+// A single TaxonSet is meant to be shared by every tree read from the same file.
+class TaxonSet {
+   public:
+    static constexpr size_t kNotFound = std::numeric_limits<size_t>::max();
+
+    explicit TaxonSet(std::vector<std::string> names);
+
+    TaxonSet(const TaxonSet &) = delete;
+
+    TaxonSet &operator=(const TaxonSet &) = delete;
+
+    size_t Size() const { return names_->size(); }
+
+    const std::string &Name(size_t index) const { return (*names_)[index]; }
+
+    // Index of name or kNotFound.
+    size_t IndexOf(std::string_view name) const {
+        auto it = indices_.find(name);
+        return it == indices_.end() ? kNotFound : it->second;
+    }
+
+    bool Contains(std::string_view name) const { return indices_.count(name) > 0; }
+
+    std::shared_ptr<const std::vector<std::string>> Names() const { return names_; }
+
+   private:
+    std::shared_ptr<const std::vector<std::string>> names_;
+    // keys are views of the strings owned by names_
+    std::unordered_map<std::string_view, size_t> indices_;
+};
+}  // namespace cladokit
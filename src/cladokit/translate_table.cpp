@@ -0,0 +1,59 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/translate_table.hpp"
+
+#include <charconv>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+using cladokit::TaxonSet;
+using cladokit::TranslateTable;
+
+namespace {
+// Value of token if it is a decimal integer without sign.
+bool ParseInteger(std::string_view token, size_t &value) {
+    const char *last = token.data() + token.size();
+    auto [end, error] = std::from_chars(token.data(), last, value);
+    return error == std::errc() && end == last && !token.empty() && token[0] != '-';
+}
+}  // namespace
+
+TranslateTable::TranslateTable(const std::map<std::string, std::string> &translate,
+                               std::shared_ptr<const TaxonSet> taxa)
+    : taxa_(std::move(taxa)) {
+    tokens_.reserve(translate.size());
+    for (const auto &[token, name] : translate) {
+        size_t index = taxa_->IndexOf(name);
+        size_t number;
+        // integers are usually numbered from 1 to the number of taxa, a leading zero
+        // would make a different token with the same value
+        if (ParseInteger(token, number) && number <= 4 * translate.size() &&
+            (token.size() == 1 || token[0] != '0')) {
+            if (numbers_.size() <= number) {
+                numbers_.resize(number + 1, TaxonSet::kNotFound);
+            }
+            numbers_[number] = index;
+        } else {
+            tokens_.push_back(token);
+        }
+    }
+    indices_.reserve(tokens_.size());
+    for (const auto &token : tokens_) {
+        indices_.emplace(token, taxa_->IndexOf(translate.at(token)));
+    }
+}
+
+size_t TranslateTable::IndexOf(std::string_view token) const {
+    size_t number;
+    if (!numbers_.empty() && ParseInteger(token, number) && number < numbers_.size() &&
+        (token.size() == 1 || token[0] != '0')) {
+        return numbers_[number];
+    }
+    auto it = indices_.find(token);
+    return it == indices_.end() ? TaxonSet::kNotFound : it->second;
+}
@@ -0,0 +1,45 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "cladokit/taxon_set.hpp"
+
+namespace cladokit {
+
+// Translate block of a Nexus file resolved against a taxon set: the taxon index of
+// every token is looked up once, when the table is built. Integer tokens, the common
+// case, are looked up in a dense vector and other tokens in a hash map.
+class TranslateTable {
+   public:
+    // translate maps tokens to taxon names. Tokens whose name is not in taxa are
+    // mapped to TaxonSet::kNotFound.
+    TranslateTable(const std::map<std::string, std::string> &translate,
+                   std::shared_ptr<const TaxonSet> taxa);
+
+    TranslateTable(const TranslateTable &) = delete;
+
+    TranslateTable &operator=(const TranslateTable &) = delete;
+
+    // Taxon index of token, or TaxonSet::kNotFound if token is not translated.
+    size_t IndexOf(std::string_view token) const;
+
+    // Taxon set the indices refer to.
+    const std::shared_ptr<const TaxonSet> &Taxa() const { return taxa_; }
+
+   private:
+    std::shared_ptr<const TaxonSet> taxa_;
+    std::vector<size_t> numbers_;  // index of the token representing each integer
+    std::vector<std::string> tokens_;
+    // keys are views of the strings owned by tokens_
+    std::unordered_map<std::string_view, size_t> indices_;
+};
+}  // namespace cladokit
@@ -3,77 +3,194 @@
 
 #include "cladokit/tree.hpp"
 
+#include <algorithm>
 #include <iostream>
-#include <stack>
+#include <memory>
+#include <stdexcept>
 #include <string>
-#include <unordered_set>
-
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "cladokit/newick_tokenizer.hpp"
+#include "cladokit/newick_tree_builder.hpp"
+#include "cladokit/newick_writer.hpp"
+
+using cladokit::NewickCache;
+using cladokit::NewickTokenizer;
+using cladokit::NewickTreeBuilder;
+using cladokit::NewickWriter;
 using cladokit::Node;
+using cladokit::TaxonSet;
 using cladokit::Tree;
 using std::string;
 using std::vector;
-
-Tree::Tree(const Node::NodePtr &root) : root_(root) {
-    for (auto it = root->begin_postorder(); it != root->end_postorder(); ++it) {
-        auto node = *it;
-        if (node->IsLeaf()) {
-            node->SetId(leafCount_++);
-            taxonNames_->push_back(node->Name());
+using TokenType = cladokit::NewickTokenizer::TokenType;
+
+namespace {
+void AddTokens(std::string_view newick, NewickTreeBuilder &builder) {
+    NewickTokenizer tokenizer(newick);
+    for (auto token = tokenizer.Next(); token.type != TokenType::kEnd;
+         token = tokenizer.Next()) {
+        if (token.type == TokenType::kSemicolon) {
+            // only whitespace can follow the end of the tree
+            if (tokenizer.Next().type != TokenType::kEnd) {
+                throw std::invalid_argument(
+                    "Unexpected text after the tree at position " +
+                    std::to_string(tokenizer.Position()));
+            }
+            break;
+        }
+        try {
+            builder.Add(token);
+        } catch (const std::invalid_argument &error) {
+            throw std::invalid_argument(string(error.what()) + " at position " +
+                                        std::to_string(tokenizer.Position()));
         }
     }
-    nodes_.resize(leafCount_);
-    for (auto it = root->begin_postorder(); it != root->end_postorder(); ++it) {
-        auto node = *it;
-        if (!node->IsLeaf()) {
-            node->SetId(leafCount_ + internalCount_++);
-            nodes_.push_back(node);
-        } else {
-            nodes_[node->Id()] = node;
+}
+}  // namespace
+
+Tree::Tree(const Node::NodePtr &root) : root_(root) {
+    vector<string> taxonNames;
+    for (const Node &node : root->PostOrder()) {
+        if (node.IsLeaf()) {
+            taxonNames.push_back(node.Name());
         }
     }
-    nodeCount_ = leafCount_ + internalCount_;
+    taxonSet_ = std::make_shared<TaxonSet>(std::move(taxonNames));
+    UpdateIDs();
+}
+
+Tree::Tree(const Node::NodePtr &root, std::shared_ptr<const vector<string>> taxonNames)
+    : root_(root), taxonSet_(std::make_shared<TaxonSet>(*taxonNames)) {
+    UpdateIDs();
+}
+
+Tree::Tree(const Node::NodePtr &root, std::shared_ptr<const TaxonSet> taxonSet)
+    : root_(root), taxonSet_(taxonSet) {
+    UpdateIDs();
 }
 
-Tree::Tree(const Node::NodePtr &root, std::shared_ptr<vector<string>> taxonNames)
-    : root_(root), taxonNames_(taxonNames) {
+void Tree::SetTaxonNames(std::shared_ptr<const vector<string>> taxonNames) {
+    taxonSet_ = std::make_shared<TaxonSet>(*taxonNames);
     UpdateIDs();
 }
 
-void Tree::SetTaxonNames(std::shared_ptr<std::vector<string>> taxonNames) {
-    taxonNames_ = taxonNames;
+void Tree::SetTaxonSet(std::shared_ptr<const TaxonSet> taxonSet) {
+    taxonSet_ = taxonSet;
     UpdateIDs();
 }
 
 void Tree::UpdateIDs() {
     internalCount_ = 0;
-    leafCount_ = taxonNames_->size();
+    leafCount_ = taxonSet_->Size();
     nodes_.clear();
     nodes_.resize(leafCount_);
+    InvalidateTraversals();
+
+    // rows of the annotation tables follow the node ids
+    vector<size_t> previousRows;
+    vector<Node *> detachedNodes;
+
+    for (Node &node : root_->PostOrder()) {
+        size_t previousId = node.Id();
+        bool attached =
+            annotationTable_ && node.NodeAnnotationTable() == annotationTable_;
+        if (annotationTable_ && !attached) {
+            node.DetachAnnotationTables();
+            detachedNodes.push_back(&node);
+        }
 
-    for (auto it = root_->begin_postorder(); it != root_->end_postorder(); ++it) {
-        auto node = *it;
-        if (!node->IsLeaf()) {
-            node->SetId(leafCount_ + internalCount_++);
-            nodes_.push_back(node);
+        if (!node.IsLeaf()) {
+            node.SetId(leafCount_ + internalCount_++);
+            nodes_.push_back(node.shared_from_this());
+            postorder_.push_back(node.Id());
         } else {
-            auto it = std::find(taxonNames_->begin(), taxonNames_->end(), node->Name());
-            if (it != taxonNames_->end()) {
-                size_t taxonIndex = std::distance(taxonNames_->begin(), it);
-                node->SetId(taxonIndex);
-                nodes_[taxonIndex] = node;
+            // leaves usually already have the right id, e.g. when they were numbered
+            // while parsing
+            size_t taxonIndex = previousId;
+            if (taxonIndex >= leafCount_ || taxonSet_->Name(taxonIndex) != node.Name()) {
+                taxonIndex = taxonSet_->IndexOf(node.Name());
+            }
+            if (taxonIndex != TaxonSet::kNotFound) {
+                node.SetId(taxonIndex);
+                nodes_[taxonIndex] = node.shared_from_this();
+                postorder_.push_back(taxonIndex);
             } else {
-                std::cerr << "Error: taxon name " << node->Name()
+                std::cerr << "Error: taxon name " << node.Name()
                           << " not found in taxon names" << std::endl;
             }
         }
+
+        if (attached) {
+            if (previousRows.size() <= node.Id()) {
+                previousRows.resize(node.Id() + 1, AnnotationTable::kNoRow);
+            }
+            previousRows[node.Id()] = previousId;
+        }
     }
     nodeCount_ = leafCount_ + internalCount_;
+
+    if (annotationTable_) {
+        previousRows.resize(nodeCount_, AnnotationTable::kNoRow);
+        annotationTable_->Remap(previousRows);
+        branchAnnotationTable_->Remap(previousRows);
+        for (Node *node : detachedNodes) {
+            node->AttachAnnotationTables(annotationTable_, branchAnnotationTable_);
+        }
+    }
+}
+
+void Tree::EnableAnnotationTables() {
+    if (annotationTable_) return;
+    annotationTable_ = std::make_shared<AnnotationTable>(nodeCount_);
+    branchAnnotationTable_ = std::make_shared<AnnotationTable>(nodeCount_);
+    for (const auto &node : nodes_) {
+        if (node) {
+            node->AttachAnnotationTables(annotationTable_, branchAnnotationTable_);
+        }
+    }
+}
+
+void Tree::DisableAnnotationTables() {
+    for (const auto &node : nodes_) {
+        if (node) {
+            node->DetachAnnotationTables();
+        }
+    }
+    annotationTable_.reset();
+    branchAnnotationTable_.reset();
+}
+
+void Tree::InvalidateTraversals() {
+    postorder_.clear();
+    preorder_.clear();
+}
+
+const vector<size_t> &Tree::PostOrderIds() {
+    if (postorder_.empty()) {
+        postorder_.reserve(nodeCount_);
+        for (const Node &node : root_->PostOrder()) {
+            postorder_.push_back(node.Id());
+        }
+    }
+    return postorder_;
+}
+
+const vector<size_t> &Tree::PreOrderIds() {
+    if (preorder_.empty()) {
+        preorder_.reserve(nodeCount_);
+        for (const Node &node : root_->PreOrder()) {
+            preorder_.push_back(node.Id());
+        }
+    }
+    return preorder_;
 }
 
 Node::NodePtr Tree::LeafFromName(const string &name) const {
-    auto it = std::find(taxonNames_->begin(), taxonNames_->end(), name);
-    if (it != taxonNames_->end()) {
-        size_t index = static_cast<size_t>(std::distance(taxonNames_->begin(), it));
+    size_t index = taxonSet_->IndexOf(name);
+    if (index != TaxonSet::kNotFound) {
         return nodes_.at(index);
     } else {
         return nullptr;
@@ -102,152 +219,147 @@ bool Tree::MakeUnRooted() {
         }
         auto node = *it;
         node->Collapse();
-        UpdateIDs();
+        // the clades of the root and of the moved children are unchanged
+        RemoveNode(node);
+        InvalidateTraversals();
     }
     return degree == 2;
 }
 
 bool Tree::MakeBinary() {
     bool madeBinary = false;
-    for (auto it = root_->begin_postorder(); it != root_->end_postorder(); ++it) {
-        auto node = *it;
+    vector<Node::NodePtr> newNodes;
+    for (size_t id : PostOrderIds()) {
+        const auto &node = nodes_[id];
         if (node->IsLeaf()) continue;
         size_t degree = node->ChildCount();
         if (degree > 2) {
-            madeBinary |= node->MakeBinary();
+            madeBinary |= node->MakeBinary(newNodes);
         }
     }
+    // only the new nodes need an id and a clade, each is created after its children
+    for (const auto &node : newNodes) {
+        AddNode(node);
+        UpdateClade(*node);
+    }
     if (madeBinary) {
-        UpdateIDs();
+        InvalidateTraversals();
     }
     return madeBinary;
 }
 
-string Tree::Newick() { return root_->Newick() + ";"; }
+string Tree::Newick() { return Newick(NewickExportOptions()); }
 
 string Tree::Newick(const NewickExportOptions &options) {
-    return root_->Newick(options) + ";";
+    string newick;
+    NewickWriter(options).Append(*this, newick);
+    return newick;
+}
+
+void Tree::EnableNewickCache(const NewickExportOptions &options) {
+    newickCache_ = std::make_shared<NewickCache>(options);
 }
 
-Tree::TreePtr Tree::FromNewick(const string &newick) {
+const string &Tree::CachedNewick() {
+    if (!newickCache_) {
+        throw std::logic_error("Tree::EnableNewickCache must be called first");
+    }
+    return newickCache_->Update(*root_);
+}
+
+Tree::TreePtr Tree::FromNewick(std::string_view newick) {
     auto taxonNames = std::make_shared<std::vector<string>>();
     return FromNewick(newick, taxonNames);
 }
 
-Tree::TreePtr Tree::FromNewick(const string &newick,
+Tree::TreePtr Tree::FromNewick(std::string_view newick,
                                std::shared_ptr<std::vector<string>> taxonNames) {
-    size_t taxonCounter = 0;
-    std::stack<Node::NodePtr> nodeStack;
-    std::vector<string> currentTaxonNames;
-    bool justClosed = false;
-
-    for (size_t i = 0; i < newick.size(); i++) {
-        char c = newick.at(i);
-        // node comment
-        if (c == '[') {
-            size_t start = i++;
-            while (newick.at(i) != ']') {
-                i++;
-            }
-            const string comment = newick.substr(start, i - start + 1);
-            nodeStack.top()->SetComment(comment);
-            //   std::cout << "Comment: " << comment << " for "
-            //             << nodeStack.top()->GetName() << std::endl;
-        } else if (c == ':') {
-            size_t start = ++i;
-            // branch comment
-            if (newick.at(i) == '[') {
-                while (newick.at(i) != ']') {
-                    i++;
-                }
-                const string comment = newick.substr(start, i - start + 1);
-                nodeStack.top()->SetBranchComment(comment);
-                start = ++i;
-            }
+    return FromNewick(newick, taxonNames, nullptr);
+}
 
-            for (; i < newick.size(); i++) {
-                c = newick.at(i);
-                if (c == '[' || c == ',' || c == ')' || c == ';') {
-                    i--;
-                    break;
-                }
-            }
-            const string branchLengthString = newick.substr(start, i - start + 1);
-            //   std::cout << "Branch length: " << branchLengthString << " for "
-            //             << nodeStack.top()->GetName() << std::endl;
-            double branchLength = std::stod(branchLengthString);
-            nodeStack.top()->SetDistance(branchLength);
-        } else if (c != '(' && c != ')' && c != ',' && c != ';') {
-            size_t start = i;
-            for (; i < newick.size(); i++) {
-                c = newick.at(i);
-                if (c == ':' || c == '[' || c == ',' || c == ')' || c == ';') {
-                    i--;
-                    break;
-                }
-            }
-            const string identifier = newick.substr(start, i - start + 1);
+Tree::TreePtr Tree::FromNewick(std::string_view newick,
+                               std::shared_ptr<std::vector<string>> taxonNames,
+                               const std::shared_ptr<NodeArena> &arena) {
+    return FromNewick(newick, taxonNames, NewickParseOptions(), arena);
+}
 
-            if (justClosed) {
-                nodeStack.top()->SetName(identifier);
-            } else {
-                // should strip quotes if present and requested
-                size_t taxonIndex = 0;
-                taxonIndex = taxonCounter++;
-                currentTaxonNames.push_back(identifier);
-                auto node = std::make_shared<Node>(identifier);
-                node->SetId(taxonIndex);
-                // std::cout << "Taxon: " << identifier << " (" << taxonIndex << ")"
-                //           << std::endl;
-                nodeStack.top()->AddChild(node);
-                nodeStack.push(node);
-            }
-        } else if (c == '(') {
-            justClosed = false;
-            auto node = std::make_shared<Node>();
-            if (!nodeStack.empty()) {
-                nodeStack.top()->AddChild(node);
-            }
-            nodeStack.push(node);
-        } else if (c == ')' || c == ',') {
-            //   std::cout << "pop Node: " << nodeStack.top()->GetName() << std::endl;
-            nodeStack.pop();
-            // check if there is a name after the closing parenthesis
-            justClosed = c == ')';
-        } else {
-            // std::cout << "Unknown character: " << c << std::endl;
-        }
+Tree::TreePtr Tree::FromNewick(std::string_view newick,
+                               std::shared_ptr<std::vector<string>> taxonNames,
+                               const NewickParseOptions &options,
+                               const std::shared_ptr<NodeArena> &arena) {
+    if (taxonNames->empty()) {
+        return Parse(newick, nullptr, taxonNames, options, arena);
     }
+    return Parse(newick, std::make_shared<TaxonSet>(*taxonNames), nullptr, options,
+                 arena);
+}
 
-    if (taxonNames->empty()) {
-        *taxonNames = currentTaxonNames;
-    } else if (std::unordered_set<string>(taxonNames->begin(), taxonNames->end()) !=
-               std::unordered_set<string>(currentTaxonNames.begin(),
-                                          currentTaxonNames.end())) {
-        std::cerr << "Error: taxon names do not match" << std::endl;
-        for (const auto &name : currentTaxonNames) {
-            if (std::find(taxonNames->begin(), taxonNames->end(), name) ==
-                taxonNames->end()) {
-                std::cerr << "Missing taxon name: " << name << std::endl;
-            }
-        }
-        for (const auto &name : *taxonNames) {
-            if (std::find(currentTaxonNames.begin(), currentTaxonNames.end(), name) ==
-                currentTaxonNames.end()) {
-                std::cerr << "Extra taxon name: " << name << std::endl;
-            }
-        }
+Tree::TreePtr Tree::FromNewick(std::string_view newick,
+                               std::shared_ptr<const TaxonSet> taxonSet,
+                               const NewickParseOptions &options,
+                               const std::shared_ptr<NodeArena> &arena) {
+    if (taxonSet) {
+        return Parse(newick, taxonSet, nullptr, options, arena);
     }
+    return Parse(newick, nullptr, std::make_shared<vector<string>>(), options, arena);
+}
 
-    auto tree = std::make_shared<Tree>(nodeStack.top(), taxonNames);
-    return tree;
+Tree::TreePtr Tree::Parse(std::string_view newick,
+                          std::shared_ptr<const TaxonSet> taxonSet,
+                          std::shared_ptr<std::vector<string>> taxonNames,
+                          const NewickParseOptions &options,
+                          const std::shared_ptr<NodeArena> &arena) {
+    NewickTreeBuilder builder(taxonSet, taxonNames, options, arena);
+    AddTokens(newick, builder);
+    return builder.Build();
+}
+
+void Tree::Rebuild(std::string_view newick, std::shared_ptr<const TaxonSet> taxonSet,
+                   const NewickParseOptions &options,
+                   const std::shared_ptr<NodeArena> &arena) {
+    if (!taxonSet) {
+        throw std::invalid_argument("Rebuild requires a taxon set");
+    }
+    // the annotations of the previous tree are dropped with it
+    annotationTable_.reset();
+    branchAnnotationTable_.reset();
+    annotations_.clear();
+    comment_.clear();
+    hasBitsets_ = false;
+    hasSplitHashes_ = false;
+
+    taxonSet_ = taxonSet;
+    try {
+        NewickTreeBuilder builder(taxonSet, nullptr, options, arena);
+        builder.Recycle(&nodes_, leafCount_);
+        AddTokens(newick, builder);
+        root_ = builder.Finish();
+    } catch (...) {
+        // the recycled nodes were already reset, only an empty tree is left
+        root_.reset();
+        nodes_.clear();
+        leafCount_ = 0;
+        internalCount_ = 0;
+        nodeCount_ = 0;
+        InvalidateTraversals();
+        throw;
+    }
+    // the nodes that were not reused are released here
+    UpdateIDs();
 }
 
 void Tree::ComputeDescendantBitset() {
+    hasBitsets_ = true;
     size_t bitsetSize = LeafNodeCount();
-    for (auto it = root_->begin_postorder(); it != root_->end_postorder(); ++it) {
-        auto node = *it;
-        node->ComputeDescendantBitset(bitsetSize);
+    for (size_t id : PostOrderIds()) {
+        nodes_[id]->ComputeDescendantBitset(bitsetSize);
+    }
+}
+
+void Tree::ComputeSplitHashes() {
+    hasSplitHashes_ = true;
+    for (size_t id : PostOrderIds()) {
+        nodes_[id]->ComputeSplitHash();
     }
 }
 
@@ -275,11 +387,14 @@ void Tree::ReRootAbove(std::shared_ptr<Node> node) {
             parentNode->AddChild(newNode);
             newNode->SetDistance(midpoint);
 
-            UpdateIDs();
+            AddNode(newNode);
+            UpdateClade(*newNode);
+            InvalidateTraversals();
         } else {
             siblings[0]->SetDistance(siblings[0]->Distance() + midpoint);
         }
     } else {
+        auto oldRoot = root_;
         std::shared_ptr<Node> newRoot = std::make_shared<Node>();
         auto parent = node->Parent();
         auto grandParent = parent->Parent();
@@ -303,6 +418,9 @@ void Tree::ReRootAbove(std::shared_ptr<Node> node) {
         node->SetParent(newRoot);
         parent->SetParent(newRoot);
 
+        // nodes between the new root and the old root, their clades are flipped
+        vector<Node *> path = {parent.get()};
+
         while (!nParent->IsRoot()) {
             auto temp = nParent->Parent();
             n->AddChild(nParent);  // nparent has n as parent now
@@ -315,6 +433,7 @@ void Tree::ReRootAbove(std::shared_ptr<Node> node) {
 
             n = nParent;
             nParent = temp;
+            path.push_back(n.get());
 
             if (nParent) {
                 auto temp2 = n->Parent();
@@ -325,15 +444,87 @@ void Tree::ReRootAbove(std::shared_ptr<Node> node) {
 
         // nparent is the old root and the affected lineage disconnected.
         // n is the child of the old root that was flipped
-        if (nParent && nParent->ChildCount() > 0) {
+        size_t remainingCount = nParent->ChildCount();
+        root_ = newRoot;
+        if (remainingCount == 1) {
+            // the old root is dissolved into its other child and the new root takes
+            // its id
             auto unaffectedSibling = nParent->ChildAt(0);
             unaffectedSibling->SetDistance(unaffectedSibling->Distance() + branchLength);
             n->AddChild(unaffectedSibling);
+            ReplaceNode(oldRoot, newRoot);
+        } else if (remainingCount > 1) {
+            // the old root, e.g. of an unrooted tree, stays an internal node with its
+            // id and its other children
+            oldRoot->SetDistance(branchLength);
+            n->AddChild(oldRoot);
+            AddNode(newRoot);
+            UpdateClade(*oldRoot);
+        } else {
+            UpdateIDs();
+            if (hasBitsets_) ComputeDescendantBitset();
+            if (hasSplitHashes_) ComputeSplitHashes();
+            return;
         }
+        // only the clades of the nodes on the path change
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            UpdateClade(**it);
+        }
+        UpdateClade(*newRoot);
+        InvalidateTraversals();
+    }
+}
 
-        root_ = newRoot;
-        UpdateIDs();
+void Tree::AddNode(const Node::NodePtr &node) {
+    node->SetId(nodeCount_++);
+    internalCount_++;
+    nodes_.push_back(node);
+    if (annotationTable_) {
+        annotationTable_->Resize(nodeCount_);
+        branchAnnotationTable_->Resize(nodeCount_);
+        node->AttachAnnotationTables(annotationTable_, branchAnnotationTable_);
+    }
+}
+
+void Tree::ReplaceNode(const Node::NodePtr &node, const Node::NodePtr &replacement) {
+    size_t id = node->Id();
+    if (annotationTable_) {
+        node->DetachAnnotationTables();
+        annotationTable_->ClearRow(id);
+        branchAnnotationTable_->ClearRow(id);
+    }
+    replacement->SetId(id);
+    nodes_[id] = replacement;
+    if (annotationTable_) {
+        replacement->AttachAnnotationTables(annotationTable_, branchAnnotationTable_);
+    }
+}
+
+void Tree::RemoveNode(const Node::NodePtr &node) {
+    // the node with the last id takes the id of the removed node
+    size_t id = node->Id();
+    size_t last = nodeCount_ - 1;
+    if (annotationTable_) {
+        node->DetachAnnotationTables();
+        if (id != last) {
+            annotationTable_->MoveRow(last, id);
+            branchAnnotationTable_->MoveRow(last, id);
+        }
+        annotationTable_->Resize(last);
+        branchAnnotationTable_->Resize(last);
     }
+    if (id != last) {
+        nodes_[id] = nodes_[last];
+        nodes_[id]->SetId(id);
+    }
+    nodes_.pop_back();
+    internalCount_--;
+    nodeCount_--;
+}
+
+void Tree::UpdateClade(Node &node) {
+    if (hasBitsets_) node.ComputeDescendantBitset(LeafNodeCount());
+    if (hasSplitHashes_) node.ComputeSplitHash();
 }
 
 Tree::TreePtr Tree::Random(std::vector<string> taxonNames) {
@@ -355,5 +546,5 @@ Tree::TreePtr Tree::Random(std::vector<string> taxonNames) {
         nodes.erase(nodes.begin() + std::min(index1, index2));
     }
     return std::make_shared<Tree>(nodes[0],
-                                  std::make_shared<std::vector<string>>(taxonNames));
+                                  std::make_shared<TaxonSet>(std::move(taxonNames)));
 }
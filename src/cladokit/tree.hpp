@@ -7,10 +7,15 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "cladokit/annotation_table.hpp"
+#include "cladokit/newick_cache.hpp"
 #include "cladokit/newick_options.hpp"
 #include "cladokit/node.hpp"
+#include "cladokit/node_arena.hpp"
+#include "cladokit/taxon_set.hpp"
 
 namespace cladokit {
 
@@ -20,11 +25,22 @@ class Tree {
 
     explicit Tree(const Node::NodePtr& root);
 
-    Tree(const Node::NodePtr& root, std::shared_ptr<std::vector<std::string>> taxonNames);
+    // taxonNames is copied into the taxon set of the tree.
+    Tree(const Node::NodePtr& root,
+         std::shared_ptr<const std::vector<std::string>> taxonNames);
 
-    std::shared_ptr<std::vector<std::string>> TaxonNames() const { return taxonNames_; }
+    // Leaf ids are the indices of the leaf names in taxonSet.
+    Tree(const Node::NodePtr& root, std::shared_ptr<const TaxonSet> taxonSet);
 
-    void SetTaxonNames(std::shared_ptr<std::vector<std::string>> taxonNames);
+    std::shared_ptr<const std::vector<std::string>> TaxonNames() const {
+        return taxonSet_->Names();
+    }
+
+    std::shared_ptr<const TaxonSet> Taxa() const { return taxonSet_; }
+
+    void SetTaxonNames(std::shared_ptr<const std::vector<std::string>> taxonNames);
+
+    void SetTaxonSet(std::shared_ptr<const TaxonSet> taxonSet);
 
     size_t NodeCount() const { return nodeCount_; }
 
@@ -34,12 +50,32 @@ class Tree {
 
     Node::NodePtr Root() const { return root_; }
 
+    Node::TraversalRange PostOrder() const { return root_->PostOrder(); }
+
+    Node::TraversalRange PreOrder() const { return root_->PreOrder(); }
+
     Node::NodePtr NodeFromId(size_t id) const { return nodes_.at(id); }
 
+    // Nodes indexed by id.
+    const std::vector<Node::NodePtr>& Nodes() const { return nodes_; }
+
+    // Node ids in postorder. Built by UpdateIDs and cached until the topology changes.
+    const std::vector<size_t>& PostOrderIds();
+
+    // Node ids in preorder, built on first use and cached until the topology changes.
+    const std::vector<size_t>& PreOrderIds();
+
+    // Must be called after the topology was modified through the Node API, unless
+    // UpdateIDs is called.
+    void InvalidateTraversals();
+
     Node::NodePtr LeafFromName(const std::string& name) const;
 
     bool IsRooted() const { return root_->ChildCount() == 2; }
 
+    // The following functions update the ids incrementally: new nodes get the next
+    // free id and the node with the last id takes the id of a removed node, so
+    // internal node ids are not in postorder anymore.
     bool MakeRooted();  // return true if the tree was unrooted (i.e. degree > 2)
 
     bool MakeUnRooted();  // return true if the tree was rooted (i.e. degree = 2)
@@ -54,23 +90,104 @@ class Tree {
 
     std::string Newick(const NewickExportOptions& options);
 
+    // Keep the newick string of the tree between calls to CachedNewick so that only
+    // the subtrees modified since the previous call are formatted again.
+    void EnableNewickCache(const NewickExportOptions& options = NewickExportOptions());
+
+    void DisableNewickCache() { newickCache_.reset(); }
+
+    // Same as Newick(options) with the options of EnableNewickCache. The string is
+    // valid until the next call.
+    const std::string& CachedNewick();
+
     static std::shared_ptr<Tree> Random(std::vector<std::string> taxonNames);
 
-    static std::shared_ptr<Tree> FromNewick(const std::string& newick);
+    static std::shared_ptr<Tree> FromNewick(std::string_view newick);
 
     static std::shared_ptr<Tree> FromNewick(
-        const std::string& newick, std::shared_ptr<std::vector<std::string>> taxonNames);
+        std::string_view newick, std::shared_ptr<std::vector<std::string>> taxonNames);
 
+    // Nodes are allocated from arena when it is not null.
+    static std::shared_ptr<Tree> FromNewick(
+        std::string_view newick, std::shared_ptr<std::vector<std::string>> taxonNames,
+        const std::shared_ptr<NodeArena>& arena);
+
+    static std::shared_ptr<Tree> FromNewick(
+        std::string_view newick, std::shared_ptr<std::vector<std::string>> taxonNames,
+        const NewickParseOptions& options,
+        const std::shared_ptr<NodeArena>& arena = nullptr);
+
+    // Leaf ids are looked up in taxonSet while parsing. taxonSet can be shared by
+    // every tree of a file. If taxonSet is null the taxa are numbered in the order
+    // they appear in newick.
+    static std::shared_ptr<Tree> FromNewick(
+        std::string_view newick, std::shared_ptr<const TaxonSet> taxonSet,
+        const NewickParseOptions& options,
+        const std::shared_ptr<NodeArena>& arena = nullptr);
+
+    // Replace this tree with the tree of newick. The nodes of this tree are reused,
+    // leaves by taxon, and only the nodes missing from it are allocated, from arena
+    // when it is not null. Meant to read the successive trees of a file sharing
+    // taxonSet without allocating. If newick is malformed the exception leaves an
+    // empty tree, without root or nodes, that can be rebuilt.
+    void Rebuild(std::string_view newick, std::shared_ptr<const TaxonSet> taxonSet,
+                 const NewickParseOptions& options,
+                 const std::shared_ptr<NodeArena>& arena = nullptr);
+
+    // Store node and branch annotations of every node in typed columns indexed by
+    // node id. Node::Annotation and Node::SetAnnotation keep working.
+    void EnableAnnotationTables();
+
+    // Move the annotations back to the nodes.
+    void DisableAnnotationTables();
+
+    std::shared_ptr<AnnotationTable> NodeAnnotations() const { return annotationTable_; }
+
+    std::shared_ptr<AnnotationTable> BranchAnnotations() const {
+        return branchAnnotationTable_;
+    }
+
+    // Once computed, descendant bitsets and split hashes are kept up to date by
+    // MakeUnRooted, MakeBinary and ReRootAbove.
     void ComputeDescendantBitset();
 
+    void ComputeSplitHashes();
+
+    bool HasSplitHashes() const { return hasSplitHashes_; }
+
    private:
     Node::NodePtr root_;
     size_t leafCount_ = 0;
     size_t internalCount_ = 0;
     size_t nodeCount_ = 0;
-    std::shared_ptr<std::vector<std::string>> taxonNames_;
+    std::shared_ptr<const TaxonSet> taxonSet_;
     std::vector<Node::NodePtr> nodes_;
+    std::vector<size_t> postorder_;
+    std::vector<size_t> preorder_;
     std::map<std::string, std::any> annotations_;
+    std::shared_ptr<AnnotationTable> annotationTable_;
+    std::shared_ptr<AnnotationTable> branchAnnotationTable_;
     std::string comment_;  // raw comment extraced from newick file
+    bool hasBitsets_ = false;
+    bool hasSplitHashes_ = false;
+    std::shared_ptr<NewickCache> newickCache_;
+
+    // Give node the next internal id.
+    void AddNode(const Node::NodePtr& node);
+
+    // replacement takes the id of node.
+    void ReplaceNode(const Node::NodePtr& node, const Node::NodePtr& replacement);
+
+    // Free the id of an internal node that was removed from the tree.
+    void RemoveNode(const Node::NodePtr& node);
+
+    // Recompute the bitset and split hash of node from its children if they are used.
+    void UpdateClade(Node& node);
+
+    // The names of the leaves are appended to taxonNames when taxonSet is null.
+    static std::shared_ptr<Tree> Parse(
+        std::string_view newick, std::shared_ptr<const TaxonSet> taxonSet,
+        std::shared_ptr<std::vector<std::string>> taxonNames,
+        const NewickParseOptions& options, const std::shared_ptr<NodeArena>& arena);
 };
 }  // namespace cladokit
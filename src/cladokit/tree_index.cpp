@@ -0,0 +1,223 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/tree_index.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cladokit/newick.hpp"
+#include "cladokit/nexus.hpp"
+#include "cladokit/utils.hpp"
+
+using cladokit::NewickFile;
+using cladokit::NexusFile;
+using cladokit::StatementScanner;
+using cladokit::Tree;
+using cladokit::TreeIndex;
+using std::string;
+
+namespace {
+constexpr char kMagic[8] = {'C', 'K', 'I', 'D', 'X', '0', '0', '1'};
+// number of bytes at the beginning of the file used to detect modifications
+constexpr size_t kHeadSize = 1 << 16;
+
+// Size, modification time and hash of the beginning of a file.
+struct FileSignature {
+    uint64_t size = 0;
+    int64_t modificationTime = 0;
+    uint64_t headHash = 0;
+
+    bool operator==(const FileSignature &other) const {
+        return size == other.size && modificationTime == other.modificationTime &&
+               headHash == other.headHash;
+    }
+};
+
+FileSignature Signature(const std::filesystem::path &path) {
+    FileSignature signature;
+    signature.size = std::filesystem::file_size(path);
+    signature.modificationTime = static_cast<int64_t>(
+        std::filesystem::last_write_time(path).time_since_epoch().count());
+
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> head(kHeadSize);
+    in.read(head.data(), head.size());
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::streamsize i = 0; i < in.gcount(); i++) {
+        hash ^= static_cast<unsigned char>(head[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    signature.headHash = hash;
+    return signature;
+}
+
+template <typename T>
+void Write(std::ostream &out, T value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+T Read(std::istream &in) {
+    T value{};
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+    if (!in) {
+        throw std::runtime_error("Truncated index");
+    }
+    return value;
+}
+}  // namespace
+
+std::shared_ptr<TreeIndex> TreeIndex::Build(std::istream &in, Format format) {
+    auto index = std::make_shared<TreeIndex>();
+    index->format_ = format;
+
+    in.clear();
+    in.seekg(0, std::ios::beg);
+    string line;
+    uint64_t offset = 0;
+    bool inTrees = format == Format::kNewick;
+    while (std::getline(in, line, '\n')) {
+        uint64_t lineOffset = offset;
+        offset += line.size() + (in.eof() ? 0 : 1);
+        if (format == Format::kNewick) {
+            if (!line.empty() && line.front() == '(') {
+                index->entries_.push_back({lineOffset, line.size()});
+            }
+        } else if (!inTrees) {
+            inTrees = StartsWithCaseInsensitive(line, "begin trees");
+        } else if (StartsWithCaseInsensitive(line, "end;")) {
+            break;
+        } else if (StartsWithCaseInsensitiveLeftTrim(line, "translate")) {
+            index->translateOffset_ = lineOffset;
+        } else if (StartsWithCaseInsensitive(line, "tree")) {
+            // the entry covers every line of the statement
+            uint64_t length = line.size();
+            StatementScanner scanner;
+            bool terminated = scanner.Terminates(line);
+            while (!terminated && std::getline(in, line, '\n')) {
+                length = offset + line.size() - lineOffset;
+                offset += line.size() + (in.eof() ? 0 : 1);
+                terminated = scanner.Terminates(line);
+            }
+            index->entries_.push_back({lineOffset, length});
+        }
+    }
+
+    // the taxon names are the ones the file would give to the first tree
+    if (!index->entries_.empty()) {
+        in.clear();
+        in.seekg(0, std::ios::beg);
+        std::shared_ptr<Tree> tree;
+        if (format == Format::kNewick) {
+            tree = NewickFile(in).Next();
+        } else {
+            tree = NexusFile(in).Next();
+        }
+        if (tree) {
+            index->taxonNames_ = *tree->TaxonNames();
+        }
+    }
+    in.clear();
+    in.seekg(0, std::ios::beg);
+    return index;
+}
+
+std::shared_ptr<TreeIndex> TreeIndex::Open(const std::filesystem::path &path,
+                                           Format format, bool persist) {
+    auto sidecar = SidecarPath(path);
+    auto index = Load(sidecar, path);
+    if (index && index->format_ == format) {
+        return index;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open file: " + path.string());
+    }
+    index = Build(in, format);
+    if (persist) {
+        index->Save(sidecar, path);
+    }
+    return index;
+}
+
+std::shared_ptr<TreeIndex> TreeIndex::Load(const std::filesystem::path &indexPath,
+                                           const std::filesystem::path &source) {
+    std::ifstream in(indexPath, std::ios::binary);
+    if (!in) return nullptr;
+
+    try {
+        char magic[sizeof(kMagic)];
+        in.read(magic, sizeof(magic));
+        if (!in || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+            return nullptr;
+        }
+        FileSignature signature;
+        signature.size = Read<uint64_t>(in);
+        signature.modificationTime = Read<int64_t>(in);
+        signature.headHash = Read<uint64_t>(in);
+        if (!(signature == Signature(source))) {
+            return nullptr;
+        }
+
+        auto index = std::make_shared<TreeIndex>();
+        index->format_ = static_cast<Format>(Read<uint8_t>(in));
+        index->translateOffset_ = Read<uint64_t>(in);
+        // counts larger than the source are corrupted
+        uint64_t count = Read<uint64_t>(in);
+        if (count > signature.size) return nullptr;
+        index->entries_.resize(count);
+        for (auto &entry : index->entries_) {
+            entry.offset = Read<uint64_t>(in);
+            entry.length = Read<uint64_t>(in);
+        }
+        count = Read<uint64_t>(in);
+        if (count > signature.size) return nullptr;
+        index->taxonNames_.resize(count);
+        for (auto &name : index->taxonNames_) {
+            uint64_t length = Read<uint64_t>(in);
+            if (length > signature.size) return nullptr;
+            name.resize(length);
+            in.read(name.data(), name.size());
+        }
+        if (!in) return nullptr;
+        return index;
+    } catch (const std::exception &) {
+        // truncated index or missing source
+        return nullptr;
+    }
+}
+
+void TreeIndex::Save(const std::filesystem::path &indexPath,
+                     const std::filesystem::path &source) const {
+    std::ofstream out(indexPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot write index: " + indexPath.string());
+    }
+    FileSignature signature = Signature(source);
+    out.write(kMagic, sizeof(kMagic));
+    Write<uint64_t>(out, signature.size);
+    Write<int64_t>(out, signature.modificationTime);
+    Write<uint64_t>(out, signature.headHash);
+    Write<uint8_t>(out, static_cast<uint8_t>(format_));
+    Write<uint64_t>(out, translateOffset_);
+    Write<uint64_t>(out, entries_.size());
+    for (const auto &entry : entries_) {
+        Write<uint64_t>(out, entry.offset);
+        Write<uint64_t>(out, entry.length);
+    }
+    Write<uint64_t>(out, taxonNames_.size());
+    for (const auto &name : taxonNames_) {
+        Write<uint64_t>(out, name.size());
+        out.write(name.data(), name.size());
+    }
+    if (!out) {
+        throw std::runtime_error("Cannot write index: " + indexPath.string());
+    }
+}
@@ -0,0 +1,72 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cladokit {
+
+// Byte offset and length of every tree statement of a Newick or Nexus file, the
+// location of the translate block and the taxon names of the file, i.e. the names of
+// the first tree in the order a TreeFile numbers them.
+// An index can be saved next to the file it describes and is only loaded back if the
+// size, the modification time and the beginning of the file did not change.
+class TreeIndex {
+   public:
+    enum class Format : uint8_t { kNewick, kNexus };
+
+    struct Entry {
+        uint64_t offset;
+        uint64_t length;  // of every line of the statement, without the last line feed
+    };
+
+    static constexpr uint64_t kNoOffset = std::numeric_limits<uint64_t>::max();
+
+    // Scan in from its beginning. The stream is rewound afterwards.
+    static std::shared_ptr<TreeIndex> Build(std::istream &in, Format format);
+
+    // Load the index of path from its sidecar file if it is up to date. Otherwise
+    // build it and, if persist is true, save it to the sidecar file.
+    static std::shared_ptr<TreeIndex> Open(const std::filesystem::path &path,
+                                           Format format, bool persist = true);
+
+    // Returns nullptr if indexPath cannot be read or does not match source.
+    static std::shared_ptr<TreeIndex> Load(const std::filesystem::path &indexPath,
+                                           const std::filesystem::path &source);
+
+    // Throws std::runtime_error if indexPath cannot be written.
+    void Save(const std::filesystem::path &indexPath,
+              const std::filesystem::path &source) const;
+
+    static std::filesystem::path SidecarPath(const std::filesystem::path &path) {
+        return std::filesystem::path(path.string() + ".ckidx");
+    }
+
+    Format GetFormat() const { return format_; }
+
+    size_t Count() const { return entries_.size(); }
+
+    const Entry &At(size_t index) const { return entries_.at(index); }
+
+    const std::vector<Entry> &Entries() const { return entries_; }
+
+    // Offset of the line starting the translate block or kNoOffset.
+    uint64_t TranslateOffset() const { return translateOffset_; }
+
+    const std::vector<std::string> &TaxonNames() const { return taxonNames_; }
+
+   private:
+    Format format_ = Format::kNewick;
+    std::vector<Entry> entries_;
+    uint64_t translateOffset_ = kNoOffset;
+    std::vector<std::string> taxonNames_;
+};
+}  // namespace cladokit
@@ -0,0 +1,339 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/tree_log_writer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cladokit/nexus_writer.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define CLADOKIT_HAVE_FSYNC 1
+#endif
+
+using cladokit::Node;
+using cladokit::TreeLogWriter;
+using std::string;
+using std::vector;
+
+TreeLogWriter::TreeLogWriter(const std::filesystem::path &path,
+                             std::shared_ptr<const TaxonSet> taxa, TreeLogOptions options)
+    : taxa_(std::move(taxa)),
+      options_(std::move(options)),
+      slots_(std::max<size_t>(1, options_.capacity)) {
+    if (!taxa_) {
+        throw std::invalid_argument("TreeLogWriter requires a taxon set");
+    }
+    options_.newick.includeRawComment = false;
+    writer_ = NewickWriter(options_.newick);
+    if (options_.format == TreeLogFormat::kNexus) {
+        auto tokens = std::make_shared<vector<string>>(taxa_->Size());
+        for (size_t i = 0; i < tokens->size(); i++) {
+            (*tokens)[i] = std::to_string(i + 1);
+        }
+        writer_.SetLeafLabels(tokens);
+    }
+
+#ifdef CLADOKIT_HAVE_FSYNC
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open file: " + path.string());
+    }
+#else
+    stream_.open(path, std::ios::binary | std::ios::trunc);
+    if (!stream_) {
+        throw std::runtime_error("Cannot open file: " + path.string());
+    }
+#endif
+    if (options_.format == TreeLogFormat::kNexus) {
+        WriteFile(NexusWriter::Header(*taxa_));
+    }
+    SyncFile();
+    lastSync_ = std::chrono::steady_clock::now();
+    thread_ = std::thread(&TreeLogWriter::Run, this);
+}
+
+TreeLogWriter::~TreeLogWriter() {
+    try {
+        Close();
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+}
+
+void TreeLogWriter::Log(const Tree &tree, int64_t state) {
+    if (closed_) {
+        throw std::logic_error("Cannot log trees after TreeLogWriter::Close");
+    }
+    if (tree.Taxa() != taxa_ && tree.TaxonNames() != taxa_->Names()) {
+        throw std::invalid_argument("The tree does not use the taxon set of the logger");
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        RethrowError();
+        condition_.wait(lock, [this] { return queued_ < slots_.size(); });
+    }
+    // the slot at head_ is not read by the background thread until it is queued
+    Snapshot &snapshot = slots_[head_];
+    Capture(tree, snapshot);
+    snapshot.state = state;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        head_ = (head_ + 1) % slots_.size();
+        queued_++;
+        logged_++;
+    }
+    condition_.notify_all();
+}
+
+void TreeLogWriter::Flush() {
+    if (closed_) return;
+    std::unique_lock<std::mutex> lock(mutex_);
+    syncRequested_ = true;
+    condition_.notify_all();
+    condition_.wait(lock, [this] { return written_ == logged_ && !syncRequested_; });
+    RethrowError();
+}
+
+void TreeLogWriter::Close() {
+    if (closed_) return;
+    closed_ = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+
+    std::exception_ptr error = std::exchange(error_, nullptr);
+    if (!error) {
+        try {
+            if (options_.format == TreeLogFormat::kNexus) {
+                WriteFile("End;\n");
+            }
+            SyncFile();
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+#ifdef CLADOKIT_HAVE_FSYNC
+    close(fd_);
+    fd_ = -1;
+#else
+    stream_.close();
+#endif
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void TreeLogWriter::Run() {
+    string buffer;
+    bool unsynced = false;  // trees were written since the last sync
+    auto ready = [this] { return queued_ > 0 || syncRequested_ || stop_; };
+    auto keepError = [this](std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_) error_ = std::move(error);
+    };
+    while (true) {
+        size_t first;
+        size_t count;
+        bool sync;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // written trees are synced once the interval elapsed even if no other tree
+            // is logged
+            if (unsynced) {
+                condition_.wait_until(lock, lastSync_ + options_.syncInterval, ready);
+            } else {
+                condition_.wait(lock, ready);
+            }
+            if (queued_ == 0 && stop_) return;
+            first = tail_;
+            count = queued_;
+            sync = syncRequested_;
+        }
+
+        // the slots are released as soon as they are formatted
+        buffer.clear();
+        for (size_t i = 0; i < count; i++) {
+            size_t length = buffer.size();
+            try {
+                Format(slots_[(first + i) % slots_.size()], buffer);
+            } catch (...) {
+                // only complete lines are written
+                buffer.resize(length);
+                keepError(std::current_exception());
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tail_ = (first + count) % slots_.size();
+            queued_ -= count;
+        }
+        condition_.notify_all();
+
+        try {
+            if (!buffer.empty()) {
+                WriteFile(buffer);
+                unsynced = true;
+            }
+            auto now = std::chrono::steady_clock::now();
+            if (sync || (unsynced && now - lastSync_ >= options_.syncInterval)) {
+                SyncFile();
+                lastSync_ = now;
+                unsynced = false;
+            }
+        } catch (...) {
+            keepError(std::current_exception());
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            written_ += count;
+            if (sync) syncRequested_ = false;
+        }
+        condition_.notify_all();
+    }
+}
+
+void TreeLogWriter::Capture(const Tree &tree, Snapshot &snapshot) const {
+    const auto &keys = options_.newick.annotationKeys;
+    const auto &branchKeys = options_.newick.branchAnnotationKeys;
+    size_t nodeCount = tree.NodeCount();
+    snapshot.leafCount = tree.LeafNodeCount();
+    snapshot.rooted = tree.IsRooted();
+    snapshot.ids.resize(nodeCount);
+    snapshot.parents.resize(nodeCount);
+    snapshot.distances.resize(nodeCount);
+    snapshot.annotations.resize(nodeCount * keys.size());
+    snapshot.branchAnnotations.resize(nodeCount * branchKeys.size());
+    if (options_.newick.includeInternalNodeName) {
+        snapshot.names.resize(nodeCount);
+    }
+
+    size_t position = 0;
+    snapshot.parents[tree.Root()->Id()] = kNoParent;
+    for (const Node &node : tree.PreOrder()) {
+        size_t id = node.Id();
+        snapshot.ids[position] = id;
+        snapshot.distances[position] = node.Distance();
+        for (const auto &child : node.Children()) {
+            snapshot.parents[child->Id()] = id;
+        }
+        if (options_.newick.includeInternalNodeName && !node.IsLeaf()) {
+            snapshot.names[position] = node.Name();
+        }
+        for (size_t k = 0; k < keys.size(); k++) {
+            auto &value = snapshot.annotations[position * keys.size() + k];
+            if (node.ContainsAnnotation(keys[k])) {
+                value = node.Annotation(keys[k]);
+            } else {
+                value.reset();
+            }
+        }
+        for (size_t k = 0; k < branchKeys.size(); k++) {
+            auto &value = snapshot.branchAnnotations[position * branchKeys.size() + k];
+            if (node.ContainsBranchAnnotation(branchKeys[k])) {
+                value = node.BranchAnnotation(branchKeys[k]);
+            } else {
+                value.reset();
+            }
+        }
+        position++;
+    }
+}
+
+void TreeLogWriter::Format(const Snapshot &snapshot, string &out) {
+    const auto &keys = options_.newick.annotationKeys;
+    const auto &branchKeys = options_.newick.branchAnnotationKeys;
+    size_t nodeCount = snapshot.ids.size();
+    while (nodes_.size() < nodeCount) {
+        nodes_.push_back(std::make_shared<Node>());
+    }
+
+    // rebuild the tree with the nodes of the previous trees, children are added in
+    // preorder so they keep their order
+    for (size_t position = 0; position < nodeCount; position++) {
+        size_t id = snapshot.ids[position];
+        Node &node = *nodes_[id];
+        node.Reset();
+        node.SetId(id);
+        node.SetDistance(snapshot.distances[position]);
+        if (id < snapshot.leafCount) {
+            // leaves of the Nexus format are written as tokens
+            if (options_.format == TreeLogFormat::kNewick) node.SetName(taxa_->Name(id));
+        } else if (options_.newick.includeInternalNodeName) {
+            node.SetName(snapshot.names[position]);
+        }
+        for (size_t k = 0; k < keys.size(); k++) {
+            const auto &value = snapshot.annotations[position * keys.size() + k];
+            if (value.has_value()) node.SetAnnotation(keys[k], value);
+        }
+        for (size_t k = 0; k < branchKeys.size(); k++) {
+            const auto &value =
+                snapshot.branchAnnotations[position * branchKeys.size() + k];
+            if (value.has_value()) node.SetBranchAnnotation(branchKeys[k], value);
+        }
+        if (snapshot.parents[id] != kNoParent) {
+            nodes_[snapshot.parents[id]]->AddChild(nodes_[id]);
+        }
+    }
+
+    const Node &root = *nodes_[snapshot.ids[0]];
+    if (options_.format == TreeLogFormat::kNexus) {
+        out += "tree STATE_";
+        out += std::to_string(snapshot.state);
+        out += snapshot.rooted ? " = [&R] " : " = [&U] ";
+    }
+    writer_.Append(root, out);
+    out += ";\n";
+}
+
+void TreeLogWriter::WriteFile(const string &text) {
+#ifdef CLADOKIT_HAVE_FSYNC
+    size_t offset = 0;
+    while (offset < text.size()) {
+        ssize_t count = write(fd_, text.data() + offset, text.size() - offset);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(string("Cannot write tree log: ") +
+                                     std::strerror(errno));
+        }
+        offset += static_cast<size_t>(count);
+    }
+#else
+    stream_.write(text.data(), static_cast<std::streamsize>(text.size()));
+    if (!stream_) {
+        throw std::runtime_error("Cannot write tree log");
+    }
+#endif
+}
+
+void TreeLogWriter::SyncFile() {
+#ifdef CLADOKIT_HAVE_FSYNC
+    if (fsync(fd_) != 0 && errno != EINVAL) {
+        throw std::runtime_error(string("Cannot sync tree log: ") + std::strerror(errno));
+    }
+#else
+    stream_.flush();
+#endif
+}
+
+void TreeLogWriter::RethrowError() {
+    if (error_) {
+        // the error is only reported once
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+}
@@ -0,0 +1,135 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <any>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cladokit/newick_options.hpp"
+#include "cladokit/newick_writer.hpp"
+#include "cladokit/node.hpp"
+#include "cladokit/taxon_set.hpp"
+#include "cladokit/tree.hpp"
+
+namespace cladokit {
+
+enum class TreeLogFormat { kNewick, kNexus };
+
+struct TreeLogOptions {
+    // kNewick writes one tree per line like NewickFile reads them, kNexus writes the
+    // header of NexusWriter and one tree statement named STATE_<state> per tree.
+    TreeLogFormat format = TreeLogFormat::kNexus;
+    // Annotation keys, branch annotation keys, precision... of the logged trees.
+    // Raw comments are not logged.
+    NewickExportOptions newick;
+    // Number of trees that can wait to be written before Log blocks.
+    size_t capacity = 16;
+    // The file is synced to disk at most this often, 0 means after every write.
+    std::chrono::milliseconds syncInterval = std::chrono::milliseconds(1000);
+};
+
+// Appends trees to a file without formatting or writing them on the calling thread.
+// Log copies the topology, branch lengths and selected annotations of a tree into
+// a preallocated slot of a ring buffer, and a background thread formats the trees
+// and appends them to the file, which is synced to disk at most syncInterval after a
+// tree is written, even if no other tree is logged in the meantime. Every line
+// written is a complete tree so a file left by a crash can be read by NewickFile or
+// NexusFile up to the last synced tree.
+// Log must be called from a single thread and the trees must use the taxon set of
+// the logger. Once the slots are allocated for the size of the trees, logging trees
+// with numeric annotations does not allocate memory.
+class TreeLogWriter {
+   public:
+    TreeLogWriter(const std::filesystem::path &path, std::shared_ptr<const TaxonSet> taxa,
+                  TreeLogOptions options = TreeLogOptions());
+
+    ~TreeLogWriter();
+
+    TreeLogWriter(const TreeLogWriter &) = delete;
+
+    TreeLogWriter &operator=(const TreeLogWriter &) = delete;
+
+    // Blocks only when Capacity() trees are waiting to be written. An error of the
+    // background thread is rethrown by the next call to Log, Flush or Close.
+    void Log(const Tree &tree, int64_t state);
+
+    // Block until every logged tree is written and synced to disk.
+    void Flush();
+
+    // Flush, end the Nexus trees block and close the file. Nothing can be logged
+    // afterwards.
+    void Close();
+
+    size_t Capacity() const { return slots_.size(); }
+
+    size_t LoggedCount() const { return logged_; }
+
+   private:
+    static constexpr size_t kNoParent = std::numeric_limits<size_t>::max();
+
+    // Copy of a tree, nodes in preorder.
+    struct Snapshot {
+        int64_t state = 0;
+        size_t leafCount = 0;  // leaves have ids [0, leafCount)
+        bool rooted = false;
+        std::vector<size_t> ids;
+        std::vector<size_t> parents;  // indexed by id
+        std::vector<double> distances;
+        std::vector<std::string> names;  // internal nodes only, if they are exported
+        // annotations of the node at position i of ids for key k at i * keyCount + k
+        std::vector<std::any> annotations;
+        std::vector<std::any> branchAnnotations;
+    };
+
+    std::shared_ptr<const TaxonSet> taxa_;
+    TreeLogOptions options_;
+    std::vector<Snapshot> slots_;
+    size_t head_ = 0;    // next slot filled by Log
+    size_t tail_ = 0;    // next slot formatted
+    size_t queued_ = 0;  // slots waiting to be formatted
+    size_t logged_ = 0;
+    size_t written_ = 0;
+    bool syncRequested_ = false;
+    bool stop_ = false;
+    bool closed_ = false;
+    std::exception_ptr error_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::thread thread_;
+
+    // used by the background thread only
+    NewickWriter writer_;
+    std::vector<Node::NodePtr> nodes_;
+    std::chrono::steady_clock::time_point lastSync_;
+
+    int fd_ = -1;
+    std::ofstream stream_;  // used when file descriptors are not available
+
+    // Body of the background thread.
+    void Run();
+
+    void Capture(const Tree &tree, Snapshot &snapshot) const;
+
+    // Append the line of the tree in snapshot to out.
+    void Format(const Snapshot &snapshot, std::string &out);
+
+    void WriteFile(const std::string &text);
+
+    void SyncFile();
+
+    void RethrowError();
+};
+}  // namespace cladokit
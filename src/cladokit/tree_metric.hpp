@@ -4,6 +4,7 @@
 #pragma once
 
 #include "cladokit/bipartition.hpp"
+#include "cladokit/compact_tree.hpp"
 #include "cladokit/tree.hpp"
 
 namespace cladokit {
@@ -25,7 +26,23 @@ class RobinsonFouldsMetric : public TreeMetric {
         return Compute(bip1, bip2);
     }
 
+    double Compute(const CompactTree& tree1, const CompactTree& tree2) {
+        auto bip1 = GetBiPartitionSet(tree1);
+        auto bip2 = GetBiPartitionSet(tree2);
+        return Compute(bip1, bip2);
+    }
+
     double Compute(const BiPartitionSet& bip1, const BiPartitionSet& bip2) {
+        return ComputeFromSets(bip1, bip2);
+    }
+
+    double Compute(const SplitHashSet& splits1, const SplitHashSet& splits2) {
+        return ComputeFromSets(splits1, splits2);
+    }
+
+   private:
+    template <typename Set>
+    double ComputeFromSets(const Set& bip1, const Set& bip2) {
         size_t shared = 0;
         for (const auto& b : bip1) {
             if (bip2.find(b) != bip2.end()) {
@@ -0,0 +1,71 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/treeio.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "cladokit/parallel.hpp"
+
+using cladokit::NodeArena;
+using cladokit::Tree;
+using cladokit::TreeFile;
+using std::vector;
+
+std::istream &TreeFile::NullStream() {
+    // without a buffer every read fails
+    static std::istream stream(nullptr);
+    return stream;
+}
+
+bool TreeFile::NextInto(Tree &tree) {
+    auto next = Next();
+    if (!next) return false;
+    tree = std::move(*next);
+    return true;
+}
+
+void TreeFile::Seek(size_t k) {
+    if (!index_) {
+        throw std::runtime_error("Seek requires an index");
+    }
+    const auto &entry = index_->At(k);
+    // trees get the same ids whichever is read first
+    if (taxonNames_->empty()) {
+        *taxonNames_ = index_->TaxonNames();
+    }
+    SeekTo(entry);
+}
+
+vector<std::shared_ptr<Tree>> TreeFile::ParseStatements(
+    const vector<std::string_view> &statements, const FirstTreeParser &parseFirst,
+    const TreeParser &parse) {
+    vector<std::shared_ptr<Tree>> trees(statements.size());
+    if (statements.empty()) return trees;
+
+    // the taxa are known once the first tree is parsed
+    trees[0] = parseFirst(statements[0]);
+    auto taxa = Taxa();
+
+    size_t threadCount = threadCount_ == 0 ? DefaultThreadCount() : threadCount_;
+    threadCount = std::max<size_t>(1, std::min(threadCount, statements.size() - 1));
+
+    // a NodeArena is not thread safe so every other worker gets its own
+    vector<std::shared_ptr<NodeArena>> arenas(threadCount, arena_);
+    if (arena_) {
+        for (size_t worker = 1; worker < threadCount; worker++) {
+            arenas[worker] = std::make_shared<NodeArena>(arena_->SlabSize());
+        }
+    }
+
+    ParallelFor(statements.size() - 1, threadCount, [&](size_t index, size_t worker) {
+        trees[index + 1] = parse(statements[index + 1], taxa, arenas[worker]);
+    });
+    return trees;
+}
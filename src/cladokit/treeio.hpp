@@ -6,17 +6,25 @@
 #include <cstddef>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "cladokit/newick_options.hpp"
+#include "cladokit/node_arena.hpp"
+#include "cladokit/taxon_set.hpp"
 #include "cladokit/tree.hpp"
+#include "cladokit/tree_index.hpp"
 
 namespace cladokit {
 class TreeFile {
    public:
-    explicit TreeFile(std::istream &in) : in_(in) {}
+    explicit TreeFile(std::istream &in)
+        : in_(in), taxonNames_(std::make_shared<std::vector<std::string>>()) {}
 
     TreeFile(std::istream &in, std::shared_ptr<std::vector<std::string>> taxonNames)
         : in_(in), taxonNames_(taxonNames) {}
@@ -33,9 +41,89 @@ class TreeFile {
 
     virtual void SkipNext() = 0;
 
+    // Read the next tree into tree, e.g. a tree returned by Next, instead of
+    // allocating a new one. Files that support it rebuild the tree in place,
+    // reusing its nodes, once the taxa of the file are known. Returns false if there
+    // is no tree left.
+    virtual bool NextInto(Tree &tree);
+
+    // Allocate the nodes of the trees read from this file from arena. When Parse uses
+    // several threads, the trees parsed by the other threads are allocated from
+    // arenas of the same slab size created by Parse, which are not counted by arena.
+    virtual void SetNodeArena(std::shared_ptr<NodeArena> arena) { arena_ = arena; }
+
+    std::shared_ptr<NodeArena> Arena() const { return arena_; }
+
+    // Options used to parse every tree read from this file, for example to only
+    // decode some annotation keys and drop the raw comments.
+    virtual void SetParseOptions(const NewickParseOptions &options) {
+        parseOptions_ = options;
+    }
+
+    const NewickParseOptions &ParseOptions() const { return parseOptions_; }
+
+    // Number of threads used by Parse, 0 means one per hardware thread. Trees are
+    // returned in file order whatever the number of threads.
+    virtual void SetThreadCount(size_t threadCount) { threadCount_ = threadCount; }
+
+    size_t ThreadCount() const { return threadCount_; }
+
+    // With an index Count is constant time and trees can be accessed by position.
+    void SetIndex(std::shared_ptr<const TreeIndex> index) { index_ = index; }
+
+    std::shared_ptr<const TreeIndex> Index() const { return index_; }
+
+    // Move to tree k so that it is returned by the next call to Next. Requires an
+    // index unless the file has its own offsets, throws std::runtime_error without
+    // one and std::out_of_range if k is not smaller than Count().
+    virtual void Seek(size_t k);
+
+    std::shared_ptr<Tree> At(size_t k) {
+        Seek(k);
+        return Next();
+    }
+
    protected:
+    // For files that do not read a stream themselves, in_ is an empty stream.
+    TreeFile() : TreeFile(NullStream()) {}
+
+    static std::istream &NullStream();
+
+    // Move to the tree statement described by entry.
+    virtual void SeekTo(const TreeIndex::Entry & /*entry*/) {
+        throw std::runtime_error("Seek is not supported by this file");
+    }
+
+    using FirstTreeParser = std::function<std::shared_ptr<Tree>(std::string_view)>;
+
+    using TreeParser = std::function<std::shared_ptr<Tree>(
+        std::string_view, const std::shared_ptr<const TaxonSet> &,
+        const std::shared_ptr<NodeArena> &)>;
+
+    // Parse the tree statements in order using threadCount_ threads. The first one
+    // is parsed by parseFirst, which can set the taxon names of the file. The others
+    // are parsed concurrently by parse, which must not modify the file.
+    std::vector<std::shared_ptr<Tree>> ParseStatements(
+        const std::vector<std::string_view> &statements,
+        const FirstTreeParser &parseFirst, const TreeParser &parse);
+
+    // Taxon set shared by every tree of the file, built once taxonNames_ is known.
+    // taxonNames_ is only ever filled while it is empty, so a taxon set of another
+    // size is stale.
+    std::shared_ptr<const TaxonSet> Taxa() {
+        if (!taxonSet_ || taxonSet_->Size() != taxonNames_->size()) {
+            taxonSet_ = std::make_shared<TaxonSet>(*taxonNames_);
+        }
+        return taxonSet_;
+    }
+
     std::istream &in_;
     std::shared_ptr<std::vector<std::string>> taxonNames_;
+    std::shared_ptr<const TaxonSet> taxonSet_;
     size_t count_ = 0;
+    std::shared_ptr<NodeArena> arena_;
+    NewickParseOptions parseOptions_;
+    size_t threadCount_ = 1;
+    std::shared_ptr<const TreeIndex> index_;
 };
 }  // namespace cladokit
@@ -37,25 +37,45 @@ std::vector<std::string> SplitTopLevel(const std::string &str) {
 void ParseRawComment(const std::string &comment,
                      std::map<std::string, std::any> &annotations,
                      const std::unordered_map<std::string, Converter> &converters) {
-    size_t start = comment.find("&") + 1;
-    size_t end = comment.find_last_of("]");
-    std::string content = comment.substr(start, end - start);
+    ParseRawComment(std::string_view(comment), annotations, converters, {});
+}
 
-    auto tokens = SplitTopLevel(content);
+void ParseRawComment(std::string_view comment,
+                     std::map<std::string, std::any> &annotations,
+                     const std::unordered_map<std::string, Converter> &converters,
+                     const std::vector<std::string> &keys) {
+    size_t start = comment.find('&') + 1;
+    size_t end = comment.find_last_of(']');
+    std::string_view content = comment.substr(start, end - start);
 
-    for (const auto &token : tokens) {
-        size_t eq_pos = token.find('=');
-        if (eq_pos != std::string::npos) {
-            std::string key = token.substr(0, eq_pos);
-            std::string value = token.substr(eq_pos + 1);
+    // split on top level commas, like SplitTopLevel
+    int braceDepth = 0;
+    size_t tokenStart = 0;
+    for (size_t i = 0; i <= content.size(); i++) {
+        if (i < content.size()) {
+            char ch = content[i];
+            if (ch == '{') braceDepth++;
+            if (ch == '}') braceDepth--;
+            if (ch != ',' || braceDepth != 0) continue;
+        }
+        std::string_view token = content.substr(tokenStart, i - tokenStart);
+        tokenStart = i + 1;
 
-            auto it = converters.find(key);
-            if (it != converters.end()) {
-                annotations[key] = it->second(value);
-            } else {
-                // Store as string if key not in converters
-                annotations[key] = value;
-            }
+        size_t eqPos = token.find('=');
+        if (eqPos == std::string_view::npos) continue;
+        std::string_view keyView = token.substr(0, eqPos);
+        if (!keys.empty() && std::find(keys.begin(), keys.end(), keyView) == keys.end()) {
+            continue;
+        }
+
+        std::string key(keyView);
+        std::string value(token.substr(eqPos + 1));
+        auto it = converters.find(key);
+        if (it != converters.end()) {
+            annotations[key] = it->second(value);
+        } else {
+            // Store as string if key not in converters
+            annotations[key] = std::move(value);
         }
     }
 }
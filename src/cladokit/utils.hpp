@@ -10,6 +10,7 @@
 #include <locale>
 #include <map>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -31,16 +32,16 @@ inline void RightTrim(std::string& str) {
               str.end());
 }
 
-inline bool StartsWithCaseInsensitive(const std::string& target,
-                                      const std::string& input_prefix) {
+inline bool StartsWithCaseInsensitive(std::string_view target,
+                                      std::string_view input_prefix) {
     if (target.size() < input_prefix.size()) return false;
     return std::equal(
         input_prefix.begin(), input_prefix.end(), target.begin(),
         [](char c1, char c2) { return std::tolower(c1) == std::tolower(c2); });
 }
 
-inline bool StartsWithCaseInsensitiveLeftTrim(const std::string& target,
-                                              const std::string& inputPrefix) {
+inline bool StartsWithCaseInsensitiveLeftTrim(std::string_view target,
+                                              std::string_view inputPrefix) {
     auto targetBegin = std::find_if_not(target.begin(), target.end(),
                                         [](char c) { return c == ' ' || c == '\t'; });
     size_t targetLen = static_cast<size_t>(std::distance(targetBegin, target.end()));
@@ -51,11 +52,17 @@ inline bool StartsWithCaseInsensitiveLeftTrim(const std::string& target,
 }
 
 std::vector<std::string> SplitTopLevel(const std::string& str);
-using Converter = std::function<std::any(const std::string&)>;
 void ParseRawComment(const std::string& comment,
                      std::map<std::string, std::any>& annotations,
                      const std::unordered_map<std::string, Converter>& converters);
 
+// Only decode the annotations whose key is in keys, or all of them if keys is empty.
+// Annotations that are not requested are skipped without being copied.
+void ParseRawComment(std::string_view comment,
+                     std::map<std::string, std::any>& annotations,
+                     const std::unordered_map<std::string, Converter>& converters,
+                     const std::vector<std::string>& keys);
+
 std::string BuildCommentForNewick(const std::string& rawComment,
                                   const std::map<std::string, std::any>& annotations,
                                   const NewickExportOptions& options,
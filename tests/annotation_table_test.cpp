@@ -0,0 +1,93 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/annotation_table.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "cladokit/tree.hpp"
+
+using cladokit::AnnotationTable;
+using cladokit::NewickExportOptions;
+using cladokit::Tree;
+
+TEST(AnnotationTableTest, TypedColumns) {
+    AnnotationTable table(3);
+    auto rate = table.Intern("rate");
+    table.Set(rate, 0, 0.5);
+    table.Set(rate, 2, 1.5);
+    table.Set("label", 1, std::string("x"));
+    table.Set("count", 1, 4);
+
+    EXPECT_EQ(table.Type(rate), AnnotationTable::ColumnType::kDouble);
+    EXPECT_EQ(table.DoubleColumn(rate), std::vector<double>({0.5, 0.0, 1.5}));
+    EXPECT_EQ(table.Present(rate), std::vector<bool>({true, false, true}));
+    EXPECT_EQ(table.Get<std::string>("label", 1), "x");
+    EXPECT_EQ(table.Get<int>("count", 1), 4);
+    EXPECT_EQ(table.Keys(1), std::vector<std::string>({"label", "count"}));
+
+    EXPECT_THROW(table.Get<double>("rate", 1), std::out_of_range);
+    EXPECT_THROW(table.Get<int>("rate", 0), std::runtime_error);
+    EXPECT_THROW(table.IntegerColumn(rate), std::runtime_error);
+
+    // mixing types falls back to std::any
+    table.Set(rate, 1, std::string("fast"));
+    EXPECT_EQ(table.Type(rate), AnnotationTable::ColumnType::kAny);
+    EXPECT_DOUBLE_EQ(table.Get<double>("rate", 0), 0.5);
+    EXPECT_EQ(table.Get<std::string>("rate", 1), "fast");
+}
+
+TEST(AnnotationTableTest, Remap) {
+    AnnotationTable table(3);
+    table.Set("rate", 0, 0.5);
+    table.Set("rate", 2, 1.5);
+    table.Remap({2, AnnotationTable::kNoRow, 0, 1});
+
+    EXPECT_EQ(table.RowCount(), 4);
+    EXPECT_DOUBLE_EQ(table.Get<double>("rate", 0), 1.5);
+    EXPECT_FALSE(table.Contains("rate", 1));
+    EXPECT_DOUBLE_EQ(table.Get<double>("rate", 2), 0.5);
+    EXPECT_FALSE(table.Contains("rate", 3));
+
+    table.MoveRow(2, 3);
+    EXPECT_FALSE(table.Contains("rate", 2));
+    EXPECT_DOUBLE_EQ(table.Get<double>("rate", 3), 0.5);
+}
+
+TEST(AnnotationTableTest, TreeAnnotations) {
+    auto tree = Tree::FromNewick("((A:1,B:2,C:3)[&rate=0.5]:4,D:5);");
+    tree->Root()->ChildAt(1)->SetAnnotation("rate", 2.0);
+    tree->EnableAnnotationTables();
+
+    auto table = tree->NodeAnnotations();
+    auto clade = tree->Root()->ChildAt(0);
+    clade->ParseComment(
+        {{"rate", [](const std::string& val) -> std::any { return std::stod(val); }}});
+    auto rate = table->Find("rate");
+    ASSERT_NE(rate, AnnotationTable::kNoKey);
+    EXPECT_DOUBLE_EQ(table->DoubleColumn(rate)[clade->Id()], 0.5);
+    EXPECT_DOUBLE_EQ(tree->Root()->ChildAt(1)->Annotation<double>("rate"), 2.0);
+    EXPECT_DOUBLE_EQ(clade->Annotation<double>("rate"), 0.5);
+
+    clade->SetBranchAnnotation("length", 4.0);
+    EXPECT_TRUE(clade->ContainsBranchAnnotation("length"));
+
+    // rows follow the ids when the topology changes
+    tree->MakeBinary();
+    EXPECT_EQ(table->RowCount(), 7);
+    EXPECT_DOUBLE_EQ(clade->Annotation<double>("rate"), 0.5);
+    EXPECT_DOUBLE_EQ(table->DoubleColumn(rate)[clade->Id()], 0.5);
+    EXPECT_DOUBLE_EQ(std::any_cast<double>(clade->BranchAnnotation("length")), 4.0);
+
+    NewickExportOptions options;
+    options.annotationKeys = {"rate"};
+    EXPECT_EQ(tree->Newick(options),
+              "(((A:1,B:2):0,C:3)[&rate=0.500000]:4,D[&rate=2.000000]:5);");
+
+    tree->DisableAnnotationTables();
+    EXPECT_EQ(tree->NodeAnnotations(), nullptr);
+    EXPECT_DOUBLE_EQ(clade->Annotation<double>("rate"), 0.5);
+}
@@ -0,0 +1,214 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/binary_tree_file.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cladokit/newick.hpp"
+#include "cladokit/nexus.hpp"
+#include "cladokit/nexus_writer.hpp"
+#include "cladokit/tree.hpp"
+#include "test_helpers.hpp"
+
+using cladokit::BinaryColumn;
+using cladokit::BinaryTreeFile;
+using cladokit::BinaryTreeOptions;
+using cladokit::BinaryTreeWriter;
+using cladokit::NewickExportOptions;
+using cladokit::NewickFile;
+using cladokit::NexusFile;
+using cladokit::NexusWriter;
+using cladokit::Tree;
+using cladokit::test::AnnotatedTrees;
+using cladokit::test::TempPath;
+using ColumnType = cladokit::AnnotationTable::ColumnType;
+
+namespace {
+BinaryTreeOptions AnnotatedOptions() {
+    BinaryTreeOptions options;
+    options.columns = {{"rate", ColumnType::kDouble, false},
+                       {"count", ColumnType::kInt, false},
+                       {"label", ColumnType::kString, true}};
+    return options;
+}
+
+NewickExportOptions ExportOptions() {
+    NewickExportOptions options;
+    options.includeInternalNodeName = true;
+    options.annotationKeys = {"rate", "count"};
+    options.branchAnnotationKeys = {"label"};
+    options.roundTripBranchLengths = true;
+    return options;
+}
+}  // namespace
+
+TEST(BinaryTreeFileTest, RoundTrip) {
+    auto trees = AnnotatedTrees(30);
+    auto path = TempPath("round_trip.ckt");
+    {
+        BinaryTreeWriter writer(path, trees[0]->Taxa(), AnnotatedOptions());
+        writer.Write(trees);
+        EXPECT_EQ(writer.TreeCount(), trees.size());
+    }
+
+    BinaryTreeFile file(path);
+    ASSERT_EQ(file.Count(), trees.size());
+    EXPECT_EQ(file.Version(), cladokit::BinaryTreeFormat::kVersion);
+    EXPECT_EQ(*file.Taxa()->Names(), *trees[0]->TaxonNames());
+    ASSERT_EQ(file.Columns().size(), 3);
+    EXPECT_EQ(file.Columns()[2].key, "label");
+    EXPECT_TRUE(file.Columns()[2].branch);
+
+    auto options = ExportOptions();
+    for (size_t i = 0; i < trees.size(); i++) {
+        ASSERT_TRUE(file.HasNext());
+        auto tree = file.Next();
+        EXPECT_EQ(tree->Newick(options), trees[i]->Newick(options));
+        EXPECT_EQ(tree->Taxa(), file.Taxa());
+    }
+    EXPECT_FALSE(file.HasNext());
+    EXPECT_EQ(file.Next(), nullptr);
+
+    // random access without an index
+    EXPECT_EQ(file.At(17)->Newick(options), trees[17]->Newick(options));
+    EXPECT_EQ(file.Next()->Newick(options), trees[18]->Newick(options));
+    EXPECT_THROW(file.Seek(trees.size()), std::out_of_range);
+
+    file.SetThreadCount(4);
+    auto parsed = file.Parse();
+    ASSERT_EQ(parsed.size(), trees.size());
+    for (size_t i = 0; i < trees.size(); i++) {
+        EXPECT_EQ(parsed[i]->Newick(options), trees[i]->Newick(options));
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(BinaryTreeFileTest, View) {
+    auto tree = Tree::FromNewick("((A:0.5,B:1.5)ab:2,C:3);",
+                                 std::make_shared<std::vector<std::string>>());
+    tree->Root()->ChildAt(0)->SetAnnotation("rate", 4.0);
+    auto path = TempPath("view.ckt");
+    BinaryTreeOptions options;
+    options.singlePrecision = true;
+    options.columns = {{"rate", ColumnType::kDouble, false}};
+    {
+        BinaryTreeWriter writer(path, tree->Taxa(), options);
+        writer.Write(*tree);
+    }
+
+    BinaryTreeFile file(path);
+    EXPECT_TRUE(file.SinglePrecision());
+    auto view = file.View(0);
+    EXPECT_EQ(view.NodeCount(), 5);
+    EXPECT_EQ(view.LeafNodeCount(), 3);
+    // ((A,B),C) entered and left in preorder
+    std::string topology;
+    for (size_t i = 0; i < 2 * view.NodeCount(); i++) {
+        topology += view.IsOpen(i) ? '(' : ')';
+    }
+    EXPECT_EQ(topology, "((()())())");
+    EXPECT_EQ(view.Taxon(2), 2);
+    EXPECT_TRUE(std::isnan(view.Distance(0)));
+    EXPECT_EQ(view.Distance(1), 2.0);
+    EXPECT_EQ(view.Distance(4), 3.0);
+    EXPECT_EQ(view.InternalName(1), "ab");
+    EXPECT_FALSE(view.HasValue(0, 0));
+    EXPECT_TRUE(view.HasValue(0, 1));
+    EXPECT_EQ(view.DoubleValue(0, 1), 4.0);
+    EXPECT_THROW(file.View(1), std::out_of_range);
+    std::filesystem::remove(path);
+}
+
+TEST(BinaryTreeFileTest, ConvertNexus) {
+    auto trees = AnnotatedTrees(20);
+    auto nexusPath = TempPath("convert.trees");
+    auto path = TempPath("convert.ckt");
+    {
+        std::ofstream out(nexusPath);
+        NexusWriter writer(out, trees[0]->Taxa());
+        writer.Write(trees);
+    }
+
+    std::ifstream in(nexusPath);
+    NexusFile nexus(in);
+    EXPECT_EQ(cladokit::ConvertToBinary(nexus, path), trees.size());
+
+    BinaryTreeFile file(path);
+    ASSERT_EQ(file.Count(), trees.size());
+    for (size_t i = 0; i < trees.size(); i++) {
+        EXPECT_EQ(file.Next()->Newick(), trees[i]->Newick());
+    }
+
+    std::stringstream empty;
+    NewickFile newick(empty);
+    EXPECT_EQ(cladokit::ConvertToBinary(newick, path), 0);
+    EXPECT_EQ(BinaryTreeFile(path).Count(), 0);
+    std::filesystem::remove(nexusPath);
+    std::filesystem::remove(path);
+}
+
+TEST(BinaryTreeFileTest, Errors) {
+    auto path = TempPath("errors.ckt");
+    {
+        std::ofstream out(path);
+        out << "(A:1,B:1);\n";
+    }
+    EXPECT_THROW(BinaryTreeFile file(path), std::runtime_error);
+
+    auto tree = Tree::FromNewick("((A:1,B:1):1,C:1);");
+    tree->Root()->SetAnnotation("rate", std::string("fast"));
+    BinaryTreeOptions options;
+    options.columns = {{"rate", ColumnType::kDouble, false}};
+    {
+        BinaryTreeWriter writer(path, tree->Taxa(), options);
+        EXPECT_THROW(writer.Write(*tree), std::invalid_argument);
+        writer.Write(*Tree::FromNewick("((A:1,C:1):1,B:1);"));
+        EXPECT_THROW(writer.Write(*Tree::FromNewick("((A:1,D:1):1,B:1);")),
+                     std::invalid_argument);
+        writer.Close();
+        EXPECT_THROW(writer.Write(*tree), std::logic_error);
+    }
+    EXPECT_EQ(BinaryTreeFile(path).Next()->Newick(), "((A:1,C:1):1,B:1);");
+
+    options.columns = {{"rate", ColumnType::kDoubleVector, false}};
+    EXPECT_THROW(BinaryTreeWriter(path, tree->Taxa(), options), std::invalid_argument);
+
+    // internal name starting past the end of the names
+    {
+        BinaryTreeWriter writer(path, tree->Taxa());
+        writer.Write(*Tree::FromNewick("((A:1,B:1)ab:1,C:1)abc;"));
+    }
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), {});
+    }
+    cladokit::BinaryTreeFormat::Header header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    uint64_t record;
+    std::memcpy(&record, bytes.data() + header.offsetsOffset, sizeof(record));
+    // 16 bytes of counts, 1 topology word, 3 leaves and 5 lengths
+    uint32_t offset = 1000;
+    std::memcpy(&bytes[record + 16 + 8 + 16 + 40], &offset, sizeof(offset));
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << bytes;
+    }
+    BinaryTreeFile corrupt(path);
+    EXPECT_THROW(corrupt.View(0).InternalName(0), std::runtime_error);
+    EXPECT_THROW(corrupt.Next(), std::runtime_error);
+    std::filesystem::remove(path);
+}
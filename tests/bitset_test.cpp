@@ -0,0 +1,111 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/bitset.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using cladokit::Bitset;
+
+TEST(BitsetTest, SetAndTest) {
+    Bitset bitset(130);
+    EXPECT_EQ(bitset.Size(), 130);
+    EXPECT_EQ(bitset.Words().size(), 3);
+    EXPECT_FALSE(bitset.Any());
+
+    bitset.Set(0);
+    bitset.Set(64);
+    bitset.Set(129);
+    EXPECT_TRUE(bitset[0]);
+    EXPECT_TRUE(bitset.Test(64));
+    EXPECT_FALSE(bitset[1]);
+    EXPECT_EQ(bitset.Count(), 3);
+
+    bitset.Reset(64);
+    EXPECT_FALSE(bitset[64]);
+    EXPECT_EQ(bitset.Count(), 2);
+
+    bitset.Clear();
+    EXPECT_EQ(bitset.Count(), 0);
+}
+
+TEST(BitsetTest, WordOperations) {
+    // large enough to use the vector kernels and a scalar tail
+    size_t size = 64 * 9 + 5;
+    Bitset a(size);
+    Bitset b(size);
+    std::vector<bool> expectedOr(size), expectedAnd(size), expectedXor(size);
+    for (size_t i = 0; i < size; i++) {
+        bool x = i % 3 == 0;
+        bool y = i % 5 == 0;
+        if (x) a.Set(i);
+        if (y) b.Set(i);
+        expectedOr[i] = x || y;
+        expectedAnd[i] = x && y;
+        expectedXor[i] = x != y;
+    }
+
+    Bitset c = a;
+    c |= b;
+    EXPECT_EQ(c, Bitset(expectedOr));
+    c = a;
+    c &= b;
+    EXPECT_EQ(c, Bitset(expectedAnd));
+    c = a;
+    c ^= b;
+    EXPECT_EQ(c, Bitset(expectedXor));
+}
+
+TEST(BitsetTest, FlipKeepsPaddingClear) {
+    Bitset bitset(70);
+    bitset.Set(3);
+    bitset.Flip();
+    EXPECT_EQ(bitset.Count(), 69);
+    EXPECT_FALSE(bitset[3]);
+    bitset.Flip();
+    EXPECT_EQ(bitset.Count(), 1);
+}
+
+TEST(BitsetTest, HashUsesAllBits) {
+    Bitset a(500);
+    Bitset b(500);
+    a.Set(1);
+    b.Set(2);
+    EXPECT_NE(a.Hash(), b.Hash());
+    b.Reset(2);
+    b.Set(1);
+    EXPECT_EQ(a.Hash(), b.Hash());
+}
+
+TEST(BitsetTest, HashFollowsModifications) {
+    // hash of a bitset built bit by bit
+    auto rebuilt = [](const Bitset& bitset) {
+        Bitset copy(bitset.Size());
+        for (size_t i = 0; i < bitset.Size(); i++) {
+            if (bitset[i]) copy.Set(i);
+        }
+        return copy.Hash();
+    };
+    Bitset a(150);
+    Bitset b(150);
+    for (size_t i = 0; i < 150; i += 3) a.Set(i);
+    for (size_t i = 0; i < 150; i += 5) b.Set(i);
+    a.Set(3);
+    b.Reset(7);
+
+    Bitset c = a;
+    c |= b;
+    EXPECT_EQ(c.Hash(), rebuilt(c));
+    c = a;
+    c &= b;
+    EXPECT_EQ(c.Hash(), rebuilt(c));
+    c = a;
+    c ^= b;
+    EXPECT_EQ(c.Hash(), rebuilt(c));
+    c.Flip();
+    EXPECT_EQ(c.Hash(), rebuilt(c));
+    c.Clear();
+    EXPECT_EQ(c.Hash(), Bitset(150).Hash());
+}
@@ -0,0 +1,146 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/compact_tree.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cladokit/taxon_set.hpp"
+#include "cladokit/tree.hpp"
+#include "cladokit/tree_metric.hpp"
+
+using cladokit::CompactTree;
+using cladokit::NewickExportOptions;
+using cladokit::RobinsonFouldsMetric;
+using cladokit::TaxonSet;
+using cladokit::Tree;
+
+TEST(CompactTreeTest, CreateFromNewick) {
+    auto taxonNames = std::make_shared<std::vector<std::string>>(
+        std::vector<std::string>{"A", "B", "C"});
+    auto tree = CompactTree::FromNewick("((C:0.1,B:0.2)X:0.3,A:2);", taxonNames);
+
+    EXPECT_EQ(tree->NodeCount(), 5);
+    EXPECT_EQ(tree->LeafNodeCount(), 3);
+    EXPECT_EQ(tree->InternalNodeCount(), 2);
+    EXPECT_TRUE(tree->IsRoot(tree->Root()));
+    EXPECT_EQ(tree->ChildCount(tree->Root()), 2);
+
+    // leaves are indexed by taxon
+    EXPECT_EQ(tree->Name(0), "A");
+    EXPECT_DOUBLE_EQ(tree->Distance(0), 2);
+    EXPECT_DOUBLE_EQ(tree->Distance(2), 0.1);
+    EXPECT_EQ(tree->Parent(0), tree->Root());
+    EXPECT_EQ(tree->Name(tree->Parent(2)), "X");
+    EXPECT_EQ(tree->FirstChild(tree->Parent(2)), 2);
+    EXPECT_EQ(tree->NextSibling(2), 1);
+
+    EXPECT_EQ(CompactTree::FromNewick("((A,B),C); \n")->LeafNodeCount(), 3);
+    EXPECT_THROW(CompactTree::FromNewick("(A,B);(C,D);"), std::invalid_argument);
+    EXPECT_THROW(CompactTree::FromNewick("((A,B),C);garbage"), std::invalid_argument);
+}
+
+TEST(CompactTreeTest, InvalidNewick) {
+    for (std::string newick : {
+             "(A,B));",           // unbalanced parenthesis
+             "(A,B),C;",          // comma after the root
+             "(A,B)C,(D,E);",     // sibling of the root
+             "(A,B)C D[&x]E;",    // label after the root
+             "(A,B)(C,D);",       // node after the root
+             "(A,(B,C)D[&x]E);",  // missing comma
+             "(,);",              // empty children
+             "(A,,B);",           // empty child
+             "(A,B,);",           // empty last child
+             ":1;",               // branch length without node
+             "(A,:1);",           // branch length without node
+             "(A,B",              // unclosed parenthesis
+             "((A,B),C;",         // unclosed parenthesis
+             "",                  // no node
+         }) {
+        EXPECT_THROW(CompactTree::FromNewick(newick), std::invalid_argument) << newick;
+    }
+    EXPECT_EQ(CompactTree::FromNewick("(A,B)[&R]C;")->Name(2), "C");
+}
+
+TEST(CompactTreeTest, SharedTaxonSet) {
+    auto taxonSet =
+        std::make_shared<const TaxonSet>(std::vector<std::string>{"A", "B", "C"});
+    auto tree1 = CompactTree::FromNewick("((C,B),A);", taxonSet);
+    auto tree2 = CompactTree::FromNewick("((A,C),B);", taxonSet);
+    EXPECT_EQ(tree1->TaxonNames(), taxonSet->Names());
+    EXPECT_EQ(tree2->TaxonNames(), taxonSet->Names());
+    EXPECT_EQ(tree1->Name(2), "C");
+    EXPECT_EQ(tree2->Parent(0), tree2->Parent(2));
+
+    // a taxon mismatch is reported like in Tree::FromNewick
+    auto taxonNames = std::make_shared<std::vector<std::string>>(*taxonSet->Names());
+    for (std::string newick : {"((A,B),D);", "((A,B),(C,D));", "(A,B);", "((A,B),A);"}) {
+        EXPECT_THROW(CompactTree::FromNewick(newick, taxonSet), std::runtime_error)
+            << newick;
+        EXPECT_THROW(CompactTree::FromNewick(newick, taxonNames), std::runtime_error)
+            << newick;
+        EXPECT_THROW(Tree::FromNewick(newick, taxonNames), std::runtime_error) << newick;
+    }
+}
+
+TEST(CompactTreeTest, ConvertToAndFromTree) {
+    std::string newick = "(((A:1,B:2)AB:3,C:4):5,D:6,E:0.5);";
+    auto tree = Tree::FromNewick(newick);
+    CompactTree compact(*tree);
+
+    NewickExportOptions options;
+    options.includeInternalNodeName = true;
+    EXPECT_EQ(compact.ToTree()->Newick(options), tree->Newick(options));
+    EXPECT_EQ(CompactTree::FromNewick(newick)->ToTree()->Newick(options),
+              tree->Newick(options));
+
+    // annotations are dropped
+    auto annotated = Tree::FromNewick("((A:1,B:2):3,C:4);");
+    annotated->LeafFromName("A")->SetAnnotation("h", 1.0);
+    auto converted = CompactTree(*annotated).ToTree();
+    EXPECT_FALSE(converted->LeafFromName("A")->ContainsAnnotation("h"));
+    EXPECT_EQ(converted->Newick(), annotated->Newick());
+}
+
+TEST(CompactTreeTest, TraversalOrder) {
+    auto tree = Tree::FromNewick("(((A,B),C),(D,E));");
+    CompactTree compact(*tree);
+
+    std::vector<std::string> expected;
+    for (auto it = tree->Root()->begin_postorder(); it != tree->Root()->end_postorder();
+         ++it) {
+        expected.push_back((*it)->Name());
+    }
+    std::vector<std::string> names;
+    for (auto node : compact.PostOrder()) {
+        names.push_back(compact.Name(node));
+    }
+    EXPECT_EQ(names, expected);
+
+    expected.clear();
+    names.clear();
+    for (auto it = tree->Root()->begin_preorder(); it != tree->Root()->end_preorder();
+         ++it) {
+        expected.push_back((*it)->Name());
+    }
+    for (auto node : compact.PreOrder()) {
+        names.push_back(compact.Name(node));
+    }
+    EXPECT_EQ(names, expected);
+}
+
+TEST(CompactTreeTest, RobinsonFouldsMetric) {
+    auto taxonNames = std::make_shared<std::vector<std::string>>();
+    auto tree1 = CompactTree::FromNewick("((A,B),(C,D),E);", taxonNames);
+    auto tree2 = CompactTree::FromNewick("(((A,B),C),D,E);", taxonNames);
+
+    RobinsonFouldsMetric metric;
+
+    EXPECT_DOUBLE_EQ(metric.Compute(*tree1, *tree1), 0.0);
+    EXPECT_DOUBLE_EQ(metric.Compute(*tree1, *tree2), 2.0);
+}
@@ -0,0 +1,236 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/compressed_stream.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "cladokit/newick.hpp"
+#include "cladokit/nexus.hpp"
+#include "test_helpers.hpp"
+
+using cladokit::Compression;
+using cladokit::CompressedIfstream;
+using cladokit::CompressedOfstream;
+using cladokit::NewickFile;
+using cladokit::NexusFile;
+using cladokit::test::NexusWithTranslate;
+using cladokit::test::TempPath;
+
+namespace {
+// Errors of the stream buffer are not swallowed as they are by operator<<.
+std::string ReadAll(std::istream &in) {
+    return std::string(std::istreambuf_iterator<char>(in), {});
+}
+}  // namespace
+
+TEST(CompressedStreamTest, PlainFile) {
+    auto path = TempPath("plain.nwk");
+    {
+        CompressedOfstream out(path);
+        out << "((A:1,B:2):1,C:3);\n";
+    }
+    CompressedIfstream in(path);
+    EXPECT_EQ(in.GetCompression(), Compression::kNone);
+    NewickFile file(in);
+    EXPECT_EQ(file.Count(), 1);
+    std::filesystem::remove(path);
+
+    EXPECT_THROW(CompressedIfstream("/nonexistent/cladokit.gz"), std::runtime_error);
+
+    // only the compressed stream throws on read errors, other streams are left as is
+    std::stringstream plain("((A:1,B:2):1,C:3);\n");
+    NewickFile plainFile(plain);
+    EXPECT_EQ(plainFile.Count(), 1);
+    EXPECT_EQ(plain.exceptions(), std::ios::goodbit);
+}
+
+TEST(CompressedStreamTest, GzipRoundTrip) {
+    if (!cladokit::CompressionSupported(Compression::kGzip)) {
+        GTEST_SKIP() << "gzip support not available";
+    }
+    auto path = TempPath("round_trip.txt.gz");
+    std::string content;
+    for (int i = 0; i < 100000; i++) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    {
+        CompressedOfstream out(path);
+        out << content;
+    }
+    EXPECT_LT(std::filesystem::file_size(path), content.size());
+
+    std::ifstream raw(path, std::ios::binary);
+    EXPECT_EQ(cladokit::DetectCompression(raw), Compression::kGzip);
+    EXPECT_EQ(raw.tellg(), 0);
+
+    CompressedIfstream in(path);
+    EXPECT_EQ(in.GetCompression(), Compression::kGzip);
+    EXPECT_EQ(ReadAll(in), content);
+
+    // seeking backward decompresses again from the start
+    in.clear();
+    in.seekg(5);
+    std::string line;
+    std::getline(in, line);
+    EXPECT_EQ(line, "0");
+    std::filesystem::remove(path);
+}
+
+TEST(CompressedStreamTest, GzipTreeFiles) {
+    if (!cladokit::CompressionSupported(Compression::kGzip)) {
+        GTEST_SKIP() << "gzip support not available";
+    }
+    auto newickPath = TempPath("trees.nwk.gz");
+    {
+        CompressedOfstream out(newickPath);
+        out << "((A:1,B:2):1,C:3);\n((C:1,A:2):1,B:3);\n";
+    }
+    CompressedIfstream newickIn(newickPath);
+    NewickFile newick(newickIn);
+    EXPECT_EQ(newick.Count(), 2);
+    auto trees = newick.Parse();
+    ASSERT_EQ(trees.size(), 2);
+    EXPECT_EQ(trees[1]->LeafFromName("C")->Id(), 2);
+    std::filesystem::remove(newickPath);
+
+    auto nexusPath = TempPath("trees.nex.gz");
+    {
+        CompressedOfstream out(nexusPath, Compression::kGzip, 9);
+        out << NexusWithTranslate();
+    }
+    CompressedIfstream nexusIn(nexusPath);
+    NexusFile nexus(nexusIn);
+    EXPECT_EQ(nexus.Count(), 3);
+    ASSERT_EQ(nexus.Parse().size(), 3);
+    std::filesystem::remove(nexusPath);
+}
+
+TEST(CompressedStreamTest, TruncatedAndCorruptGzip) {
+    if (!cladokit::CompressionSupported(Compression::kGzip)) {
+        GTEST_SKIP() << "gzip support not available";
+    }
+    auto newickPath = TempPath("damaged.nwk.gz");
+    auto nexusPath = TempPath("damaged.nex.gz");
+    {
+        CompressedOfstream out(newickPath);
+        for (int i = 0; i < 200; i++) {
+            out << "((A:" << i << ",B:2):1,C:3);\n";
+        }
+    }
+    {
+        CompressedOfstream out(nexusPath);
+        out << NexusWithTranslate();
+    }
+
+    for (const auto &path : {newickPath, nexusPath}) {
+        std::string bytes;
+        {
+            std::ifstream in(path, std::ios::binary);
+            bytes = ReadAll(in);
+        }
+        auto truncated = bytes.substr(0, bytes.size() / 2);
+        auto corrupt = bytes;
+        for (size_t i = 12; i < corrupt.size() - 8; i += 3) corrupt[i] ^= 0x5a;
+
+        for (const auto &damaged : {truncated, corrupt}) {
+            {
+                std::ofstream out(path, std::ios::binary);
+                out << damaged;
+            }
+            CompressedIfstream in(path);
+            if (path == newickPath) {
+                NewickFile file(in);
+                EXPECT_THROW(file.Parse(), std::runtime_error);
+            } else {
+                NexusFile file(in);
+                EXPECT_THROW(file.Parse(), std::runtime_error);
+            }
+        }
+        std::filesystem::remove(path);
+    }
+}
+
+TEST(CompressedStreamTest, ZstdRoundTrip) {
+    if (!cladokit::CompressionSupported(Compression::kZstd)) {
+        GTEST_SKIP() << "zstd support not available";
+    }
+    auto path = TempPath("round_trip.txt.zst");
+    std::string content;
+    for (int i = 0; i < 100000; i++) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    {
+        CompressedOfstream out(path);
+        out << content;
+    }
+    EXPECT_LT(std::filesystem::file_size(path), content.size());
+    {
+        CompressedIfstream in(path);
+        EXPECT_EQ(in.GetCompression(), Compression::kZstd);
+        EXPECT_EQ(ReadAll(in), content);
+    }
+
+    // a file can contain several frames
+    auto second = TempPath("second.txt.zst");
+    {
+        CompressedOfstream out(second);
+        out << "last line\n";
+    }
+    std::string bytes;
+    for (const auto &part : {path, second}) {
+        std::ifstream in(part, std::ios::binary);
+        bytes += ReadAll(in);
+    }
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << bytes;
+    }
+    CompressedIfstream in(path);
+    EXPECT_EQ(ReadAll(in), content + "last line\n");
+
+    auto treePath = TempPath("trees.nex.zst");
+    {
+        CompressedOfstream out(treePath);
+        out << NexusWithTranslate();
+    }
+    CompressedIfstream nexusIn(treePath);
+    NexusFile nexus(nexusIn);
+    EXPECT_EQ(nexus.Parse().size(), 3);
+    std::filesystem::remove(path);
+    std::filesystem::remove(second);
+    std::filesystem::remove(treePath);
+}
+
+TEST(CompressedStreamTest, TruncatedZstd) {
+    if (!cladokit::CompressionSupported(Compression::kZstd)) {
+        GTEST_SKIP() << "zstd support not available";
+    }
+    auto path = TempPath("damaged.nwk.zst");
+    {
+        CompressedOfstream out(path);
+        for (int i = 0; i < 200; i++) {
+            out << "((A:" << i << ",B:2):1,C:3);\n";
+        }
+    }
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes = ReadAll(in);
+    }
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << bytes.substr(0, bytes.size() / 2);
+    }
+    CompressedIfstream in(path);
+    NewickFile file(in);
+    EXPECT_THROW(file.Parse(), std::runtime_error);
+    std::filesystem::remove(path);
+}
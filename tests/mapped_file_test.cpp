@@ -0,0 +1,127 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/mapped_file.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "cladokit/newick.hpp"
+#include "cladokit/nexus.hpp"
+#include "test_helpers.hpp"
+
+using cladokit::MappedFile;
+using cladokit::MappedNewickFile;
+using cladokit::MappedNexusFile;
+using cladokit::NewickFile;
+using cladokit::NexusFile;
+
+namespace {
+std::filesystem::path WriteFile(const std::string &name, const std::string &content) {
+    auto path = cladokit::test::TempPath(name);
+    std::ofstream out(path);
+    out << content;
+    return path;
+}
+
+// the taxa block precedes the trees block
+std::string Nexus() {
+    return cladokit::test::NexusWithTranslate(cladokit::test::kTranslatedTrees,
+                                              cladokit::test::kTranslate,
+                                              "begin taxa;\n"
+                                              "  dimensions ntax=3;\n"
+                                              "end;\n");
+}
+}  // namespace
+
+TEST(MappedFileTest, View) {
+    auto path = WriteFile("mapped_view.txt", "first\nsecond\n");
+    MappedFile file(path);
+    EXPECT_EQ(file.View(), "first\nsecond\n");
+
+    size_t position = 0;
+    EXPECT_EQ(cladokit::NextLine(file.View(), position), "first");
+    EXPECT_EQ(cladokit::NextLine(file.View(), position), "second");
+    EXPECT_EQ(position, file.Size());
+
+    EXPECT_THROW(MappedFile("/nonexistent/cladokit"), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+TEST(MappedFileTest, Newick) {
+    std::string content = "((A:1,B:2):1,C:3);\n\n((C:1,A:2):1,B:3);\n((B:1,C:2):1,A:3);";
+    auto path = WriteFile("mapped.tre", content);
+
+    std::stringstream in(content);
+    auto expected = NewickFile(in).Parse();
+
+    MappedNewickFile file(path);
+    EXPECT_EQ(file.Count(), 3);
+    auto trees = file.Parse();
+    ASSERT_EQ(trees.size(), expected.size());
+    for (size_t i = 0; i < trees.size(); i++) {
+        EXPECT_EQ(trees[i]->Newick(), expected[i]->Newick());
+    }
+
+    MappedNewickFile iterated(path);
+    EXPECT_TRUE(iterated.HasNext());
+    iterated.SkipNext();
+    EXPECT_EQ(iterated.Next()->Newick(), expected[1]->Newick());
+    EXPECT_EQ(iterated.Next()->Newick(), expected[2]->Newick());
+    EXPECT_FALSE(iterated.HasNext());
+    EXPECT_EQ(iterated.Next(), nullptr);
+    std::filesystem::remove(path);
+}
+
+TEST(MappedFileTest, Nexus) {
+    auto path = WriteFile("mapped.trees", Nexus());
+
+    std::stringstream in(Nexus());
+    auto expected = NexusFile(in).Parse();
+    ASSERT_EQ(expected.size(), 3);
+
+    MappedNexusFile file(path);
+    EXPECT_EQ(file.Count(), 3);
+    auto trees = file.Parse();
+    ASSERT_EQ(trees.size(), expected.size());
+    for (size_t i = 0; i < trees.size(); i++) {
+        EXPECT_EQ(trees[i]->Newick(), expected[i]->Newick());
+        EXPECT_EQ(*trees[i]->TaxonNames(), *expected[i]->TaxonNames());
+    }
+    EXPECT_EQ(trees[0]->Newick(), "((A:0.1,B:0.2):0.3,C:0.4);");
+
+    MappedNexusFile iterated(path);
+    EXPECT_TRUE(iterated.HasNext());
+    iterated.SkipNext();
+    EXPECT_EQ(iterated.Next()->Newick(), expected[1]->Newick());
+    EXPECT_TRUE(iterated.HasNext());
+    EXPECT_EQ(iterated.Next()->Newick(), expected[2]->Newick());
+    EXPECT_FALSE(iterated.HasNext());
+    std::filesystem::remove(path);
+}
+
+TEST(MappedFileTest, TruncatedNexus) {
+    // the last statement ends the file without a semicolon or a newline
+    std::string header = cladokit::test::NexusWithTranslate({});
+    header.resize(header.size() - std::string("end;\n").size());
+    for (std::string last : {"tree STATE_1 = [&R] ((1:0.1,2:0.2", "tree STATE_1 = [&R]",
+                             "tree 'STATE_1", "tree STATE_1 [&lnP=-1"}) {
+        auto path = WriteFile("truncated.trees", header + last);
+        MappedNexusFile file(path);
+        EXPECT_THROW(file.Parse(), std::invalid_argument) << last;
+        std::filesystem::remove(path);
+    }
+
+    // a complete tree is read without its semicolon
+    auto path = WriteFile("truncated.trees", header + "tree STATE_1 = ((1:1,2:2):1,3:3)");
+    MappedNexusFile file(path);
+    auto trees = file.Parse();
+    ASSERT_EQ(trees.size(), 1);
+    EXPECT_EQ(trees[0]->Newick(), "((A:1,B:2):1,C:3);");
+    std::filesystem::remove(path);
+}
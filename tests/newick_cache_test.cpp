@@ -0,0 +1,134 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/newick_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cladokit/node.hpp"
+#include "cladokit/tree.hpp"
+#include "test_helpers.hpp"
+
+using cladokit::NewickCache;
+using cladokit::NewickExportOptions;
+using cladokit::Node;
+using cladokit::Tree;
+using cladokit::test::TaxonNames;
+
+namespace {
+bool IsAncestor(const Node *ancestor, const Node *node) {
+    for (auto parent = node->Parent(); parent; parent = parent->Parent()) {
+        if (parent.get() == ancestor) return true;
+    }
+    return false;
+}
+}  // namespace
+
+TEST(NewickCacheTest, SameAsNewick) {
+    auto tree = Tree::FromNewick("((A:0.1,B:0.2)ab:0.3,(C:0.4,D:0.5):0.6);",
+                                 std::make_shared<std::vector<std::string>>());
+    EXPECT_THROW(tree->CachedNewick(), std::logic_error);
+
+    NewickExportOptions options;
+    options.includeInternalNodeName = true;
+    options.annotationKeys = {"rate"};
+    tree->EnableNewickCache(options);
+    EXPECT_EQ(tree->CachedNewick(), tree->Newick(options));
+    // nothing changed
+    EXPECT_EQ(tree->CachedNewick(), tree->Newick(options));
+
+    auto ab = tree->Root()->ChildAt(0);
+    ab->ChildAt(1)->SetDistance(2.5);
+    EXPECT_EQ(tree->CachedNewick(), "((A:0.1,B:2.5)ab:0.3,(C:0.4,D:0.5):0.6);");
+
+    ab->SetAnnotation("rate", 1.5);
+    ab->SetName("x");
+    EXPECT_EQ(tree->CachedNewick(), tree->Newick(options));
+
+    auto cd = tree->Root()->ChildAt(1);
+    auto d = cd->ChildAt(1);
+    cd->RemoveChild(d);
+    ab->AddChild(d);
+    EXPECT_EQ(tree->CachedNewick(), tree->Newick(options));
+
+    tree->DisableNewickCache();
+    EXPECT_THROW(tree->CachedNewick(), std::logic_error);
+}
+
+TEST(NewickCacheTest, FormatsModifiedPath) {
+    auto tree = Tree::Random(TaxonNames(256));
+    NewickCache cache;
+    cache.Update(*tree->Root());
+    EXPECT_EQ(cache.FormattedCount(), tree->NodeCount());
+    cache.Update(*tree->Root());
+    EXPECT_EQ(cache.FormattedCount(), 0);
+
+    const auto &leaf = tree->Nodes()[17];
+    leaf->SetDistance(0.125);
+    size_t pathLength = 1;
+    for (auto parent = leaf->Parent(); parent; parent = parent->Parent()) {
+        pathLength++;
+    }
+    EXPECT_EQ(cache.Update(*tree->Root()), tree->Newick());
+    EXPECT_EQ(cache.FormattedCount(), pathLength);
+
+    cache.Rebuild(*tree->Root());
+    EXPECT_EQ(cache.FormattedCount(), tree->NodeCount());
+}
+
+TEST(NewickCacheTest, ReRoot) {
+    auto tree = Tree::Random(TaxonNames(20));
+    tree->EnableNewickCache();
+    tree->CachedNewick();
+    tree->ReRootAbove(tree->Nodes()[5]);
+    EXPECT_EQ(tree->CachedNewick(), tree->Newick());
+    tree->ReRootAbove(tree->Nodes()[11]);
+    EXPECT_EQ(tree->CachedNewick(), tree->Newick());
+}
+
+TEST(NewickCacheTest, RandomChanges) {
+    std::mt19937 generator(7);
+    auto tree = Tree::Random(TaxonNames(50));
+    NewickExportOptions options;
+    options.annotationKeys = {"rate"};
+    options.decimalPrecision = 3;
+    tree->EnableNewickCache(options);
+    const auto &nodes = tree->Nodes();
+    std::uniform_int_distribution<size_t> pick(0, nodes.size() - 1);
+    std::uniform_real_distribution<double> value(0, 1);
+
+    for (int iteration = 0; iteration < 300; iteration++) {
+        int changes = 1 + iteration % 3;
+        for (int i = 0; i < changes; i++) {
+            const auto &a = nodes[pick(generator)];
+            const auto &b = nodes[pick(generator)];
+            switch (generator() % 3) {
+                case 0:
+                    a->SetDistance(value(generator));
+                    break;
+                case 1:
+                    a->SetAnnotation("rate", value(generator));
+                    break;
+                default:
+                    // swap two disjoint subtrees
+                    if (a->IsRoot() || b->IsRoot() || a == b ||
+                        IsAncestor(a.get(), b.get()) || IsAncestor(b.get(), a.get())) {
+                        break;
+                    }
+                    auto parentA = a->Parent();
+                    auto parentB = b->Parent();
+                    parentA->RemoveChild(a);
+                    parentB->RemoveChild(b);
+                    parentA->AddChild(b);
+                    parentB->AddChild(a);
+            }
+        }
+        ASSERT_EQ(tree->CachedNewick(), tree->Newick(options)) << iteration;
+    }
+}
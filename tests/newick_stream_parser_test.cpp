@@ -0,0 +1,171 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/newick_stream_parser.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cladokit/nexus.hpp"
+#include "cladokit/tree.hpp"
+#include "test_helpers.hpp"
+
+using cladokit::MappedNexusFile;
+using cladokit::NewickExportOptions;
+using cladokit::NewickStreamParser;
+using cladokit::NexusFile;
+using cladokit::StreamingNewickFile;
+using cladokit::Tree;
+
+namespace {
+const char kTrees[] =
+    "[&R] ((A:0.1,\n"
+    "  'B C':0.2[&rate=1,\n"
+    "  note=\"a;b\"]):0.3,\n"
+    "  'it''s':0.4)root;\n"
+    "((A:1,'B C':2):3,'it''s':4);";
+}  // namespace
+
+TEST(NewickStreamParserTest, ArbitraryChunks) {
+    NewickExportOptions options;
+    options.includeRawComment = true;
+    std::string expected = Tree::FromNewick(
+        "((A:0.1,'B C':0.2[&rate=1,\n  note=\"a;b\"]):0.3,'it''s':0.4)root;")
+                               ->Newick(options);
+
+    std::string text(kTrees);
+    for (size_t chunkSize : {1, 2, 3, 7, 64}) {
+        NewickStreamParser parser;
+        for (size_t i = 0; i < text.size(); i += chunkSize) {
+            parser.Feed(text.substr(i, chunkSize));
+        }
+        parser.Finish();
+        ASSERT_EQ(parser.Available(), 2) << chunkSize;
+        auto first = parser.Take();
+        auto second = parser.Take();
+        EXPECT_EQ(first->Newick(options), expected) << chunkSize;
+        EXPECT_EQ(first->LeafNodeCount(), 3);
+        EXPECT_EQ(second->Taxa(), first->Taxa());
+        EXPECT_EQ(second->LeafFromName("it's")->Distance(), 4);
+        EXPECT_EQ(parser.Take(), nullptr);
+    }
+}
+
+TEST(NewickStreamParserTest, Errors) {
+    NewickStreamParser incomplete;
+    incomplete.Feed("((A:1,B:2):1,C:3");
+    EXPECT_THROW(incomplete.Finish(), std::invalid_argument);
+
+    NewickStreamParser comment;
+    comment.Feed("((A,B),C)[&R");
+    EXPECT_THROW(comment.Finish(), std::invalid_argument);
+
+    NewickStreamParser branchLength;
+    EXPECT_THROW(branchLength.Feed("((A:,B),C);"), std::invalid_argument);
+
+    // dangling comma or parenthesis
+    for (std::string text : {"(A,B,", "(A,B,(", "((A,B),C", "(A,B,);"}) {
+        NewickStreamParser dangling;
+        EXPECT_THROW(
+            {
+                dangling.Feed(text);
+                dangling.Finish();
+            },
+            std::invalid_argument)
+            << text;
+    }
+
+    // the last semicolon is optional
+    NewickStreamParser unterminated;
+    unterminated.Feed("((A,B),C)");
+    unterminated.Finish();
+    EXPECT_EQ(unterminated.Available(), 1);
+}
+
+TEST(NewickStreamParserTest, LabelsWithSpaces) {
+    for (size_t chunkSize : {1, 3, 64}) {
+        std::string text = "(Homo sapiens:1, B :2,C\t:3);";
+        NewickStreamParser parser;
+        for (size_t i = 0; i < text.size(); i += chunkSize) {
+            parser.Feed(std::string_view(text).substr(i, chunkSize));
+        }
+        parser.Finish();
+        auto tree = parser.Take();
+        ASSERT_NE(tree, nullptr) << chunkSize;
+        EXPECT_EQ(tree->LeafNodeCount(), 3) << chunkSize;
+        EXPECT_EQ(tree->LeafFromName("Homo sapiens")->Distance(), 1) << chunkSize;
+        EXPECT_EQ(tree->LeafFromName("B")->Distance(), 2) << chunkSize;
+        EXPECT_EQ(tree->LeafFromName("C")->Distance(), 3) << chunkSize;
+    }
+}
+
+TEST(NewickStreamParserTest, StreamingNewickFile) {
+    std::stringstream in(kTrees);
+    StreamingNewickFile file(in);
+    EXPECT_EQ(file.Count(), 2);
+    auto trees = file.Parse();
+    ASSERT_EQ(trees.size(), 2);
+    EXPECT_EQ(trees[0]->Taxa(), trees[1]->Taxa());
+    EXPECT_FALSE(file.HasNext());
+    EXPECT_EQ(file.Next(), nullptr);
+
+    std::stringstream in2(kTrees);
+    StreamingNewickFile file2(in2);
+    file2.SkipNext();
+    auto tree = file2.Next();
+    ASSERT_NE(tree, nullptr);
+    EXPECT_EQ(tree->LeafFromName("A")->Distance(), 1);
+
+    // the first chunk read by Next reaches the end of the stream
+    std::stringstream in3("(A,B);\n(A,\n B);\n(B,A);\n");
+    StreamingNewickFile file3(in3);
+    ASSERT_NE(file3.Next(), nullptr);
+    EXPECT_EQ(file3.Count(), 3);
+    EXPECT_EQ(file3.Parse().size(), 2);
+    EXPECT_EQ(file3.Count(), 3);
+}
+
+TEST(NewickStreamParserTest, MultiLineNexusStatement) {
+    const std::string nexus =
+        "#NEXUS\n"
+        "begin trees;\n"
+        "  translate\n"
+        "    1 A,\n"
+        "    2 B,\n"
+        "    3 C\n"
+        "  ;\n"
+        "tree STATE_0 = [&R]\n"
+        "  ((1:0.1,\n"
+        "    2:0.2[&note=\"x;\n"
+        "y\"]):0.3,\n"
+        "   3:0.4);\n"
+        "tree STATE_1 = [&R] ((3:0.1,2:0.2):0.3,1:0.4);\n"
+        "end;\n";
+    std::stringstream in(nexus);
+    NexusFile file(in);
+    auto trees = file.Parse();
+    ASSERT_EQ(trees.size(), 2);
+    EXPECT_EQ(trees[0]->LeafFromName("B")->Distance(), 0.2);
+    EXPECT_EQ(trees[0]->LeafFromName("C")->Distance(), 0.4);
+    EXPECT_EQ(trees[1]->LeafFromName("A")->Distance(), 0.4);
+
+    auto path = cladokit::test::TempPath("multi_line.nex");
+    {
+        std::ofstream out(path);
+        out << nexus;
+    }
+    MappedNexusFile mapped(path);
+    auto mappedTrees = mapped.Parse();
+    ASSERT_EQ(mappedTrees.size(), 2);
+    EXPECT_EQ(mappedTrees[0]->LeafFromName("C")->Distance(), 0.4);
+    EXPECT_EQ(mappedTrees[1]->LeafFromName("A")->Distance(), 0.4);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,137 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/newick_tokenizer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cladokit/compact_tree.hpp"
+#include "cladokit/tree.hpp"
+
+using cladokit::CompactTree;
+using cladokit::NewickTokenizer;
+using cladokit::Tree;
+using TokenType = NewickTokenizer::TokenType;
+
+TEST(NewickTokenizerTest, Tokens) {
+    NewickTokenizer tokenizer("(A:0.1,B[&h=1]:[&r=2]2e-1) C;");
+    std::vector<TokenType> types;
+    std::vector<std::string> texts;
+    for (auto token = tokenizer.Next(); token.type != TokenType::kEnd;
+         token = tokenizer.Next()) {
+        types.push_back(token.type);
+        texts.emplace_back(token.text);
+    }
+    std::vector<TokenType> expectedTypes = {
+        TokenType::kOpen,    TokenType::kLabel, TokenType::kColon, TokenType::kLabel,
+        TokenType::kComma,   TokenType::kLabel, TokenType::kComment, TokenType::kColon,
+        TokenType::kComment, TokenType::kLabel, TokenType::kClose, TokenType::kLabel,
+        TokenType::kSemicolon};
+    std::vector<std::string> expectedTexts = {
+        "(", "A", ":", "0.1", ",", "B", "[&h=1]", ":", "[&r=2]", "2e-1", ")", "C", ";"};
+    EXPECT_EQ(types, expectedTypes);
+    EXPECT_EQ(texts, expectedTexts);
+}
+
+TEST(NewickTokenizerTest, QuotedLabels) {
+    NewickTokenizer tokenizer("('A (x), y':1,'it''s':2);");
+    tokenizer.Next();
+    auto token = tokenizer.Next();
+    EXPECT_EQ(token.type, TokenType::kLabel);
+    EXPECT_EQ(token.text, "'A (x), y'");
+    EXPECT_EQ(NewickTokenizer::Unquote(token.text), "A (x), y");
+    tokenizer.Next();
+    tokenizer.Next();
+    tokenizer.Next();
+    token = tokenizer.Next();
+    EXPECT_EQ(token.text, "'it''s'");
+    EXPECT_EQ(NewickTokenizer::Unquote(token.text), "it's");
+
+    NewickTokenizer unterminatedLabel("('A:1);");
+    unterminatedLabel.Next();
+    EXPECT_THROW(unterminatedLabel.Next(), std::invalid_argument);
+    NewickTokenizer unterminated("(A[&h=1:1);");
+    unterminated.Next();
+    unterminated.Next();
+    EXPECT_THROW(unterminated.Next(), std::invalid_argument);
+}
+
+TEST(NewickTokenizerTest, ParseNumber) {
+    EXPECT_DOUBLE_EQ(NewickTokenizer::ParseNumber("0.25"), 0.25);
+    EXPECT_DOUBLE_EQ(NewickTokenizer::ParseNumber("+1e-3"), 1e-3);
+    EXPECT_DOUBLE_EQ(NewickTokenizer::ParseNumber("-2"), -2);
+    EXPECT_THROW(NewickTokenizer::ParseNumber(""), std::invalid_argument);
+    EXPECT_THROW(NewickTokenizer::ParseNumber("0.1x"), std::invalid_argument);
+    EXPECT_THROW(NewickTokenizer::ParseNumber("abc"), std::invalid_argument);
+}
+
+TEST(NewickTokenizerTest, FromNewick) {
+    std::string newick = "(('A, 1':0.1,B:0.2)[&h=1]:0.3, C:1e-1);";
+    auto tree = Tree::FromNewick(newick);
+    EXPECT_EQ(tree->LeafNodeCount(), 3);
+    EXPECT_EQ(tree->NodeFromId(0)->Name(), "A, 1");
+    EXPECT_DOUBLE_EQ(tree->LeafFromName("C")->Distance(), 0.1);
+    EXPECT_EQ(tree->Root()->ChildAt(0)->Comment(), "[&h=1]");
+
+    auto compactTree = CompactTree::FromNewick(newick);
+    EXPECT_EQ(compactTree->Name(0), "A, 1");
+    EXPECT_DOUBLE_EQ(compactTree->Distance(2), 0.1);
+
+    EXPECT_THROW(Tree::FromNewick("(A:,B:1);"), std::invalid_argument);
+    EXPECT_THROW(CompactTree::FromNewick("(A:0.1,B:x);"), std::invalid_argument);
+}
+
+TEST(NewickTokenizerTest, LabelsWithSpaces) {
+    auto tree = Tree::FromNewick("(Homo sapiens:1, B :2,C\t:3) root node;");
+    EXPECT_EQ(tree->LeafNodeCount(), 3);
+    EXPECT_EQ(tree->Root()->ChildCount(), 3);
+    EXPECT_EQ(tree->NodeFromId(0)->Name(), "Homo sapiens");
+    EXPECT_EQ(tree->NodeFromId(1)->Name(), "B");
+    EXPECT_EQ(tree->NodeFromId(2)->Name(), "C");
+    EXPECT_EQ(tree->Root()->Name(), "root node");
+    // names that need quotes are quoted when written
+    EXPECT_EQ(tree->Newick(), "('Homo sapiens':1,B:2,C:3);");
+    EXPECT_EQ(CompactTree::FromNewick("(Homo sapiens:1,B:2);")->Name(0), "Homo sapiens");
+}
+
+TEST(NewickTokenizerTest, UnquotedNames) {
+    auto tree = Tree::FromNewick("('A B':1,'it''s':2,\"C\":3)'x,y';");
+    EXPECT_EQ(tree->NodeFromId(0)->Name(), "A B");
+    EXPECT_EQ(tree->NodeFromId(1)->Name(), "it's");
+    EXPECT_EQ(tree->NodeFromId(2)->Name(), "C");
+    EXPECT_EQ(tree->Root()->Name(), "x,y");
+    EXPECT_EQ(tree->Newick(), "('A B':1,'it''s':2,C:3);");
+    EXPECT_EQ(Tree::FromNewick(tree->Newick())->NodeFromId(1)->Name(), "it's");
+}
+
+TEST(NewickTokenizerTest, Incomplete) {
+    for (std::string newick : {"(A,B,", "(A,B,);", "((A,B),C;", "(A,B));", "();"}) {
+        EXPECT_THROW(Tree::FromNewick(newick), std::invalid_argument) << newick;
+    }
+}
+
+TEST(NewickTokenizerTest, TextAfterRoot) {
+    // the root cannot have siblings or be followed by another node
+    for (std::string newick :
+         {"(A,B),C;", "(A,B)C,(D,E);", "(A,B)(C,D);", "(A,B)C D[&x]E;", "A,B;"}) {
+        EXPECT_THROW(Tree::FromNewick(newick), std::invalid_argument) << newick;
+    }
+    // nor can a node follow another node without a comma or a branch length have
+    // no node
+    for (std::string newick :
+         {"(A,(B,C)D[&x]E);", "((A,B)(C,D));", "(,A);", "(A,:1);", ":1;"}) {
+        EXPECT_THROW(Tree::FromNewick(newick), std::invalid_argument) << newick;
+    }
+    EXPECT_EQ(Tree::FromNewick("(A,B)[&R]C;")->Root()->Name(), "C");
+}
+
+TEST(NewickTokenizerTest, TextAfterSemicolon) {
+    EXPECT_EQ(Tree::FromNewick("((A,B),C); \n")->Newick(), "((A,B),C);");
+    for (std::string newick : {"(A,B);(C,D);", "((A,B),C);garbage", "(A,B);[&x=1]"}) {
+        EXPECT_THROW(Tree::FromNewick(newick), std::invalid_argument) << newick;
+    }
+}
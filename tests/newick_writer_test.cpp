@@ -0,0 +1,115 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/newick_writer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cladokit/node.hpp"
+#include "cladokit/tree.hpp"
+
+using cladokit::NewickExportOptions;
+using cladokit::NewickWriter;
+using cladokit::Node;
+using cladokit::Tree;
+
+TEST(NewickWriterTest, SameAsNodeNewick) {
+    auto tree = Tree::FromNewick(
+        "((A[&rate=0.5]:0.1,B:1e-07)ab[&rate=2]:[&b=x]0.123456789,C:12345678);",
+        std::make_shared<std::vector<std::string>>());
+    tree->Root()->ChildAt(0)->SetAnnotation("rate", 2.0);
+    tree->Root()->ChildAt(0)->SetAnnotation("count", 3);
+
+    NewickWriter writer;
+    std::string out;
+    writer.Append(*tree, out);
+    EXPECT_EQ(out, "((A:0.1,B:1e-07):0.123457,C:1.23457e+07);");
+    EXPECT_EQ(out, tree->Newick());
+
+    NewickExportOptions options;
+    options.includeInternalNodeName = true;
+    options.annotationKeys = {"rate", "count"};
+    NewickWriter annotated(options);
+    out.clear();
+    annotated.Append(*tree->Root()->ChildAt(0), out);
+    EXPECT_EQ(out, "(A:0.1,B:1e-07)ab[&rate=2.000000,count=3]:0.123457");
+    EXPECT_EQ(out, tree->Root()->ChildAt(0)->Newick(options));
+
+    // the buffer is appended to
+    annotated.Append(*tree->Root()->ChildAt(1), out);
+    EXPECT_EQ(out, "(A:0.1,B:1e-07)ab[&rate=2.000000,count=3]:0.123457C:1.23457e+07");
+
+    options.decimalPrecision = 3;
+    EXPECT_EQ(NewickWriter(options).Options().decimalPrecision, 3);
+    EXPECT_EQ(tree->Newick(options),
+              "((A:0.100,B:0.000)ab[&rate=2.000000,count=3]:0.123,C:12345678.000);");
+}
+
+TEST(NewickWriterTest, RoundTripBranchLengths) {
+    auto tree = Tree::FromNewick("((A:0.1234567891234,B:1e-300):1,C:3.5e+300);",
+                                 std::make_shared<std::vector<std::string>>());
+    NewickExportOptions options;
+    options.roundTripBranchLengths = true;
+    EXPECT_EQ(tree->Newick(options), "((A:0.1234567891234,B:1e-300):1,C:3.5e+300);");
+
+    options.decimalPrecision = 2;
+    std::string fixed = tree->Newick(options);
+    // 301 digits before the decimal point
+    EXPECT_EQ(fixed.substr(0, 26), "((A:0.12,B:0.00):1.00,C:34");
+    EXPECT_EQ(fixed.substr(24 + 301), ".00);");
+}
+
+TEST(NewickWriterTest, QuotedLabels) {
+    auto tree = Tree::FromNewick("((A:1,B:2)ab:3,C:4);",
+                                 std::make_shared<std::vector<std::string>>());
+    tree->Root()->ChildAt(0)->SetName("a, b");
+    tree->Root()->ChildAt(0)->ChildAt(1)->SetName("it's");
+    tree->Root()->ChildAt(1)->SetName("Homo sapiens");
+    NewickExportOptions options;
+    options.includeInternalNodeName = true;
+    NewickWriter writer(options);
+    std::string out;
+    writer.Append(*tree, out);
+    EXPECT_EQ(out, "((A:1,'it''s':2)'a, b':3,'Homo sapiens':4);");
+}
+
+TEST(NewickWriterTest, DeepTree) {
+    // caterpillar deep enough to overflow the stack of a recursive writer
+    const size_t leafCount = 200000;
+    auto root = std::make_shared<Node>();
+    auto node = root;
+    std::vector<std::shared_ptr<Node>> internals{root};
+    for (size_t i = 0; i + 1 < leafCount; i++) {
+        auto leaf = std::make_shared<Node>("T" + std::to_string(i));
+        leaf->SetDistance(1);
+        node->AddChild(leaf);
+        if (i + 2 < leafCount) {
+            auto child = std::make_shared<Node>();
+            child->SetDistance(0.5);
+            node->AddChild(child);
+            internals.push_back(child);
+            node = child;
+        } else {
+            auto last = std::make_shared<Node>("T" + std::to_string(i + 1));
+            node->AddChild(last);
+        }
+    }
+
+    std::ostringstream oss;
+    NewickWriter writer;
+    writer.Write(*root, oss);
+    std::string newick = oss.str();
+    EXPECT_EQ(newick.substr(0, 11), "(T0:1,(T1:1");
+    EXPECT_NE(newick.find("(T199998:1,T199999):0.5):0.5)"), std::string::npos);
+    EXPECT_EQ(std::count(newick.begin(), newick.end(), '('), leafCount - 1);
+    EXPECT_EQ(std::count(newick.begin(), newick.end(), ')'), leafCount - 1);
+
+    // release the nodes without recursion
+    for (auto &internal : internals) internal->Reset();
+}
@@ -0,0 +1,143 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+
+#include <any>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#include "cladokit/nexus.hpp"
+#include "cladokit/tree_index.hpp"
+#include "test_helpers.hpp"
+
+using cladokit::MappedNexusFile;
+using cladokit::NexusFile;
+using cladokit::NexusTreeHeader;
+using cladokit::TreeIndex;
+
+namespace {
+std::string Nexus() {
+    return cladokit::test::NexusWithTranslate({
+        "tree STATE_0 [&lnP=-10.5] = [&R] ((1:0.1,2:0.2):0.3,3:0.4);",
+        "tree STATE_10 [&lnP=-9.5] = [&R] ((1:0.2,3:0.2):0.3,2:0.4);",
+        "tree STATE_15 [&lnP=-8.5] = [&R] ((2:0.3,3:0.2):0.3,1:0.4);",
+        "tree STATE_20 [&lnP=-7.5] = [&R] ((1:0.4,2:0.2):0.3,3:0.4);",
+    });
+}
+
+bool AfterBurnin(const NexusTreeHeader &header) {
+    return header.state > 0 && header.state % 10 == 0;
+}
+}  // namespace
+
+TEST(NexusHeaderTest, ParseTreeHeader) {
+    auto header = NexusFile::ParseTreeHeader(
+        "tree STATE_12000 [&lnP=-3456.7,joint=-3401.2] = [&R] ((A:1,B:1):1,C:2);");
+    EXPECT_EQ(header.name, "STATE_12000");
+    EXPECT_EQ(header.state, 12000);
+    EXPECT_EQ(header.rooting, NexusTreeHeader::Rooting::kRooted);
+    ASSERT_EQ(header.annotations.size(), 2);
+    EXPECT_EQ(std::any_cast<std::string>(header.annotations["lnP"]), "-3456.7");
+
+    std::unordered_map<std::string, cladokit::Converter> converters{
+        {"joint", [](const std::string &value) { return std::any(std::stod(value)); }}};
+    header = NexusFile::ParseTreeHeader(
+        "tree STATE_1 [&lnP=-3456.7,joint=-3401.2] = ((A:1,B:1):1,C:2);", converters);
+    EXPECT_DOUBLE_EQ(std::any_cast<double>(header.annotations["joint"]), -3401.2);
+
+    header = NexusFile::ParseTreeHeader("TREE * 'my tree'=[&U](A,B,C);");
+    EXPECT_EQ(header.name, "my tree");
+    EXPECT_EQ(header.state, -1);
+    EXPECT_EQ(header.rooting, NexusTreeHeader::Rooting::kUnrooted);
+    EXPECT_TRUE(header.annotations.empty());
+
+    header = NexusFile::ParseTreeHeader("tree tree7=(A,B,C);");
+    EXPECT_EQ(header.name, "tree7");
+    EXPECT_EQ(header.state, 7);
+    EXPECT_EQ(header.rooting, NexusTreeHeader::Rooting::kUnknown);
+}
+
+TEST(NexusHeaderTest, Headers) {
+    std::stringstream in(Nexus());
+    NexusFile file(in);
+    auto headers = file.Headers();
+    ASSERT_EQ(headers.size(), 4);
+    EXPECT_EQ(headers[1].name, "STATE_10");
+    EXPECT_EQ(headers[3].state, 20);
+    EXPECT_EQ(std::any_cast<std::string>(headers[2].annotations["lnP"]), "-8.5");
+}
+
+TEST(NexusHeaderTest, FilterStream) {
+    std::stringstream in(Nexus());
+    NexusFile file(in);
+    file.SetTreeFilter(AfterBurnin);
+    auto trees = file.Parse();
+    ASSERT_EQ(trees.size(), 2);
+    EXPECT_EQ(trees[0]->Newick(), "((A:0.2,C:0.2):0.3,B:0.4);");
+    EXPECT_EQ(trees[1]->Newick(), "((A:0.4,B:0.2):0.3,C:0.4);");
+
+    std::stringstream in2(Nexus());
+    NexusFile iterated(in2);
+    iterated.SetTreeFilter(AfterBurnin);
+    auto tree = iterated.Next();
+    EXPECT_EQ(tree->Newick(), trees[0]->Newick());
+    EXPECT_TRUE(iterated.NextInto(*tree));
+    EXPECT_EQ(tree->Newick(), trees[1]->Newick());
+    EXPECT_FALSE(iterated.HasNext());
+}
+
+TEST(NexusHeaderTest, FilterMapped) {
+    auto path = cladokit::test::TempPath("header.trees");
+    {
+        std::ofstream out(path);
+        out << Nexus();
+    }
+    MappedNexusFile file(path);
+    file.SetTreeFilter(AfterBurnin);
+    auto trees = file.Parse();
+    ASSERT_EQ(trees.size(), 2);
+    EXPECT_EQ(trees[1]->Newick(), "((A:0.4,B:0.2):0.3,C:0.4);");
+
+    MappedNexusFile iterated(path);
+    iterated.SetTreeFilter(AfterBurnin);
+    EXPECT_EQ(iterated.Headers().size(), 2);
+
+    MappedNexusFile skipped(path);
+    skipped.SetTreeFilter(AfterBurnin);
+    skipped.SkipNext();
+    EXPECT_EQ(skipped.Next()->Newick(), trees[1]->Newick());
+    EXPECT_FALSE(skipped.HasNext());
+    std::filesystem::remove(path);
+}
+
+TEST(NexusHeaderTest, FilterIgnoredByAt) {
+    auto path = cladokit::test::TempPath("header_at.trees");
+    {
+        std::ofstream out(path);
+        out << Nexus();
+    }
+    std::ifstream in(path);
+    auto index = TreeIndex::Build(in, TreeIndex::Format::kNexus);
+
+    NexusFile file(in);
+    MappedNexusFile mapped(path);
+    for (NexusFile *filtered : {&file, static_cast<NexusFile *>(&mapped)}) {
+        filtered->SetIndex(index);
+        filtered->SetTreeFilter(AfterBurnin);
+        EXPECT_EQ(filtered->Count(), 4);
+        // trees rejected by the filter are returned by At
+        EXPECT_EQ(filtered->At(2)->Newick(), "((B:0.3,C:0.2):0.3,A:0.4);");
+        EXPECT_EQ(filtered->At(0)->Newick(), "((A:0.1,B:0.2):0.3,C:0.4);");
+        // and Next resumes with the trees accepted by the filter
+        EXPECT_EQ(filtered->Next()->Newick(), "((A:0.2,C:0.2):0.3,B:0.4);");
+        filtered->Seek(1);
+        EXPECT_EQ(filtered->Next()->Newick(), "((A:0.2,C:0.2):0.3,B:0.4);");
+        EXPECT_EQ(filtered->Next()->Newick(), "((A:0.4,B:0.2):0.3,C:0.4);");
+        EXPECT_FALSE(filtered->HasNext());
+    }
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,117 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/nexus_writer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cladokit/nexus.hpp"
+#include "cladokit/taxon_set.hpp"
+#include "cladokit/tree.hpp"
+#include "test_helpers.hpp"
+
+using cladokit::NexusFile;
+using cladokit::NexusWriter;
+using cladokit::TaxonSet;
+using cladokit::Tree;
+using cladokit::test::RandomTrees;
+using cladokit::test::TaxonNames;
+
+TEST(NexusWriterTest, Translate) {
+    auto taxa = std::make_shared<TaxonSet>(std::vector<std::string>{"A", "B", "C"});
+    auto tree = Tree::FromNewick("((A:0.1,C:0.2):0.3,B:0.4);", taxa,
+                                 cladokit::NewickParseOptions());
+    std::stringstream out;
+    {
+        NexusWriter writer(out, taxa);
+        writer.Write(*tree);
+        writer.Write(*tree, "second");
+        EXPECT_EQ(writer.TreeCount(), 2);
+    }
+    EXPECT_EQ(out.str(),
+              "#NEXUS\n\n"
+              "Begin taxa;\n\tDimensions ntax=3;\n"
+              "\tTaxlabels\n\t\tA\n\t\tB\n\t\tC\n\t\t;\n"
+              "End;\n\n"
+              "Begin trees;\n\tTranslate\n\t\t1 A,\n\t\t2 B,\n\t\t3 C\n\t\t;\n"
+              "tree tree_1 = [&R] ((1:0.1,3:0.2):0.3,2:0.4);\n"
+              "tree second = [&R] ((1:0.1,3:0.2):0.3,2:0.4);\n"
+              "End;\n");
+}
+
+TEST(NexusWriterTest, ReadBack) {
+    auto trees = RandomTrees(300, TaxonNames(20, "taxon_number_"));
+    std::stringstream out;
+    NexusWriter writer(out, trees[0]->Taxa());
+    writer.SetThreadCount(4);
+    writer.Write(trees);
+    writer.Close();
+    EXPECT_THROW(writer.Write(*trees[0]), std::logic_error);
+
+    NexusFile file(out);
+    auto read = file.Parse();
+    ASSERT_EQ(read.size(), trees.size());
+    for (size_t i = 0; i < trees.size(); i++) {
+        EXPECT_EQ(read[i]->Newick(), trees[i]->Newick());
+    }
+
+    // same output whatever the number of threads
+    std::stringstream serial;
+    NexusWriter serialWriter(serial, trees[0]->Taxa());
+    for (const auto &tree : trees) {
+        serialWriter.Write(*tree);
+    }
+    serialWriter.Close();
+    EXPECT_EQ(serial.str(), out.str());
+
+    std::stringstream newick;
+    for (const auto &tree : trees) {
+        newick << tree->Newick() << '\n';
+    }
+    EXPECT_LT(out.str().size() * 2, newick.str().size());
+}
+
+TEST(NexusWriterTest, OtherTaxonSet) {
+    auto taxa = std::make_shared<TaxonSet>(std::vector<std::string>{"A", "B", "C"});
+    auto tree = Tree::FromNewick("((C:1,B:1):1,A:1);");
+    std::stringstream out;
+    NexusWriter writer(out, taxa);
+    writer.Write(*tree);
+    EXPECT_NE(out.str().find("tree tree_1 = [&R] ((3:1,2:1):1,1:1);"), std::string::npos);
+
+    auto other = Tree::FromNewick("((C:1,D:1):1,A:1);");
+    EXPECT_THROW(writer.Write(*other), std::invalid_argument);
+}
+
+TEST(NexusWriterTest, QuotedLabels) {
+    std::vector<std::string> names{"Homo sapiens", "it's", "A,B", "C"};
+    auto taxa = std::make_shared<TaxonSet>(names);
+    auto tree = Tree::FromNewick("(('Homo sapiens':1,'it''s':1):1,('A,B':1,C:1):1);",
+                                 taxa, cladokit::NewickParseOptions());
+    std::stringstream out;
+    {
+        NexusWriter writer(out, taxa);
+        writer.Write(*tree, "first tree");
+    }
+    EXPECT_NE(out.str().find("\t\t1 'Homo sapiens',\n\t\t2 'it''s',\n\t\t3 'A,B',\n"),
+              std::string::npos);
+    EXPECT_NE(out.str().find("tree 'first tree' = [&R] "), std::string::npos);
+
+    NexusFile file(out);
+    auto headers = file.Headers();
+    ASSERT_EQ(headers.size(), 1);
+    EXPECT_EQ(headers[0].name, "first tree");
+    out.clear();
+    out.seekg(0);
+    NexusFile reader(out);
+    auto read = reader.Parse();
+    ASSERT_EQ(read.size(), 1);
+    EXPECT_EQ(*read[0]->TaxonNames(), names);
+    EXPECT_EQ(read[0]->Newick(), tree->Newick());
+}
@@ -0,0 +1,110 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/node_arena.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cladokit/newick.hpp"
+#include "cladokit/tree.hpp"
+
+using cladokit::MakeNode;
+using cladokit::NewickFile;
+using cladokit::NodeArena;
+using cladokit::Tree;
+
+TEST(NodeArenaTest, AllocateNodes) {
+    auto arena = std::make_shared<NodeArena>(1024);
+    auto root = MakeNode(arena, "root");
+    auto child = MakeNode(arena, "child");
+    root->AddChild(child);
+
+    EXPECT_EQ(arena->AllocationCount(), 2);
+    EXPECT_EQ(arena->SlabCount(), 1);
+    EXPECT_EQ(child->Parent(), root);
+
+    child.reset();
+    EXPECT_EQ(arena->DeallocationCount(), 0);
+    root.reset();
+    EXPECT_EQ(arena->DeallocationCount(), 2);
+    EXPECT_EQ(arena->BytesInUse(), 0);
+}
+
+TEST(NodeArenaTest, ArenaOutlivesHandle) {
+    auto arena = std::make_shared<NodeArena>(256);
+    std::weak_ptr<NodeArena> weakArena = arena;
+    auto taxonNames = std::make_shared<std::vector<std::string>>();
+    auto tree = Tree::FromNewick("(((A:1,B:2):3,C:4):5,D:6);", taxonNames, arena);
+
+    EXPECT_EQ(arena->AllocationCount(), 7);
+    EXPECT_GT(arena->SlabCount(), 1);
+
+    // the nodes keep the arena alive
+    arena.reset();
+    EXPECT_FALSE(weakArena.expired());
+    EXPECT_EQ(tree->Newick(), "(((A:1,B:2):3,C:4):5,D:6);");
+    tree.reset();
+    EXPECT_TRUE(weakArena.expired());
+}
+
+TEST(NodeArenaTest, NewickFile) {
+    std::istringstream in("((A:1,B:2):3,C:4);\n((A:1,C:2):3,B:4);\n");
+    NewickFile file(in);
+    auto arena = std::make_shared<NodeArena>();
+    file.SetNodeArena(arena);
+    auto trees = file.Parse();
+
+    ASSERT_EQ(trees.size(), 2);
+    EXPECT_EQ(arena->AllocationCount(), 10);
+    EXPECT_EQ(trees[1]->Newick(), "((A:1,C:2):3,B:4);");
+}
+
+TEST(NodeArenaTest, StreamedTreesReleaseSlabs) {
+    std::string content;
+    for (int i = 0; i < 500; i++) {
+        content += "(((A:1,B:2):3,C:4):5,(D:6,E:7):8);\n";
+    }
+    std::istringstream in(content);
+    NewickFile file(in);
+    auto arena = std::make_shared<NodeArena>(1024);
+    file.SetNodeArena(arena);
+
+    // only the slabs of the trees alive are kept
+    size_t maxSlabCount = 0;
+    std::shared_ptr<Tree> tree;
+    while ((tree = file.Next())) {
+        maxSlabCount = std::max(maxSlabCount, arena->SlabCount());
+    }
+    EXPECT_EQ(arena->AllocationCount(), 500 * 9);
+    // without releasing slabs the file would need hundreds of them
+    EXPECT_GT(arena->BytesAllocated(), 100 * arena->SlabSize());
+    EXPECT_LE(maxSlabCount, 8);
+    EXPECT_EQ(arena->BytesInUse(), 0);
+    EXPECT_EQ(arena->SlabCount(), 1);
+}
+
+TEST(NodeArenaTest, FreeOnOtherThreads) {
+    auto arena = std::make_shared<NodeArena>(4096);
+    std::vector<std::shared_ptr<Tree>> trees;
+    for (int i = 0; i < 64; i++) {
+        auto taxonNames = std::make_shared<std::vector<std::string>>();
+        trees.push_back(
+            Tree::FromNewick("(((A:1,B:2):3,C:4):5,D:6);", taxonNames, arena));
+    }
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; t++) {
+        threads.emplace_back([&trees, t] {
+            for (size_t i = t; i < trees.size(); i += 4) trees[i].reset();
+        });
+    }
+    for (auto &thread : threads) thread.join();
+    EXPECT_EQ(arena->DeallocationCount(), arena->AllocationCount());
+    EXPECT_EQ(arena->BytesInUse(), 0);
+}
@@ -6,6 +6,8 @@
 #include <gtest/gtest.h>
 
 #include <cmath>
+#include <string>
+#include <vector>
 
 using cladokit::NewickExportOptions;
 using cladokit::Node;
@@ -182,3 +184,68 @@ TEST(NodeTest, PostOrderIterator) {
     ++it;
     EXPECT_TRUE(it == root->end_postorder());
 }
+
+TEST(NodeTest, StacklessTraversals) {
+    Node::NodePtr root = std::make_shared<Node>("Root");
+    Node::NodePtr inner = std::make_shared<Node>("Inner");
+    root->AddChild(inner);
+    root->AddChild(std::make_shared<Node>("C"));
+    inner->AddChild(std::make_shared<Node>("A"));
+    inner->AddChild(std::make_shared<Node>("B"));
+
+    std::vector<std::string> expected;
+    for (auto it = root->begin_postorder(); it != root->end_postorder(); ++it) {
+        expected.push_back((*it)->Name());
+    }
+    std::vector<std::string> names;
+    for (Node& node : root->PostOrder()) {
+        names.push_back(node.Name());
+    }
+    EXPECT_EQ(names, expected);
+
+    expected.clear();
+    names.clear();
+    for (auto it = root->begin_preorder(); it != root->end_preorder(); ++it) {
+        expected.push_back((*it)->Name());
+    }
+    for (Node& node : root->PreOrder()) {
+        names.push_back(node.Name());
+    }
+    EXPECT_EQ(names, expected);
+
+    // traversals of a subtree stay in the subtree
+    names.clear();
+    for (Node& node : inner->PostOrder()) {
+        names.push_back(node.Name());
+    }
+    EXPECT_EQ(names, std::vector<std::string>({"A", "B", "Inner"}));
+    names.clear();
+    for (Node& node : inner->PreOrder()) {
+        names.push_back(node.Name());
+    }
+    EXPECT_EQ(names, std::vector<std::string>({"Inner", "A", "B"}));
+}
+
+TEST(NodeTest, TraversalAfterChildrenChange) {
+    Node::NodePtr root = std::make_shared<Node>("Root");
+    std::vector<Node::NodePtr> leaves;
+    for (int i = 0; i < 6; i++) {
+        leaves.push_back(std::make_shared<Node>(std::to_string(i)));
+        root->AddChild(leaves.back());
+    }
+    root->RemoveChild(leaves[1]);
+    root->RemoveChild(leaves[4]);
+    root->AddChild(leaves[1]);
+    root->MakeBinary();
+
+    std::vector<std::string> names;
+    for (Node& node : root->PostOrder()) {
+        if (node.IsLeaf()) names.push_back(node.Name());
+    }
+    EXPECT_EQ(names, std::vector<std::string>({"0", "2", "3", "5", "1"}));
+    names.clear();
+    for (Node& node : root->PreOrder()) {
+        if (node.IsLeaf()) names.push_back(node.Name());
+    }
+    EXPECT_EQ(names, std::vector<std::string>({"0", "2", "3", "5", "1"}));
+}
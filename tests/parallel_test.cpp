@@ -0,0 +1,122 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/parallel.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cladokit/newick.hpp"
+#include "cladokit/nexus.hpp"
+#include "cladokit/node_arena.hpp"
+#include "test_helpers.hpp"
+
+using cladokit::NewickFile;
+using cladokit::NewickParseOptions;
+using cladokit::NexusFile;
+using cladokit::NodeArena;
+using cladokit::ParallelFor;
+using cladokit::Tree;
+using cladokit::test::RandomNewicks;
+
+TEST(ParallelTest, ParallelFor) {
+    std::vector<std::atomic<int>> visits(1000);
+    ParallelFor(visits.size(), 4, [&visits](size_t index, size_t worker) {
+        EXPECT_LT(worker, 4);
+        visits[index]++;
+    });
+    for (const auto &visit : visits) {
+        EXPECT_EQ(visit, 1);
+    }
+
+    EXPECT_THROW(ParallelFor(100, 3,
+                             [](size_t index, size_t) {
+                                 if (index == 42) throw std::runtime_error("error");
+                             }),
+                 std::runtime_error);
+}
+
+TEST(ParallelTest, NewickFile) {
+    std::string content = RandomNewicks(200, {"A", "B", "C", "D", "E", "F", "G"});
+    std::stringstream serialIn(content);
+    auto expected = NewickFile(serialIn).Parse();
+
+    std::stringstream in(content);
+    NewickFile file(in);
+    file.SetThreadCount(4);
+    file.SetNodeArena(std::make_shared<NodeArena>());
+    auto trees = file.Parse();
+    ASSERT_EQ(trees.size(), expected.size());
+    for (size_t i = 0; i < trees.size(); i++) {
+        EXPECT_EQ(trees[i]->Newick(), expected[i]->Newick());
+        EXPECT_EQ(trees[i]->Taxa(), trees[0]->Taxa());
+        EXPECT_EQ(trees[i]->LeafFromName("D")->Id(),
+                  expected[i]->LeafFromName("D")->Id());
+    }
+}
+
+TEST(ParallelTest, NexusFile) {
+    std::string content =
+        "#NEXUS\n"
+        "begin trees;\n"
+        "  translate\n"
+        "    1 A,\n"
+        "    2 B,\n"
+        "    3 C,\n"
+        "    4 D\n"
+        "  ;\n";
+    std::string newicks = RandomNewicks(100, {"1", "2", "3", "4"});
+    std::stringstream lines(newicks);
+    std::string line;
+    for (size_t i = 0; std::getline(lines, line); i++) {
+        content += "tree STATE_" + std::to_string(i) + " = [&R] " + line + "\n";
+    }
+    content += "end;\n";
+
+    std::stringstream serialIn(content);
+    auto expected = NexusFile(serialIn).Parse();
+    ASSERT_EQ(expected.size(), 100);
+
+    std::stringstream in(content);
+    NexusFile file(in);
+    NewickParseOptions options;
+    options.keepRawComments = false;
+    file.SetParseOptions(options);
+    file.SetThreadCount(3);
+    auto trees = file.Parse();
+    // the translate table of the file is not stored in the options
+    EXPECT_EQ(file.ParseOptions().translate, nullptr);
+    EXPECT_FALSE(file.ParseOptions().keepRawComments);
+    ASSERT_EQ(trees.size(), expected.size());
+    for (size_t i = 0; i < trees.size(); i++) {
+        EXPECT_EQ(trees[i]->Newick(), expected[i]->Newick());
+        EXPECT_EQ(*trees[i]->TaxonNames(), *expected[i]->TaxonNames());
+        EXPECT_EQ(trees[i]->LeafFromName("C")->Id(),
+                  expected[i]->LeafFromName("C")->Id());
+    }
+}
+
+TEST(ParallelTest, TaxonMismatch) {
+    std::string content = RandomNewicks(50, {"A", "B", "C", "D"});
+    content += "((A,B),(C,E));\n";
+    content += RandomNewicks(50, {"A", "B", "C", "D"});
+
+    // the error of a worker is reported by the calling thread
+    std::stringstream in(content);
+    NewickFile file(in);
+    file.SetThreadCount(4);
+    try {
+        file.Parse();
+        FAIL() << "expected a taxon mismatch";
+    } catch (const std::runtime_error &e) {
+        std::string message = e.what();
+        EXPECT_NE(message.find("Missing taxon name: E"), std::string::npos);
+        EXPECT_NE(message.find("Extra taxon name: D"), std::string::npos);
+    }
+}
@@ -0,0 +1,107 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/prefetching_tree_file.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cladokit/newick.hpp"
+#include "cladokit/node_arena.hpp"
+#include "test_helpers.hpp"
+
+using cladokit::NewickFile;
+using cladokit::NewickParseOptions;
+using cladokit::NodeArena;
+using cladokit::PrefetchingTreeFile;
+using cladokit::Tree;
+
+namespace {
+std::string RandomTrees(size_t count) {
+    return cladokit::test::RandomNewicks(count, {"A", "B", "C", "D", "E", "F"});
+}
+
+// Newick file failing when it reaches a tree.
+class FailingFile : public NewickFile {
+   public:
+    FailingFile(std::istream &in, size_t failAt) : NewickFile(in), failAt_(failAt) {}
+
+    std::shared_ptr<Tree> Next() override {
+        if (read_++ == failAt_) {
+            throw std::runtime_error("read error");
+        }
+        return NewickFile::Next();
+    }
+
+   private:
+    size_t failAt_;
+    size_t read_ = 0;
+};
+}  // namespace
+
+TEST(PrefetchingTreeFileTest, SameTrees) {
+    std::string content = RandomTrees(50);
+    std::stringstream in(content);
+    NewickFile file(in);
+    auto expected = file.Parse();
+
+    std::stringstream in2(content);
+    PrefetchingTreeFile prefetching(std::make_shared<NewickFile>(in2), 2);
+    EXPECT_EQ(prefetching.Count(), 50);
+    auto first = prefetching.Next();
+    EXPECT_EQ(first->Newick(), expected[0]->Newick());
+    prefetching.SkipNext();
+    auto trees = prefetching.Parse();
+    ASSERT_EQ(trees.size(), 48);
+    for (size_t i = 0; i < trees.size(); i++) {
+        EXPECT_EQ(trees[i]->Newick(), expected[i + 2]->Newick());
+    }
+    EXPECT_FALSE(prefetching.HasNext());
+    EXPECT_EQ(prefetching.Next(), nullptr);
+    EXPECT_THROW(prefetching.Count(), std::logic_error);
+}
+
+TEST(PrefetchingTreeFileTest, Errors) {
+    std::stringstream in(RandomTrees(10));
+    PrefetchingTreeFile prefetching(std::make_shared<FailingFile>(in, 3));
+    for (size_t i = 0; i < 3; i++) {
+        EXPECT_NE(prefetching.Next(), nullptr);
+    }
+    EXPECT_THROW(prefetching.Next(), std::runtime_error);
+    EXPECT_FALSE(prefetching.HasNext());
+}
+
+TEST(PrefetchingTreeFileTest, StopsWhenDestroyed) {
+    std::stringstream in(RandomTrees(100));
+    auto prefetching =
+        std::make_unique<PrefetchingTreeFile>(std::make_shared<NewickFile>(in), 1);
+    EXPECT_TRUE(prefetching->HasNext());
+    // the background thread is blocked on the full queue
+    prefetching.reset();
+}
+
+TEST(PrefetchingTreeFileTest, ForwardsSettings) {
+    std::stringstream in(RandomTrees(20));
+    auto source = std::make_shared<NewickFile>(in);
+    PrefetchingTreeFile prefetching(source);
+    auto arena = std::make_shared<NodeArena>();
+    NewickParseOptions options;
+    options.keepRawComments = false;
+    prefetching.SetNodeArena(arena);
+    prefetching.SetParseOptions(options);
+    prefetching.SetThreadCount(3);
+    EXPECT_EQ(source->Arena(), arena);
+    EXPECT_FALSE(source->ParseOptions().keepRawComments);
+    EXPECT_EQ(source->ThreadCount(), 3);
+
+    EXPECT_EQ(prefetching.Parse().size(), 20);
+    EXPECT_GT(arena->AllocationCount(), 0);
+    EXPECT_THROW(prefetching.SetNodeArena(nullptr), std::logic_error);
+    EXPECT_THROW(prefetching.SetParseOptions(options), std::logic_error);
+    EXPECT_THROW(prefetching.SetThreadCount(1), std::logic_error);
+}
@@ -0,0 +1,66 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/taxon_set.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cladokit/newick.hpp"
+#include "cladokit/tree.hpp"
+
+using cladokit::NewickFile;
+using cladokit::NewickParseOptions;
+using cladokit::TaxonSet;
+using cladokit::Tree;
+
+TEST(TaxonSetTest, IndexOf) {
+    TaxonSet taxa(std::vector<std::string>{"A", "B", "C"});
+    EXPECT_EQ(taxa.Size(), 3);
+    EXPECT_EQ(taxa.IndexOf("A"), 0);
+    EXPECT_EQ(taxa.IndexOf("C"), 2);
+    EXPECT_EQ(taxa.IndexOf("D"), TaxonSet::kNotFound);
+    EXPECT_TRUE(taxa.Contains("B"));
+    EXPECT_FALSE(taxa.Contains("D"));
+    EXPECT_EQ(taxa.Name(1), "B");
+}
+
+TEST(TaxonSetTest, SharedByTrees) {
+    auto taxa = std::make_shared<TaxonSet>(std::vector<std::string>{"C", "B", "A"});
+    auto tree1 = Tree::FromNewick("((A:1,B:2):1,C:3);", taxa, NewickParseOptions());
+    auto tree2 = Tree::FromNewick("((C:1,B:2):1,A:3);", taxa, NewickParseOptions());
+
+    EXPECT_EQ(tree1->Taxa(), taxa);
+    EXPECT_EQ(tree2->Taxa(), taxa);
+    EXPECT_EQ(tree1->TaxonNames(), tree2->TaxonNames());
+    for (const auto &tree : {tree1, tree2}) {
+        for (size_t id = 0; id < tree->LeafNodeCount(); id++) {
+            EXPECT_EQ(tree->NodeFromId(id)->Name(), taxa->Name(id));
+        }
+        EXPECT_EQ(tree->LeafFromName("A")->Id(), 2);
+    }
+}
+
+TEST(TaxonSetTest, NewickFile) {
+    std::stringstream in("((A:1,B:2):1,C:3);\n((C:1,A:2):1,B:3);\n");
+    NewickFile file(in);
+    auto trees = file.Parse();
+    ASSERT_EQ(trees.size(), 2);
+    EXPECT_EQ(trees[1]->Taxa(), trees[0]->Taxa());
+    EXPECT_EQ(trees[1]->LeafFromName("B")->Id(), 1);
+    EXPECT_EQ(trees[1]->LeafFromName("C")->Id(), 2);
+}
+
+TEST(TaxonSetTest, CopiesNames) {
+    auto names = std::make_shared<std::vector<std::string>>(
+        std::vector<std::string>{"A", "B", "C"});
+    auto tree = Tree::FromNewick("((A:1,B:2):1,C:3);", names);
+    names->assign({"X", "Y"});
+    EXPECT_EQ(tree->Taxa()->IndexOf("C"), 2);
+    EXPECT_EQ(tree->Taxa()->IndexOf("X"), TaxonSet::kNotFound);
+    EXPECT_EQ(*tree->TaxonNames(), std::vector<std::string>({"A", "B", "C"}));
+}
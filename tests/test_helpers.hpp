@@ -0,0 +1,106 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cladokit/newick.hpp"
+#include "cladokit/tree.hpp"
+
+namespace cladokit::test {
+
+// Taxon names prefix0, prefix1, ...
+inline std::vector<std::string> TaxonNames(size_t count,
+                                           const std::string &prefix = "T") {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; i++) {
+        names.push_back(prefix + std::to_string(i));
+    }
+    return names;
+}
+
+// Newick strings of count random trees on taxa, one per line.
+inline std::string RandomNewicks(size_t count, const std::vector<std::string> &taxa) {
+    std::string content;
+    for (size_t i = 0; i < count; i++) {
+        content += Tree::Random(taxa)->Newick() + "\n";
+    }
+    return content;
+}
+
+// count random trees on taxa read from a NewickFile, so they share a taxon set.
+inline std::vector<std::shared_ptr<Tree>> RandomTrees(
+    size_t count, const std::vector<std::string> &taxa) {
+    std::stringstream newick(RandomNewicks(count, taxa));
+    return NewickFile(newick).Parse();
+}
+
+// count random trees on 15 taxa sharing a taxon set, with a double "rate" annotation
+// on every node, an int "count" annotation on every third node, and a name and a
+// string "label" branch annotation on every internal node.
+inline std::vector<std::shared_ptr<Tree>> AnnotatedTrees(size_t count) {
+    auto trees = RandomTrees(count, TaxonNames(15));
+    for (const auto &tree : trees) {
+        for (const auto &node : tree->Nodes()) {
+            node->SetAnnotation("rate", 0.25 * node->Id());
+            if (node->Id() % 3 == 0) node->SetAnnotation("count", int(node->Id()));
+            if (!node->IsLeaf()) {
+                node->SetName("n" + std::to_string(node->Id()));
+                node->SetBranchAnnotation("label", node->Name());
+            }
+        }
+    }
+    return trees;
+}
+
+// Tree statements over the tokens of kTranslate.
+inline const std::vector<std::string> kTranslatedTrees = {
+    "tree STATE_0 = [&R] ((1:0.1,2:0.2):0.3,3:0.4);",
+    "tree STATE_1 = [&R] ((3:0.1,2:0.2):0.3,1:0.4);",
+    "tree STATE_2 = [&R] ((2:0.1,3:0.2):0.3,1:0.4);",
+};
+
+inline const std::vector<std::pair<std::string, std::string>> kTranslate = {
+    {"1", "A"}, {"2", "B"}, {"3", "C"}};
+
+// Nexus file made of blocks followed by a trees block with a translate command and
+// one tree statement per line.
+inline std::string NexusWithTranslate(
+    const std::vector<std::string> &statements = kTranslatedTrees,
+    const std::vector<std::pair<std::string, std::string>> &translate = kTranslate,
+    const std::string &blocks = "") {
+    std::string content = "#NEXUS\n" + blocks + "begin trees;\n  translate\n";
+    for (size_t i = 0; i < translate.size(); i++) {
+        content += "    " + translate[i].first + " " + translate[i].second;
+        content += i + 1 < translate.size() ? ",\n" : "\n";
+    }
+    content += "  ;\n";
+    for (const auto &statement : statements) {
+        content += statement + "\n";
+    }
+    return content + "end;\n";
+}
+
+// Path of a file of the temporary directory named after the current test, the process
+// and name, so tests running in parallel do not share files. name ends the file name
+// so its extension is kept.
+inline std::filesystem::path TempPath(const std::string &name) {
+    static const std::string process = std::to_string(std::random_device()());
+    const auto *test = ::testing::UnitTest::GetInstance()->current_test_info();
+    std::string prefix = "cladokit_";
+    if (test) {
+        prefix += std::string(test->test_suite_name()) + "_" + test->name() + "_";
+    }
+    return std::filesystem::temp_directory_path() / (prefix + process + "_" + name);
+}
+}  // namespace cladokit::test
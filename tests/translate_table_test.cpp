@@ -0,0 +1,77 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/translate_table.hpp"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cladokit/nexus.hpp"
+#include "cladokit/tree.hpp"
+#include "test_helpers.hpp"
+
+using cladokit::NexusFile;
+using cladokit::TaxonSet;
+using cladokit::TranslateTable;
+using cladokit::Tree;
+
+namespace {
+std::string Nexus() {
+    return cladokit::test::NexusWithTranslate(
+        {"tree STATE_0 = [&R] (((1:0.1,d:0.5):0.2,2:0.2):0.3,3:0.4);",
+         "tree STATE_1 = [&R] ((3:0.1,(d:0.5,2:0.2):0.1):0.3,1[&rate=2]:0.4);"},
+        {{"1", "Alpha"}, {"2", "Beta"}, {"3", "Gamma"}, {"d", "Delta"}});
+}
+}  // namespace
+
+TEST(TranslateTableTest, IndexOf) {
+    auto taxa = std::make_shared<TaxonSet>(std::vector<std::string>{"A", "B", "C"});
+    std::map<std::string, std::string> translate = {
+        {"1", "C"}, {"2", "A"}, {"x", "B"}, {"3", "Z"}, {"1000", "B"}};
+    TranslateTable table(translate, taxa);
+    EXPECT_EQ(table.Taxa(), taxa);
+    EXPECT_EQ(table.IndexOf("1"), 2);
+    EXPECT_EQ(table.IndexOf("2"), 0);
+    EXPECT_EQ(table.IndexOf("x"), 1);
+    EXPECT_EQ(table.IndexOf("1000"), 1);
+    EXPECT_EQ(table.IndexOf("3"), TaxonSet::kNotFound);
+    EXPECT_EQ(table.IndexOf("01"), TaxonSet::kNotFound);
+    EXPECT_EQ(table.IndexOf("4"), TaxonSet::kNotFound);
+    EXPECT_EQ(table.IndexOf("C"), TaxonSet::kNotFound);
+}
+
+TEST(TranslateTableTest, NexusTreesMatchNames) {
+    std::stringstream in(Nexus());
+    NexusFile file(in);
+    auto trees = file.Parse();
+    ASSERT_EQ(trees.size(), 2);
+    const auto &tree = trees[1];
+    EXPECT_EQ(tree->Taxa(), trees[0]->Taxa());
+
+    auto expected = Tree::FromNewick(
+        "((Gamma:0.1,(Delta:0.5,Beta:0.2):0.1):0.3,Alpha[&rate=2]:0.4);",
+        trees[0]->Taxa(), cladokit::NewickParseOptions());
+    EXPECT_EQ(tree->Newick(), expected->Newick());
+    for (size_t id = 0; id < tree->LeafNodeCount(); id++) {
+        EXPECT_EQ(tree->NodeFromId(id)->Name(), tree->Taxa()->Name(id));
+    }
+    EXPECT_EQ(tree->LeafFromName("Alpha")->Comment(), "[&rate=2]");
+}
+
+TEST(TranslateTableTest, ProvidedTaxonNames) {
+    auto names = std::make_shared<std::vector<std::string>>(
+        std::vector<std::string>{"Delta", "Gamma", "Beta", "Alpha"});
+    std::stringstream in(Nexus());
+    NexusFile file(in, names);
+    auto tree = file.Next();
+    ASSERT_NE(tree, nullptr);
+    EXPECT_EQ(tree->LeafFromName("Delta")->Id(), 0);
+    EXPECT_EQ(tree->LeafFromName("Alpha")->Id(), 3);
+    EXPECT_EQ(tree->LeafFromName("Delta")->Distance(), 0.5);
+    EXPECT_EQ(*tree->TaxonNames(), *names);
+}
@@ -0,0 +1,125 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/tree_index.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "cladokit/newick.hpp"
+#include "cladokit/nexus.hpp"
+#include "test_helpers.hpp"
+
+using cladokit::MappedNexusFile;
+using cladokit::NewickFile;
+using cladokit::NexusFile;
+using cladokit::TreeIndex;
+using cladokit::test::NexusWithTranslate;
+using cladokit::test::TempPath;
+
+namespace {
+const char kNewick[] = "((A:1,B:2):1,C:3);\n\n((C:1,A:2):1,B:3);\n((B:1,C:2):1,A:3);\n";
+}  // namespace
+
+TEST(TreeIndexTest, Newick) {
+    std::stringstream in(kNewick);
+    auto index = TreeIndex::Build(in, TreeIndex::Format::kNewick);
+    ASSERT_EQ(index->Count(), 3);
+    EXPECT_EQ(index->At(1).offset, 20);
+    EXPECT_EQ(index->At(1).length, 18);
+    EXPECT_EQ(index->TranslateOffset(), TreeIndex::kNoOffset);
+    EXPECT_EQ(index->TaxonNames(), std::vector<std::string>({"A", "B", "C"}));
+
+    NewickFile file(in);
+    file.SetIndex(index);
+    EXPECT_EQ(file.Count(), 3);
+    EXPECT_EQ(file.At(2)->Newick(), "((B:1,C:2):1,A:3);");
+    EXPECT_EQ(file.At(0)->Newick(), "((A:1,B:2):1,C:3);");
+    file.Seek(1);
+    EXPECT_EQ(file.Next()->Newick(), "((C:1,A:2):1,B:3);");
+    EXPECT_EQ(file.Next()->Newick(), "((B:1,C:2):1,A:3);");
+    EXPECT_FALSE(file.HasNext());
+    EXPECT_THROW(file.Seek(3), std::out_of_range);
+
+    std::stringstream unindexedIn(kNewick);
+    NewickFile unindexed(unindexedIn);
+    EXPECT_THROW(unindexed.Seek(0), std::runtime_error);
+}
+
+TEST(TreeIndexTest, Nexus) {
+    std::stringstream in(NexusWithTranslate());
+    auto index = TreeIndex::Build(in, TreeIndex::Format::kNexus);
+    ASSERT_EQ(index->Count(), 3);
+    EXPECT_EQ(index->TranslateOffset(), 20);
+    EXPECT_EQ(index->TaxonNames(), std::vector<std::string>({"A", "B", "C"}));
+
+    NexusFile file(in);
+    file.SetIndex(index);
+    EXPECT_EQ(file.Count(), 3);
+    // the taxon names come from the index so ids do not depend on the first tree read
+    auto tree = file.At(2);
+    EXPECT_EQ(tree->Newick(), "((B:0.1,C:0.2):0.3,A:0.4);");
+    EXPECT_EQ(tree->LeafFromName("A")->Id(), 0);
+    EXPECT_EQ(file.At(0)->Newick(), "((A:0.1,B:0.2):0.3,C:0.4);");
+}
+
+TEST(TreeIndexTest, MultiLineStatements) {
+    const char nexus[] =
+        "#NEXUS\n"
+        "begin trees;\n"
+        "tree STATE_0 = [&R] ((A:0.1,\n"
+        "  B:0.2):0.3,\n"
+        "  C:0.4);\n"
+        "tree STATE_1 = [&R] ((C:0.1,B:0.2):0.3,A:0.4);\n"
+        "end;\n";
+    std::stringstream in(nexus);
+    auto index = TreeIndex::Build(in, TreeIndex::Format::kNexus);
+    ASSERT_EQ(index->Count(), 2);
+    std::string content(nexus);
+    const auto &entry = index->At(0);
+    EXPECT_EQ(content.substr(entry.offset, entry.length),
+              "tree STATE_0 = [&R] ((A:0.1,\n  B:0.2):0.3,\n  C:0.4);");
+    EXPECT_EQ(index->At(1).offset, entry.offset + entry.length + 1);
+    EXPECT_EQ(index->At(1).length, 46);
+
+    NexusFile file(in);
+    file.SetIndex(index);
+    EXPECT_EQ(file.At(1)->Newick(), "((C:0.1,B:0.2):0.3,A:0.4);");
+    EXPECT_EQ(file.At(0)->Newick(), "((A:0.1,B:0.2):0.3,C:0.4);");
+}
+
+TEST(TreeIndexTest, Sidecar) {
+    auto path = TempPath("index.trees");
+    {
+        std::ofstream out(path);
+        out << NexusWithTranslate();
+    }
+    auto sidecar = TreeIndex::SidecarPath(path);
+    std::filesystem::remove(sidecar);
+
+    auto index = TreeIndex::Open(path, TreeIndex::Format::kNexus);
+    EXPECT_TRUE(std::filesystem::exists(sidecar));
+    auto loaded = TreeIndex::Load(sidecar, path);
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(loaded->Count(), 3);
+    EXPECT_EQ(loaded->At(2).offset, index->At(2).offset);
+    EXPECT_EQ(loaded->TaxonNames(), index->TaxonNames());
+
+    MappedNexusFile file(path);
+    file.SetIndex(loaded);
+    EXPECT_EQ(file.At(1)->Newick(), "((C:0.1,B:0.2):0.3,A:0.4);");
+
+    // a modified file invalidates the index
+    {
+        std::ofstream out(path);
+        out << NexusWithTranslate() << "\n";
+    }
+    EXPECT_EQ(TreeIndex::Load(sidecar, path), nullptr);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(sidecar);
+}
@@ -0,0 +1,121 @@
+// Copyright 2025 Mathieu Fourment
+// SPDX-License-Identifier: MIT
+
+#include "cladokit/tree_log_writer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cladokit/newick.hpp"
+#include "cladokit/nexus.hpp"
+#include "cladokit/tree.hpp"
+#include "test_helpers.hpp"
+
+using cladokit::NewickFile;
+using cladokit::NexusFile;
+using cladokit::NexusTreeHeader;
+using cladokit::Tree;
+using cladokit::TreeLogFormat;
+using cladokit::TreeLogOptions;
+using cladokit::TreeLogWriter;
+using cladokit::test::AnnotatedTrees;
+using cladokit::test::TempPath;
+
+TEST(TreeLogWriterTest, Nexus) {
+    auto trees = AnnotatedTrees(50);
+    auto path = TempPath("log.trees");
+    TreeLogOptions options;
+    options.capacity = 4;
+    options.newick.annotationKeys = {"rate"};
+    {
+        TreeLogWriter logger(path, trees[0]->Taxa(), options);
+        EXPECT_EQ(logger.Capacity(), 4);
+        for (size_t i = 0; i < trees.size(); i++) {
+            logger.Log(*trees[i], static_cast<int64_t>(i * 1000));
+        }
+        // the file can be read before it is closed
+        logger.Flush();
+        std::ifstream partial(path);
+        NexusFile file(partial);
+        EXPECT_EQ(file.Parse().size(), trees.size());
+    }
+
+    std::ifstream in(path);
+    NexusFile file(in);
+    auto headers = file.Headers();
+    ASSERT_EQ(headers.size(), trees.size());
+    EXPECT_EQ(headers[3].name, "STATE_3000");
+    EXPECT_EQ(headers[3].rooting, NexusTreeHeader::Rooting::kRooted);
+
+    std::ifstream in2(path);
+    NexusFile file2(in2);
+    auto read = file2.Parse();
+    ASSERT_EQ(read.size(), trees.size());
+    for (size_t i = 0; i < trees.size(); i++) {
+        EXPECT_EQ(read[i]->Newick(), trees[i]->Newick());
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(TreeLogWriterTest, Newick) {
+    auto trees = AnnotatedTrees(20);
+    auto path = TempPath("log.nwk");
+    TreeLogOptions options;
+    options.format = TreeLogFormat::kNewick;
+    options.syncInterval = std::chrono::milliseconds(0);
+    options.newick.annotationKeys = {"rate"};
+    options.newick.decimalPrecision = 4;
+    TreeLogWriter logger(path, trees[0]->Taxa(), options);
+    for (size_t i = 0; i < trees.size(); i++) {
+        logger.Log(*trees[i], static_cast<int64_t>(i));
+    }
+    logger.Close();
+    EXPECT_THROW(logger.Log(*trees[0], 0), std::logic_error);
+
+    std::ifstream in(path);
+    std::string line;
+    for (size_t i = 0; i < trees.size(); i++) {
+        ASSERT_TRUE(std::getline(in, line));
+        EXPECT_EQ(line, trees[i]->Newick(options.newick));
+    }
+    EXPECT_FALSE(std::getline(in, line));
+
+    std::ifstream in2(path);
+    EXPECT_EQ(NewickFile(in2).Parse().size(), trees.size());
+    std::filesystem::remove(path);
+}
+
+TEST(TreeLogWriterTest, OtherTaxonSet) {
+    auto path = TempPath("log_taxa.trees");
+    auto tree = Tree::FromNewick("((A:1,B:1):1,C:1);");
+    auto other = Tree::FromNewick("((A:1,B:1):1,C:1);");
+    TreeLogWriter logger(path, tree->Taxa());
+    EXPECT_THROW(logger.Log(*other, 0), std::invalid_argument);
+    logger.Close();
+    std::filesystem::remove(path);
+}
+
+TEST(TreeLogWriterTest, Rooting) {
+    auto path = TempPath("log_rooting.trees");
+    auto rooted = Tree::FromNewick("((A:1,B:1):1,(C:1,D:1):1);");
+    auto unrooted = Tree::FromNewick("((A:1,B:1):1,C:1,D:1);", rooted->Taxa(),
+                                     cladokit::NewickParseOptions());
+    {
+        TreeLogWriter logger(path, rooted->Taxa());
+        logger.Log(*rooted, 0);
+        logger.Log(*unrooted, 1);
+    }
+    std::ifstream in(path);
+    auto headers = NexusFile(in).Headers();
+    ASSERT_EQ(headers.size(), 2);
+    EXPECT_EQ(headers[0].rooting, NexusTreeHeader::Rooting::kRooted);
+    EXPECT_EQ(headers[1].rooting, NexusTreeHeader::Rooting::kUnrooted);
+    std::filesystem::remove(path);
+}
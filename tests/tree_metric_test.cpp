@@ -5,10 +5,14 @@
 
 #include <gtest/gtest.h>
 
+#include <stdexcept>
+
 #include "cladokit/tree.hpp"
 
 using cladokit::BiPartition;
+using cladokit::GetSplitHashSet;
 using cladokit::RobinsonFouldsMetric;
+using cladokit::TopologyHash;
 using cladokit::Tree;
 using cladokit::TreeMetric;
 
@@ -42,3 +46,47 @@ TEST(TreeMetricTest, RobinsonFouldsMetric2) {
     EXPECT_DOUBLE_EQ(metric.Compute(tree1, tree1), 0.0);
     EXPECT_DOUBLE_EQ(metric.Compute(tree1, tree2), 2.0);
 }
+
+TEST(TreeMetricTest, SplitHashes) {
+    // 100 taxa: the two clades differ only in the first taxa
+    std::vector<std::string> names;
+    for (size_t i = 0; i < 100; i++) {
+        names.push_back("t" + std::to_string(i));
+    }
+    auto taxonNames = std::make_shared<std::vector<std::string>>(names);
+    auto makeNewick = [&](size_t first) {
+        std::string newick = "((" + names[first];
+        for (size_t i = 2; i < names.size(); i++) {
+            newick += "," + names[i];
+        }
+        return newick + ")," + names[1 - first] + ");";
+    };
+    auto tree1 = Tree::FromNewick(makeNewick(0), taxonNames);
+    auto tree2 = Tree::FromNewick(makeNewick(1), taxonNames);
+
+    tree1->ComputeDescendantBitset();
+    tree2->ComputeDescendantBitset();
+    tree1->ComputeSplitHashes();
+
+    auto clade1 = tree1->Root()->ChildAt(0);
+    auto clade2 = tree2->Root()->ChildAt(0);
+    EXPECT_NE(clade1->DescendantBitset().Hash(), clade2->DescendantBitset().Hash());
+    EXPECT_EQ(clade1->DescendantBitset().Hash(), clade1->SplitHash());
+
+    // hash updated by |= matches the hash computed from the bits
+    BiPartition copy(clade1->DescendantBitset().Size());
+    copy |= clade1->DescendantBitset();
+    EXPECT_EQ(copy.Hash(), clade1->SplitHash());
+
+    RobinsonFouldsMetric metric;
+    EXPECT_DOUBLE_EQ(metric.Compute(tree1, tree2), 2.0);
+    // the split hashes are not computed behind the caller's back
+    EXPECT_THROW(GetSplitHashSet(tree2), std::logic_error);
+    EXPECT_THROW(TopologyHash(tree2), std::logic_error);
+    tree2->ComputeSplitHashes();
+    EXPECT_DOUBLE_EQ(metric.Compute(GetSplitHashSet(tree1), GetSplitHashSet(tree2)), 2.0);
+    EXPECT_NE(TopologyHash(tree1), TopologyHash(tree2));
+    auto tree3 = Tree::FromNewick(makeNewick(0), taxonNames);
+    tree3->ComputeSplitHashes();
+    EXPECT_EQ(TopologyHash(tree1), TopologyHash(tree3));
+}
@@ -5,6 +5,17 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cladokit/bipartition.hpp"
+#include "cladokit/newick.hpp"
+#include "cladokit/nexus.hpp"
+
+using cladokit::BiPartition;
 using cladokit::Converter;
 using cladokit::NewickExportOptions;
 using cladokit::Tree;
@@ -58,6 +69,10 @@ TEST(TreeTest, CompareTaxonNames) {
     checkLeafIds(tree1);
     checkLeafIds(tree2);
     checkLeafIds(tree3);
+
+    EXPECT_THROW(Tree::FromNewick("((A,B),D);", taxonNames), std::runtime_error);
+    EXPECT_THROW(Tree::FromNewick("((A,B),(C,D));", taxonNames), std::runtime_error);
+    EXPECT_THROW(Tree::FromNewick("(A,B);", taxonNames), std::runtime_error);
 }
 
 TEST(TreeTest, CreateTreeFromNewickWithComments) {
@@ -138,10 +153,10 @@ TEST(TreeTest, ComputeBipartitions) {
     auto tree = Tree::FromNewick(newick, taxonNames);
 
     tree->ComputeDescendantBitset();
-    std::vector<bool> allTrue(3, true);
+    BiPartition allTrue(std::vector<bool>(3, true));
 
     EXPECT_EQ(tree->Root()->DescendantBitset(), allTrue);   // Root includes all taxa
-    EXPECT_EQ(tree->Root()->DescendantBitset().size(), 3);  // 3 leaves
+    EXPECT_EQ(tree->Root()->DescendantBitset().Size(), 3);  // 3 leaves
 }
 
 TEST(TreeTest, PostOrderIterator) {
@@ -276,3 +291,186 @@ TEST(TreeTest, MakeRooted) {
     tree->MakeRooted();
     EXPECT_EQ(tree->Newick(), "(A:0.05,(B:0.2,C:0.4):0.05);");
 }
+
+TEST(TreeTest, CachedTraversals) {
+    auto tree = Tree::FromNewick("((A:0.1,B:0.2,C:0.3):0.4,D:0.5);");
+
+    std::vector<size_t> expected;
+    for (auto it = tree->Root()->begin_postorder(); it != tree->Root()->end_postorder();
+         ++it) {
+        expected.push_back((*it)->Id());
+    }
+    EXPECT_EQ(tree->PostOrderIds(), expected);
+
+    expected.clear();
+    for (auto it = tree->Root()->begin_preorder(); it != tree->Root()->end_preorder();
+         ++it) {
+        expected.push_back((*it)->Id());
+    }
+    EXPECT_EQ(tree->PreOrderIds(), expected);
+
+    // topology changes invalidate the cache
+    tree->MakeBinary();
+    EXPECT_EQ(tree->PostOrderIds().size(), 7);
+    EXPECT_EQ(tree->PreOrderIds().size(), 7);
+    EXPECT_EQ(tree->PreOrderIds().front(), tree->Root()->Id());
+    EXPECT_EQ(tree->PostOrderIds().back(), tree->Root()->Id());
+}
+
+TEST(TreeTest, ParseOptions) {
+    std::string newick = "((A[&h=1,r=2]:0.1,B:0.2)[&h=3,r=4]:0.3,C:[&b=1,c=2]2);";
+    cladokit::NewickParseOptions options;
+    options.parseAnnotations = true;
+    options.annotationKeys = {"h", "b"};
+    options.converters = {
+        {"h", [](const std::string& val) -> std::any { return std::stod(val); }}};
+    options.keepRawComments = false;
+    auto taxonNames = std::make_shared<std::vector<std::string>>();
+    auto tree = Tree::FromNewick(newick, taxonNames, options);
+
+    auto clade = tree->Root()->ChildAt(0);
+    EXPECT_TRUE(clade->Comment().empty());
+    EXPECT_DOUBLE_EQ(clade->Annotation<double>("h"), 3);
+    EXPECT_FALSE(clade->ContainsAnnotation("r"));
+    EXPECT_DOUBLE_EQ(clade->ChildAt(0)->Annotation<double>("h"), 1);
+    EXPECT_TRUE(tree->Root()->ChildAt(1)->BranchComment().empty());
+    EXPECT_EQ(tree->Root()->ChildAt(1)->BranchAnnotation<std::string>("b"), "1");
+    EXPECT_FALSE(tree->Root()->ChildAt(1)->ContainsBranchAnnotation("c"));
+    EXPECT_EQ(tree->Newick(), "((A:0.1,B:0.2):0.3,C:2);");
+}
+
+TEST(TreeTest, IncrementalTopologyUpdates) {
+    auto tree = Tree::FromNewick("((((A:1,B:2):3,C:4):5,D:6):1,(E:1,F:1,G:1):2);");
+    tree->ComputeDescendantBitset();
+    tree->ComputeSplitHashes();
+
+    // ids, bitsets and hashes must match the ones computed from scratch
+    auto check = [&tree]() {
+        ASSERT_EQ(tree->Nodes().size(), tree->NodeCount());
+        for (size_t id = 0; id < tree->NodeCount(); id++) {
+            ASSERT_EQ(tree->NodeFromId(id)->Id(), id);
+        }
+        std::vector<BiPartition> bitsets;
+        std::vector<uint64_t> hashes;
+        for (const auto& node : tree->Nodes()) {
+            bitsets.push_back(node->DescendantBitset());
+            hashes.push_back(node->SplitHash());
+        }
+        tree->ComputeDescendantBitset();
+        tree->ComputeSplitHashes();
+        for (size_t id = 0; id < tree->NodeCount(); id++) {
+            EXPECT_EQ(bitsets[id], tree->NodeFromId(id)->DescendantBitset());
+            EXPECT_EQ(bitsets[id].Hash(),
+                      tree->NodeFromId(id)->DescendantBitset().Hash());
+            EXPECT_EQ(hashes[id], tree->NodeFromId(id)->SplitHash());
+        }
+    };
+
+    tree->ReRootAbove(tree->LeafFromName("B"));
+    EXPECT_EQ(tree->NodeCount(), 12);
+    check();
+
+    EXPECT_TRUE(tree->MakeBinary());
+    EXPECT_EQ(tree->NodeCount(), 13);
+    check();
+
+    EXPECT_TRUE(tree->MakeUnRooted());
+    EXPECT_EQ(tree->NodeCount(), 12);
+    check();
+
+    tree->MakeRooted();
+    EXPECT_EQ(tree->NodeCount(), 13);
+    check();
+
+    // the multifurcating root of an unrooted tree keeps its other children
+    tree = Tree::FromNewick("((A:1,B:1):1,(C:1,D:1):1,E:1);");
+    tree->ComputeDescendantBitset();
+    tree->ComputeSplitHashes();
+    tree->ReRootAbove(tree->LeafFromName("A"));
+    EXPECT_EQ(tree->Newick(), "(A:0.5,(B:1,((C:1,D:1):1,E:1):1):0.5);");
+    EXPECT_EQ(tree->NodeCount(), 9);
+    check();
+}
+
+TEST(TreeTest, RebuildReusesNodes) {
+    auto tree = Tree::FromNewick("((A:1,B:2)[&x=1]:3,(C:4,D:5):6);");
+    auto taxa = tree->Taxa();
+    auto leafA = tree->LeafFromName("A");
+    std::vector<cladokit::Node*> previous;
+    for (const auto& node : tree->Nodes()) {
+        previous.push_back(node.get());
+    }
+
+    cladokit::NewickParseOptions options;
+    tree->Rebuild("(((D:1,A:2):3,C:4):5,B:6);", taxa, options);
+    auto expected = Tree::FromNewick("(((D:1,A:2):3,C:4):5,B:6);", taxa, options);
+    EXPECT_EQ(tree->Newick(), expected->Newick());
+    EXPECT_EQ(tree->Taxa(), taxa);
+    EXPECT_EQ(tree->NodeCount(), 7);
+    EXPECT_EQ(tree->LeafFromName("A"), leafA);
+    EXPECT_EQ(leafA->Distance(), 2);
+    for (const auto& node : tree->Nodes()) {
+        auto it = std::find(previous.begin(), previous.end(), node.get());
+        EXPECT_NE(it, previous.end());
+    }
+    EXPECT_EQ(tree->PostOrderIds().back(), tree->Root()->Id());
+
+    // the nodes missing from a smaller tree are allocated
+    tree->Rebuild("(A:1,B:1,C:1,D:1);", taxa, options);
+    EXPECT_EQ(tree->NodeCount(), 5);
+    tree->Rebuild("((A:1,B:2):1,(C:3,D:4):1);", taxa, options);
+    EXPECT_EQ(tree->NodeCount(), 7);
+    EXPECT_EQ(tree->Newick(), "((A:1,B:2):1,(C:3,D:4):1);");
+    EXPECT_THROW(tree->Rebuild("((A,B),C);", nullptr, options), std::invalid_argument);
+}
+
+TEST(TreeTest, NextIntoTree) {
+    std::vector<std::string> taxa = {"A", "B", "C", "D", "E"};
+    std::string content;
+    for (size_t i = 0; i < 20; i++) {
+        content += Tree::Random(taxa)->Newick() + "\n";
+    }
+    std::stringstream in(content);
+    cladokit::NewickFile file(in);
+    auto expected = file.Parse();
+
+    std::stringstream in2(content);
+    cladokit::NewickFile file2(in2);
+    auto tree = file2.Next();
+    auto firstTaxa = tree->Taxa();
+    size_t count = 1;
+    while (file2.NextInto(*tree)) {
+        EXPECT_EQ(tree->Newick(), expected[count]->Newick());
+        EXPECT_EQ(tree->Taxa(), firstTaxa);
+        count++;
+    }
+    EXPECT_EQ(count, 20);
+
+    std::stringstream nexus(
+        "#NEXUS\nbegin trees;\ntranslate\n1 A,\n2 B,\n3 C\n;\n"
+        "tree t1 = ((1:1,2:2):1,3:3);\ntree t2 = ((3:1,2:2):1,1:3);\nend;\n");
+    cladokit::NexusFile nexusFile(nexus);
+    auto nexusTree = nexusFile.Next();
+    auto leafA = nexusTree->LeafFromName("A");
+    ASSERT_TRUE(nexusFile.NextInto(*nexusTree));
+    EXPECT_EQ(nexusTree->LeafFromName("A"), leafA);
+    EXPECT_EQ(leafA->Distance(), 3);
+    EXPECT_FALSE(nexusFile.NextInto(*nexusTree));
+}
+
+TEST(TreeTest, NextIntoMalformedTree) {
+    std::stringstream in("((A:1,B:2):1,C:3);\n((A:1,B:2):1,(C:3);\n");
+    cladokit::NewickFile file(in);
+    auto tree = file.Next();
+    auto taxa = tree->Taxa();
+    EXPECT_THROW(file.NextInto(*tree), std::invalid_argument);
+    // the tree is left empty and can be rebuilt
+    EXPECT_EQ(tree->Root(), nullptr);
+    EXPECT_EQ(tree->NodeCount(), 0);
+    EXPECT_TRUE(tree->Nodes().empty());
+    EXPECT_EQ(tree->Taxa(), taxa);
+    tree->Rebuild("((C:1,B:2):1,A:3);", taxa, cladokit::NewickParseOptions());
+    EXPECT_EQ(tree->NodeCount(), 5);
+    EXPECT_EQ(tree->Newick(), "((C:1,B:2):1,A:3);");
+    EXPECT_EQ(tree->LeafFromName("A")->Id(), 0);
+}
@@ -64,3 +64,16 @@ TEST(SplitTopLevelTest, SimpleCases) {
     EXPECT_EQ(result[0], "{a,b}");
     EXPECT_EQ(result[1], "{c,d}");
 }
+
+TEST(ParseCommentTest, ParsesProjectedKeys) {
+    std::string input = "[&height=1.5,rate=0.2,range={0.1,0.2},posterior=1]";
+    std::map<std::string, std::any> annotations;
+    std::unordered_map<std::string, cladokit::Converter> converters = {
+        {"rate", [](const std::string& val) -> std::any { return std::stod(val); }}};
+    cladokit::ParseRawComment(std::string_view(input), annotations, converters,
+                              {"rate", "range"});
+
+    EXPECT_EQ(annotations.size(), 2);
+    EXPECT_EQ(std::any_cast<double>(annotations["rate"]), 0.2);
+    EXPECT_EQ(std::any_cast<std::string>(annotations["range"]), "{0.1,0.2}");
+}